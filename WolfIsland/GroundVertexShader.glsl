@@ -0,0 +1,28 @@
+#version 330 core
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 uv;
+
+out vec3 uvInterpolated;
+
+uniform mat4 orthographicMatrix;
+
+// Cells are generated row by row from the first one, border cells lie outside of the board
+uniform ivec2 firstCell;
+uniform int columns;
+uniform ivec2 boardSize;
+uniform float cellSize;
+
+// Tiles of the 3x3 groups, sizes hold width, height, depth and layer
+uniform vec4 tileUvs[9];
+uniform vec4 tileSizes[9];
+
+void main()
+{
+	ivec2 cell = firstCell + ivec2(gl_InstanceID % columns, gl_InstanceID / columns);
+	ivec2 group = ivec2(greaterThanEqual(cell, ivec2(0))) + ivec2(greaterThanEqual(cell, boardSize));
+	int tile = group.y * 3 + group.x;
+
+	vec3 tilePos = vec3(vec2(cell) * cellSize, tileSizes[tile].z);
+	gl_Position = orthographicMatrix * vec4(tilePos + vec3(pos.xy * tileSizes[tile].xy, pos.z), 1.0f);
+	uvInterpolated = vec3(mix(tileUvs[tile].xy, tileUvs[tile].zw, uv), tileSizes[tile].w);
+}
@@ -0,0 +1,43 @@
+#version 330 core
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec2 uv;
+layout (location = 2) in vec4 instancePath;
+layout (location = 3) in vec3 instanceMove;
+
+out vec3 uvInterpolated;
+
+uniform mat4 orthographicMatrix;
+
+// Seconds since moves of the shown turn started
+uniform float time;
+
+// Frames hold sprites of the sheets in the array, their sizes hold width, height, depth and
+// layer. Clips hold their frames count, duration and frames, four values to a vector from
+// their first vector. Sizes of the tables are defined by the renderer.
+uniform vec4 frameUvs[FRAMES];
+uniform vec4 frameSizes[FRAMES];
+uniform vec4 clips[CLIP_VECTORS];
+
+float clipValue(int i)
+{
+	return clips[i / 4][i % 4];
+}
+
+void main()
+{
+	// Instance moves from the first position to the second one playing its move clip, then
+	// plays its idle clip
+	float duration = instanceMove.x;
+	bool moving = time < duration;
+	float progress = moving ? time / duration : 1.0f;
+	float clipTime = moving ? time : time - duration;
+
+	int clip = 4 * int(moving ? instanceMove.y : instanceMove.z);
+	int framesCount = int(clipValue(clip));
+	int key = min(int(fract(clipTime / clipValue(clip + 1)) * framesCount), framesCount - 1);
+	int frame = int(clipValue(clip + 2 + key));
+
+	vec3 framePos = vec3(mix(instancePath.xy, instancePath.zw, progress), frameSizes[frame].z);
+	gl_Position = orthographicMatrix * vec4(framePos + vec3(pos.xy * frameSizes[frame].xy, pos.z), 1.0f);
+	uvInterpolated = vec3(mix(frameUvs[frame].xy, frameUvs[frame].zw, uv), frameSizes[frame].w);
+}
@@ -1,9 +1,9 @@
 #version 330 core
-in vec2 uvInterpolated;
+in vec3 uvInterpolated;
 
 layout (location = 0) out vec4 fragmentColor;
 
-uniform sampler2D sampler;
+uniform sampler2DArray sampler;
 
 void main()
 {
@@ -2,13 +2,16 @@
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec2 uv;
 layout (location = 2) in vec3 instancePos;
+layout (location = 3) in vec2 instanceSize;
+layout (location = 4) in vec4 instanceUvs;
+layout (location = 5) in float instanceLayer;
 
-out vec2 uvInterpolated;
+out vec3 uvInterpolated;
 
 uniform mat4 orthographicMatrix;
 
 void main()
 {
-	gl_Position = orthographicMatrix * vec4(pos + instancePos, 1.0f);
-	uvInterpolated = uv;
+	gl_Position = orthographicMatrix * vec4(instancePos + vec3(pos.xy * instanceSize, pos.z), 1.0f);
+	uvInterpolated = vec3(mix(instanceUvs.xy, instanceUvs.zw, uv), instanceLayer);
 }
@@ -0,0 +1,240 @@
+#include "AnimatedObjectLayer.hpp"
+#include "SpriteArray.hpp"
+#include "SpriteSheet.hpp"
+#include "SpriteBatch.hpp"
+#include "FlipbookAnimation.hpp"
+#include "Texture.hpp"
+#include "VertexArray.hpp"
+#include "VertexBuffer.hpp"
+#include "Renderer.hpp"
+#include "Board.hpp"
+#include "GameObject.hpp"
+using namespace std;
+
+// Cells uploaded around the camera rectangle, scrolling within them doesn't upload objects
+static const glm::tvec2<int32_t> uploadedMarginCells{ 4, 4 };
+
+// Instances a new buffer has room for at least
+static const uint32_t minBufferInstances{ 256 };
+
+
+AnimatedObjectLayer::AnimatedObjectLayer()
+	: mInstancesCount{ 0 }, mMaxFrames{ 0 }, mMaxClipVectors{ 0 }, mValid{ false },
+	mFirst{ 0, 0 }, mLast{ -1, -1 }, mTurn{ 0 }, mObjectsCount{ 0 }, mTurnStart{ 0.0 },
+	mMoving{ false }
+{
+}
+
+AnimatedObjectLayer::AnimatedObjectLayer(shared_ptr<const SpriteArray> sprites,
+	Renderer& renderer)
+	: mInstancesCount{ 0 }, mMaxFrames{ 0 }, mMaxClipVectors{ 0 }, mValid{ false },
+	mFirst{ 0, 0 }, mLast{ -1, -1 }, mTurn{ 0 }, mObjectsCount{ 0 }, mTurnStart{ 0.0 },
+	mMoving{ false }
+{
+	create(sprites, renderer);
+}
+
+void AnimatedObjectLayer::create(shared_ptr<const SpriteArray> sprites, Renderer& renderer)
+{
+	mSprites = sprites;
+	mQuad = SpriteBatch::CreateQuad(renderer);
+	mInstanceBuffer.reset();
+	mVao.reset();
+	mInstances.clear();
+	mInstancesCount = 0;
+	mClips.clear();
+	mFrameUvs.clear();
+	mFrameSizes.clear();
+	mClipIndices.clear();
+	mSheetFrames.clear();
+	invalidate();
+
+	// Frames take a vector of uvs and one of sizes, clips get the vectors left
+	auto vectors = renderer.getAnimatedTableVectors();
+	mMaxFrames = sprites->getSheetSpritesCount();
+
+	if (2 * mMaxFrames >= vectors)
+		throw AnimatedTablesException();
+
+	mMaxClipVectors = vectors - 2 * mMaxFrames;
+	renderer.createAnimatedProgram(mMaxFrames, mMaxClipVectors);
+}
+
+AnimatedObjectLayer::~AnimatedObjectLayer()
+{
+}
+
+bool AnimatedObjectLayer::update(Board& board, const glm::tvec2<int32_t>& first,
+	const glm::tvec2<int32_t>& last, double time, Renderer& renderer)
+{
+	// Objects of a turn in progress have moved partly, the last upload is kept until it ends
+	if (mValid && board.isTurnInProgress())
+		return false;
+
+	bool covered = first.x >= mFirst.x && first.y >= mFirst.y && last.x <= mLast.x &&
+		last.y <= mLast.y;
+	bool turnChanged = !mValid || board.getTurn() != mTurn;
+
+	if (covered && !turnChanged && board.getObjects().size() == mObjectsCount)
+		return false;
+
+	if (turnChanged)
+	{
+		mMoving = mValid && board.getTurn() == mTurn + 1;
+		mTurn = board.getTurn();
+		mTurnStart = time;
+	}
+
+	if (!mValid || !covered)
+	{
+		mFirst = first - uploadedMarginCells;
+		mLast = last + uploadedMarginCells;
+	}
+
+	mObjectsCount = board.getObjects().size();
+	mValid = true;
+
+	// Static objects are drawn with the ground and add nothing
+	mObjects.clear();
+	board.getObjects(mFirst, mLast, mObjects);
+
+	for (auto obj : mObjects)
+		obj->draw(*this);
+
+	mInstancesCount = mInstances.size();
+
+	if (!mInstances.empty())
+	{
+		if (!mInstanceBuffer || mInstanceBuffer->getElementsCount() < mInstancesCount)
+		{
+			uint32_t size = max(mInstancesCount, minBufferInstances);
+
+			if (mInstanceBuffer)
+				size = max(size, 2 * mInstanceBuffer->getElementsCount());
+
+			mInstanceBuffer = make_shared<VertexBuffer<AnimatedInstanceVertexLayout>>(size,
+				renderer, VertexBufferUsage::DYNAMIC);
+			mVao = make_shared<VertexArray>(mQuad, mInstanceBuffer, renderer);
+		}
+
+		mInstanceBuffer->add(mInstances, 0, renderer);
+		mInstances.clear();
+	}
+
+	return true;
+}
+
+void AnimatedObjectLayer::add(const FlipbookAnimation& move, const FlipbookAnimation& idle,
+	const glm::vec2& from, const glm::vec2& to, float transitionTime)
+{
+	auto moveClip = getClip(move);
+	auto idleClip = getClip(idle);
+
+	// Turns shown at rest leave objects where their moves ended
+	bool moving = mMoving && from != to && transitionTime > 0.0f;
+	auto start = moving ? from : to;
+
+	mInstances.push_back(AnimatedInstanceVertexLayout::Data{ start.x, start.y, to.x, to.y,
+		moving ? transitionTime : 0.0f, static_cast<float>(moveClip),
+		static_cast<float>(idleClip) });
+}
+
+void AnimatedObjectLayer::draw(double time, Renderer& renderer)
+{
+	if (mInstancesCount == 0)
+		return;
+
+	auto texture = mSprites->getTexture().lock();
+	auto vao = mVao;
+	auto count = mInstancesCount;
+	auto clipTime = static_cast<float>(time - mTurnStart);
+
+	// Tables don't change until the next update, the queue is flushed before it
+	renderer.submit(renderer.getQueueKey(RenderLayer::OBJECTS,
+		Renderer::Program::SPRITE_ANIMATED, *texture, 0.0f),
+		[this, texture, vao, count, clipTime](Renderer& renderer)
+		{
+			renderer.prepareDrawSpriteAnimated();
+			renderer.drawAnimatedSprites(*vao, *texture, count, clipTime, mClips, mFrameUvs,
+				mFrameSizes);
+		});
+}
+
+void AnimatedObjectLayer::invalidate()
+{
+	mValid = false;
+}
+
+uint32_t AnimatedObjectLayer::getInstancesCount() const
+{
+	return mInstancesCount;
+}
+
+uint32_t AnimatedObjectLayer::getClip(const FlipbookAnimation& animation)
+{
+	auto key = make_tuple(&animation.getSpriteSheet(), animation.getDuration(),
+		animation.getKeyFrames());
+	auto it = mClipIndices.find(key);
+
+	if (it != end(mClipIndices))
+		return it->second;
+
+	auto& sheet = animation.getSpriteSheet();
+	auto& frames = animation.getKeyFrames();
+
+	if (frames.empty() || animation.getDuration() <= 0.0)
+		throw AnimatedTablesException();
+
+	// Frames count and duration come before the frames, the last vector is padded
+	vector<float> values{ static_cast<float>(frames.size()),
+		static_cast<float>(animation.getDuration()) };
+	auto first = getSheetFrames(sheet);
+
+	for (auto frame : frames)
+	{
+		if (frame >= sheet.getSpritesCount())
+			throw AnimatedTablesException();
+
+		values.push_back(static_cast<float>(first + frame));
+	}
+
+	values.resize((values.size() + 3) / 4 * 4, 0.0f);
+
+	if (mClips.size() + values.size() / 4 > mMaxClipVectors)
+		throw AnimatedTablesException();
+
+	auto clip = static_cast<uint32_t>(mClips.size());
+
+	for (size_t i = 0; i < values.size(); i += 4)
+		mClips.push_back(glm::vec4{ values[i], values[i + 1], values[i + 2], values[i + 3] });
+
+	mClipIndices.emplace(key, clip);
+	return clip;
+}
+
+uint32_t AnimatedObjectLayer::getSheetFrames(const SpriteSheet& sheet)
+{
+	auto it = mSheetFrames.find(&sheet);
+
+	if (it != end(mSheetFrames))
+		return it->second;
+
+	auto first = static_cast<uint32_t>(mFrameUvs.size());
+	SpriteInstanceVertexLayout::Data instance;
+
+	// Sheets of the array fit the frames, other ones have no instances
+	for (uint32_t i = 0; i < sheet.getSpritesCount(); i++)
+	{
+		if (mFrameUvs.size() >= mMaxFrames ||
+			!mSprites->getInstance(sheet, i, glm::vec2{ 0.0f, 0.0f }, instance))
+			throw AnimatedTablesException();
+
+		mFrameUvs.push_back(glm::vec4{ instance.u0, instance.v0, instance.u1, instance.v1 });
+		mFrameSizes.push_back(glm::vec4{ instance.width, instance.height, instance.z,
+			instance.layer });
+	}
+
+	mSheetFrames.emplace(&sheet, first);
+	return first;
+}
+
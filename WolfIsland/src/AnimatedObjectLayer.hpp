@@ -0,0 +1,97 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "VertexLayout.hpp"
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <map>
+
+template <typename T>
+class VertexBuffer;
+
+class AnimatedTablesException : public std::exception
+{
+	virtual const char* what() const noexcept
+	{
+		return "Clip doesn't fit tables of the animated layer or its sheet isn't in the array.";
+	}
+};
+
+// Moving objects around the camera drawn with one instanced draw. Instances hold moves of
+// the shown turn with the clips played during and after them, the shader interpolates
+// positions and picks frames, so instances are uploaded once per turn. They're uploaded again
+// when objects are added or removed between turns or the camera leaves the cells they cover.
+// Clips and frames are tables of the shader. Frames have room for sprites of all sheets in
+// the array, clips take the rest of the uniforms, both are filled as objects use them.
+class AnimatedObjectLayer
+{
+public:
+	AnimatedObjectLayer();
+
+	AnimatedObjectLayer(std::shared_ptr<const class SpriteArray> sprites,
+		class Renderer& renderer);
+
+	// Compiles the renderer's animated sprite program with tables sized for the sheets of the
+	// array. Throws AnimatedTablesException when their frames don't fit uniforms of the
+	// renderer.
+	void create(std::shared_ptr<const class SpriteArray> sprites, class Renderer& renderer);
+
+	~AnimatedObjectLayer();
+
+	// Uploads objects around the rectangle, corners included, when the board finished a turn,
+	// changed its objects or the rectangle isn't covered, and returns true if it did. Moves
+	// start when their turn is uploaded first, turns restored from the timeline other than
+	// the next one are shown at rest. Turns in progress keep the last upload.
+	bool update(class Board& board, const glm::tvec2<std::int32_t>& first,
+		const glm::tvec2<std::int32_t>& last, double time, class Renderer& renderer);
+
+	// Called by objects being uploaded with positions in pixels, objects at rest pass equal
+	// ones. Throws AnimatedTablesException for clips which don't fit the tables, have no
+	// frames or duration, or whose sheets aren't in the array.
+	void add(const class FlipbookAnimation& move, const class FlipbookAnimation& idle,
+		const glm::vec2& from, const glm::vec2& to, float transitionTime);
+
+	// Queues the instances on the objects layer, played at the time
+	void draw(double time, class Renderer& renderer);
+
+	// The next update uploads objects, moves of the shown turn aren't played again
+	void invalidate();
+
+	// Objects of the last upload
+	std::uint32_t getInstancesCount() const;
+
+private:
+	std::shared_ptr<const class SpriteArray> mSprites;
+	std::shared_ptr<VertexBuffer<TextureVertexLayout>> mQuad;
+	std::shared_ptr<VertexBuffer<AnimatedInstanceVertexLayout>> mInstanceBuffer;
+	std::shared_ptr<class VertexArray> mVao;
+	std::vector<AnimatedInstanceVertexLayout::Data> mInstances;
+	std::uint32_t mInstancesCount;
+	std::vector<class GameObject*> mObjects;
+
+	// Tables of the shader, clips are found by their sheet, duration and frames and indexed
+	// by their first vector. Sprites of a sheet are added to frames when its first clip is.
+	std::vector<glm::vec4> mClips;
+	std::vector<glm::vec4> mFrameUvs;
+	std::vector<glm::vec4> mFrameSizes;
+	std::map<std::tuple<const class SpriteSheet*, double, std::vector<std::uint32_t>>,
+		std::uint32_t> mClipIndices;
+	std::map<const class SpriteSheet*, std::uint32_t> mSheetFrames;
+	std::uint32_t mMaxFrames;
+	std::uint32_t mMaxClipVectors;
+
+	// Cells and turn of the upload
+	bool mValid;
+	glm::tvec2<std::int32_t> mFirst;
+	glm::tvec2<std::int32_t> mLast;
+	std::uint32_t mTurn;
+	std::size_t mObjectsCount;
+	double mTurnStart;
+	bool mMoving;
+
+	// Registers the clip with its frames when it's used first
+	std::uint32_t getClip(const class FlipbookAnimation& animation);
+
+	// First frame of the sheet's sprites
+	std::uint32_t getSheetFrames(const class SpriteSheet& sheet);
+};
+
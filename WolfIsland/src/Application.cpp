@@ -1,9 +1,5 @@
 #include "Application.hpp"
-#include "WolfMale.hpp"
-#include "WolfFemale.hpp"
-#include "Hare.hpp"
-#include "Boulder.hpp"
-#include "Bush.hpp"
+#include "GameObject.hpp"
 #include <glm/gtx/transform.hpp>
 using namespace std;
 
@@ -12,6 +8,23 @@ static const int openglVersionMinor{ 3 };
 static const float cameraMoveVelocity{ 100.0f };
 static const float cameraZoomUnit{ 0.1f };
 static const float tourTime{ 3.0f };
+
+// Time of a frame given to the board turn, a longer turn is continued in next frames
+static const double turnSliceTime{ 0.004 };
+
+// Fixed logic steps run in a frame at most, time beyond them is dropped
+static const uint32_t maxLogicSteps{ 5 };
+
+// Time between shown turns while a scrubbing key is held
+static const float scrubStepTime{ 0.15f };
+
+// Cells around the camera rectangle drawn as well, sprites overlap neighbouring cells and
+// objects are looked up by positions saved before their move
+static const int32_t cullingMarginCells{ 2 };
+
+// Below this zoom animals are a few pixels large, cells show their density instead
+static const float heatmapZoom{ 0.45f };
+
 static const glm::vec3 oceanColorMin{ 19 / 256.0f, 27 / 256.0f, 50 / 256.0f };
 static const glm::vec3 oceanColorMax{ 21 / 256.0f, 45 / 256.0f, 69 / 256.0f };
 static const float colorChangeVelocity{ 1.0f };
@@ -28,16 +41,22 @@ const float Application::spriteSize{ 48.0f };
 random_device Application::randomDev;
 
 Application::Application()
-	: mWnd{ nullptr }, mIsGlfw{ false }, mTourTimer{ 0.0f }, mCameraMoveMultiplier{ 1.0f },
-	mState{ State::MENU }, mColorChange{ 0.0f }, mObjectAlreadySpawned{ false },
+	: mWnd{ nullptr }, mIsGlfw{ false }, mTourTimer{ 0.0f }, mTurnRequested{ false },
+	mScrubbing{ false }, mScrubDirection{ 0 }, mScrubTimer{ 0.0f }, mCameraMoveMultiplier{ 1.0f },
+	mState{ State::MENU }, mColorChange{ 0.0f }, mAnimationTime{ 0.0 }, mDrawnSprites{ 0 },
+	mCachedSprites{ 0 }, mCulledSprites{ 0 }, mOverlayShown{ false },
+	mObjectAlreadySpawned{ false }, mOverlayKeyDown{ false },
 	mSpawnObjectTypeKey{ 'n' }, mMouseLastState{ false }
 {
 }
 
 Application::Application(const std::string& windowTitle, const glm::tvec2<int32_t>& dimensions,
 	bool fullscreen)
-	: mWnd{ nullptr }, mIsGlfw{ false }, mTourTimer{ 0.0f }, mCameraMoveMultiplier{ 1.0f },
-	mState{ State::MENU }, mColorChange{ 0.0f }, mObjectAlreadySpawned{ false }, 
+	: mWnd{ nullptr }, mIsGlfw{ false }, mTourTimer{ 0.0f }, mTurnRequested{ false },
+	mScrubbing{ false }, mScrubDirection{ 0 }, mScrubTimer{ 0.0f }, mCameraMoveMultiplier{ 1.0f },
+	mState{ State::MENU }, mColorChange{ 0.0f }, mAnimationTime{ 0.0 }, mDrawnSprites{ 0 },
+	mCachedSprites{ 0 }, mCulledSprites{ 0 }, mOverlayShown{ false },
+	mObjectAlreadySpawned{ false }, mOverlayKeyDown{ false }, 
 	mSpawnObjectTypeKey{ 'n' }, mMouseLastState{ false }
 {
 	init(windowTitle, dimensions, fullscreen);
@@ -67,10 +86,13 @@ void Application::init(const std::string& windowTitle, const glm::tvec2<int32_t>
 	glfwMakeContextCurrent(mWnd);
 	glfwSwapInterval(0);
 	mRenderer.init();
+
+#ifdef _DEBUG
+	mRenderer.setValidation(true);
+#endif
 	mRenderer.setViewport(glm::tvec2<int32_t>{ dimensions.x, dimensions.y });
 	gl::ClearColor(oceanColorMin.r, oceanColorMin.g, oceanColorMin.b, 1.0f);
-	gl::Enable(gl::BLEND);
-	gl::BlendFunc(gl::SRC_ALPHA, gl::ONE_MINUS_SRC_ALPHA);
+	mRenderer.setBlending(true);
 
 	// Create font
 	mFnt = make_shared<Font>(fontPath, 18, 
@@ -78,48 +100,61 @@ void Application::init(const std::string& windowTitle, const glm::tvec2<int32_t>
 
 	// Create Text vbo and vao
 	mVaoText = make_shared<VertexArray>(
-		make_shared<VertexBuffer<TextVertexLayout>>(1024 * 1024, mRenderer), mRenderer);
+		make_shared<VertexBuffer<TextVertexLayout>>(1024 * 1024, mRenderer,
+			VertexBufferUsage::DYNAMIC), mRenderer);
 	
 	// Create Sprite vbo and vao
 	mVaoSprite = make_shared<VertexArray>(
 		make_shared<VertexBuffer<TextureVertexLayout>>(1024, mRenderer), mRenderer);
-	mVaoSpriteInstanced = make_shared<VertexArray>(
-		make_shared<VertexBuffer<TextureVertexLayout>>(1024, mRenderer), mRenderer);
-
-	// Resources
-	setupWolfMaleSpriteSheet();
-	setupWolfFemaleSpriteSheet();
-	setupHareSpriteSheet();
-	setupBoardSpriteSheet();
-	setupGuiSpriteSheet();
 
-	// Boulder sprite
-	{
-		Image spriteImg;
-		ifstream spriteFile{ boulderSpritePath, ios_base::binary };
-		PngCodec{}.decode(spriteFile, spriteImg);
-		shared_ptr<Texture> spriteTex = make_shared<Texture>(spriteImg, mRenderer);
-		spriteTex->generateMipmaps(mRenderer);
-
-		glm::vec2 spriteSize{ Application::spriteSize, Application::spriteSize };
-		
-		mBoulderSprite = make_shared<Sprite>(spriteSize, glm::vec2{ 0.0f, 0.0f }, 
-			glm::vec2{ 1.0f, 1.0f }, 0.0f, spriteTex, mVaoSprite, mRenderer);
-	}
+	// Resources, images are decoded by jobs and textures are created on the main thread
+	// as soon as their image is ready
+	mJobs.create(JobSystem::GetDefaultWorkers());
+	mBoard.setJobSystem(&mJobs);
+	vector<JobHandle> resources;
 
-	// Bush sprite
+	auto loadImage = [this, &resources](const string& path,
+		void (Application::*setup)(const Image&))
 	{
-		Image spriteImg;
-		ifstream spriteFile{ bushSpritePath, ios_base::binary };
-		PngCodec{}.decode(spriteFile, spriteImg);
-		shared_ptr<Texture> spriteTex = make_shared<Texture>(spriteImg, mRenderer);
-		spriteTex->generateMipmaps(mRenderer);
-
-		glm::vec2 spriteSize{ Application::spriteSize, Application::spriteSize };
-
-		mBushSprite = make_shared<Sprite>(spriteSize, glm::vec2{ 0.0f, 0.0f },
-			glm::vec2{ 1.0f, 1.0f }, 0.0f, spriteTex, mVaoSprite, mRenderer);
-	}
+		auto image = make_shared<Image>();
+		auto decode = mJobs.add([image, path]()
+			{
+				ifstream file{ path, ios_base::binary };
+				PngCodec{}.decode(file, *image);
+			});
+
+		resources.push_back(mJobs.add([this, image, setup]() { (this->*setup)(*image); },
+			{ decode }, JobAffinity::MAIN));
+
+		return image;
+	};
+
+	auto wolfMaleImage = loadImage(wolfMaleSpriteSheetPath,
+		&Application::setupWolfMaleSpriteSheet);
+	auto wolfFemaleImage = loadImage(wolfFemaleSpriteSheetPath,
+		&Application::setupWolfFemaleSpriteSheet);
+	auto hareImage = loadImage(hareSpriteSheetPath, &Application::setupHareSpriteSheet);
+	auto boardImage = loadImage(boardSpriteSheetPath, &Application::setupBoardSpriteSheet);
+	loadImage(guiSpriteSheetPath, &Application::setupGuiSpriteSheet);
+	auto boulderImage = loadImage(boulderSpritePath, &Application::setupBoulderSprite);
+	auto bushImage = loadImage(bushSpritePath, &Application::setupBushSprite);
+	mJobs.wait(resources);
+
+	// World sprites are drawn from a single texture array, gui keeps its own texture as it's
+	// drawn in screen space
+	auto sprites = make_shared<SpriteArray>();
+	sprites->add(*mWolfMaleSpriteSheet, *wolfMaleImage);
+	sprites->add(*mWolfFemaleSpriteSheet, *wolfFemaleImage);
+	sprites->add(*mHareSpriteSheet, *hareImage);
+	sprites->add(*mBoardSpriteSheet, *boardImage);
+	sprites->add(*mBoulderSprite, *boulderImage);
+	sprites->add(*mBushSprite, *bushImage);
+	sprites->build(mRenderer);
+	mSprites = sprites;
+	mStaticLayer.create(mSprites, mRenderer);
+	mAnimatedLayer.create(mSprites, mRenderer);
+	mDensityLayer.create(HeatmapMode::DENSITY, mRenderer);
+	mOverlayLayer.create(HeatmapMode::FAT, mRenderer);
 
 	// Sliders
 	shared_ptr<Text> widthSliderText = make_shared<Text>(string{}, mFnt, mVaoText, 0, mRenderer);
@@ -170,9 +205,12 @@ void Application::init(const std::string& windowTitle, const glm::tvec2<int32_t>
 	shared_ptr<Text> bushCountText = make_shared<Text>(string{}, mFnt, mVaoText,
 		180 * TextVertexLayout::Size(), mRenderer);
 	bushCountText->setColor(textColor);
+	shared_ptr<Text> statsText = make_shared<Text>(string{}, mFnt, mVaoText,
+		210 * TextVertexLayout::Size(), mRenderer);
+	statsText->setColor(textColor);
 
 	mInfoPanel.create(mGuiSpriteSheet, wolfMaleCountText, wolfFemaleCountText, hareCountText,
-		boulderCountText, bushCountText, glm::vec2{}, mRenderer);
+		boulderCountText, bushCountText, statsText, glm::vec2{}, mRenderer);
 	
 	resetGuiPosition();
 
@@ -210,13 +248,23 @@ void Application::run()
 
 		grabInput();
 
-		while (accumulator > updateTimeStep)
+		uint32_t logicSteps = 0;
+
+		while (accumulator > updateTimeStep && logicSteps < maxLogicSteps)
 		{
 			accumulator -= updateTimeStep;
+			logicSteps++;
 
 			calculateLogic(updateTimeStep);
 		}
 
+		// A long frame would otherwise make the next ones even longer
+		if (logicSteps == maxLogicSteps)
+			accumulator = fmod(accumulator, updateTimeStep);
+
+		updateTurnSlice();
+		mJobs.runMainThreadJobs();
+
 		animationUpdate(diff.count());
 
 		renderScene();
@@ -274,6 +322,36 @@ void Application::grabInput()
 
 			if (getKeyState(GLFW_KEY_4))
 				mCameraMoveMultiplier = 4.0f;
+
+			// Timeline, space resumes turns from the shown one
+			mScrubDirection = 0;
+
+			if (getKeyState(GLFW_KEY_LEFT_BRACKET))
+				mScrubDirection--;
+
+			if (getKeyState(GLFW_KEY_RIGHT_BRACKET))
+				mScrubDirection++;
+
+			if (getKeyState(GLFW_KEY_SPACE))
+				mScrubbing = false;
+
+			// Debug overlays of fat, vegetation and scent follow each other, then are hidden
+			if (getKeyState(GLFW_KEY_F3) && !mOverlayKeyDown)
+			{
+				auto mode = mOverlayLayer.getMode();
+
+				if (!mOverlayShown)
+					mOverlayShown = true;
+				else if (mode == HeatmapMode::SCENT)
+				{
+					mOverlayShown = false;
+					mOverlayLayer.setMode(HeatmapMode::FAT);
+				}
+				else
+					mOverlayLayer.setMode(static_cast<HeatmapMode>(static_cast<uint8_t>(mode) + 1));
+			}
+
+			mOverlayKeyDown = getKeyState(GLFW_KEY_F3);
 			
 			mNoneButton.grabInput(mOrthoMatrix, *this);
 
@@ -383,37 +461,22 @@ void Application::calculateLogic(double deltaTime)
 			mCameraPos += static_cast<float>(deltaTime) * mCameraMoveDir * cameraMoveVelocity *
 				mCameraMoveMultiplier;
 
-			mTourTimer += static_cast<float>(deltaTime);
-
-			if (mTourTimer >= tourTime)
+			// A held key steps at once and then repeats
+			if (mScrubDirection == 0)
+				mScrubTimer = scrubStepTime;
+			else if ((mScrubTimer += static_cast<float>(deltaTime)) >= scrubStepTime)
 			{
-				mBoard.updateTurn(*this);
-
-				// Update only active objects
-				for (auto& obj : mBoard.getObjects())
-				{
-					if (!obj->isActive())
-						continue;
-
-					obj->saveCurrentPos();
-				}
-
-				for (auto& obj : mBoard.getObjects())
-				{
-					if (!obj->isActive())
-						continue;
-
-					obj->updateMove(mBoard);
-				}
-
-				for (auto& obj : mBoard.getObjects())
-				{
-					if (!obj->isActive())
-						continue;
+				mScrubTimer = 0.0f;
+				scrubTimeline(mScrubDirection);
+			}
 
-					obj->updateAction(mBoard);
-				}
+			// Next turn is timed from the end of the previous one
+			if (!mTurnRequested && !mScrubbing)
+				mTourTimer += static_cast<float>(deltaTime);
 
+			if (mTourTimer >= tourTime)
+			{
+				mTurnRequested = true;
 				mTourTimer = 0.0f;
 			}
 
@@ -457,23 +520,66 @@ void Application::calculateLogic(double deltaTime)
 			mBoulderButton.update(deltaTime);
 			mBushButton.update(deltaTime);
 
-			if (mBoard.isCountersChanged())
-				mInfoPanel.updateCounters(mBoard.getObjectCounters(), mRenderer);
+			// Counters are read from snapshots, objects changed between turns are published and
+			// replace the kept state of the turn
+			if (mBoard.isCountersChanged() && !mBoard.isTurnInProgress())
+				mTimeline.capture(mBoard.publishSnapshot());
+
+			auto snapshot = mBoard.getSnapshot();
+
+			if (snapshot && snapshot != mCountedSnapshot)
+			{
+				mInfoPanel.updateCounters(snapshot->getObjectCounters(), mRenderer);
+				mCountedSnapshot = snapshot;
+			}
 
 			break;
 		}
 	}
 }
 
+void Application::updateTurnSlice()
+{
+	if (mState == State::SIMULATION && mTurnRequested && mBoard.updateTurn(turnSliceTime))
+	{
+		mTurnRequested = false;
+		mTimeline.capture(mBoard.publishSnapshot());
+	}
+}
+
+void Application::scrubTimeline(int32_t step)
+{
+	// The turn in progress is finished, so it's kept as well
+	if (mBoard.isTurnInProgress())
+	{
+		mBoard.updateTurn();
+		mTimeline.capture(mBoard.publishSnapshot());
+		mTurnRequested = false;
+	}
+
+	if (mTimeline.isEmpty())
+		return;
+
+	auto turn = glm::clamp(static_cast<int64_t>(mBoard.getTurn()) + step,
+		static_cast<int64_t>(mTimeline.getFirstTurn()),
+		static_cast<int64_t>(mTimeline.getLastTurn()));
+
+	if (turn != mBoard.getTurn())
+		mTimeline.restore(static_cast<uint32_t>(turn), mBoard);
+
+	mScrubbing = turn != mTimeline.getLastTurn();
+	mTourTimer = 0.0f;
+}
+
 void Application::animationUpdate(double deltaTime)
 {
 	switch (mState)
 	{
 	case State::SIMULATION:
 		{
-			// Update all objects
-			for (auto& obj : mBoard.getObjects())
-				obj->update(deltaTime);
+			// Moves and clips are played by the shader, only corpses are updated
+			mAnimationTime += deltaTime;
+			mBoard.updateCorpses(deltaTime);
 
 			auto color = glm::mix(oceanColorMin, oceanColorMax, 
 				(glm::sin(mColorChange) + 1.0f) / 2.0f);
@@ -484,6 +590,9 @@ void Application::animationUpdate(double deltaTime)
 
 void Application::renderScene()
 {
+	auto counters = mRenderer.getCounters();
+	mRenderer.clearCounters();
+
 	gl::Clear(gl::COLOR_BUFFER_BIT | gl::DEPTH_BUFFER_BIT);
 
 	switch (mState)
@@ -500,13 +609,57 @@ void Application::renderScene()
 
 	case State::SIMULATION:
 		{
+			// Only cells inside the camera rectangle are drawn
+			auto halfView = glm::vec2{ getDimensions() } / (2.0f * mCameraZoom);
+			auto first = glm::floor((-halfView - mCameraPos) / spriteSize);
+			auto last = glm::floor((halfView - mCameraPos) / spriteSize);
+			auto firstCell = glm::tvec2<int32_t>{ first } - cullingMarginCells;
+			auto lastCell = glm::tvec2<int32_t>{ last } + cullingMarginCells;
+
+			// Ground and static objects are drawn from the cache
+			mStaticLayer.update(mBoard, glm::tvec2<int32_t>{ first }, glm::tvec2<int32_t>{ last },
+				mCameraZoom, mRenderer);
+
 			// Render simulation objects
 			mRenderer.bindOrthoMatrix(mCameraMatrix);
+			mStaticLayer.draw(mRenderer);
+
+			bool heatmap = mCameraZoom < heatmapZoom;
+
+			if (heatmap)
+			{
+				mDensityLayer.update(mBoard, mRenderer);
+				mDensityLayer.draw(mRenderer);
+			}
+			else
+			{
+				mAnimatedLayer.update(mBoard, firstCell, lastCell, mAnimationTime, mRenderer);
+				mAnimatedLayer.draw(mAnimationTime, mRenderer);
+			}
 
-			mBoard.draw(mRenderer);
+			if (mOverlayShown)
+			{
+				mOverlayLayer.update(mBoard, mRenderer);
+				mOverlayLayer.draw(mRenderer);
+			}
 
-			for (auto& obj : mBoard.getObjects())
-				obj->draw(mRenderer);
+			auto drawn = heatmap ? 0 : mAnimatedLayer.getInstancesCount();
+			auto cached = mStaticLayer.getCachedSprites();
+			auto culled = mBoard.getTilesCount() +
+				static_cast<uint32_t>(mBoard.getObjects().size()) - drawn - cached;
+
+			// Calls are counted for the whole previous frame
+			if (drawn != mDrawnSprites || cached != mCachedSprites || culled != mCulledSprites ||
+				counters.drawCalls != mFrameCounters.drawCalls ||
+				counters.avoidedStateChanges != mFrameCounters.avoidedStateChanges ||
+				counters.bufferOrphans != mFrameCounters.bufferOrphans)
+			{
+				mDrawnSprites = drawn;
+				mCachedSprites = cached;
+				mCulledSprites = culled;
+				mFrameCounters = counters;
+				mInfoPanel.updateStats(drawn, cached, culled, counters, mRenderer);
+			}
 
 			// Render user interface
 			mRenderer.bindOrthoMatrix(mOrthoMatrix);
@@ -519,6 +672,8 @@ void Application::renderScene()
 			break;
 		}
 	}
+
+	mRenderer.flushQueue();
 }
 
 Renderer& Application::getRenderer()
@@ -612,41 +767,22 @@ glm::vec4 Application::getMouseNormalizedPosition()
 
 void Application::spawnWolf(glm::tvec2<int32_t> pos)
 {
-	uniform_int_distribution<int32_t> dist{ 0, 1 };
-
-	if (dist(randomDev) == 1)
-	{
-		auto wolf = make_shared<WolfMale>(mWolfMaleSpriteSheet);
-		wolf->setPos(pos);
-		mBoard.addGameObject(dynamic_pointer_cast<GameObject>(wolf));
-	}
-	else
-	{
-		auto wolf = make_shared<WolfFemale>(mWolfFemaleSpriteSheet);
-		wolf->setPos(pos);
-		mBoard.addGameObject(dynamic_pointer_cast<GameObject>(wolf));
-	}
+	mBoard.addWolf(pos);
 }
 
 void Application::spawnHare(glm::tvec2<int32_t> pos)
 {
-	auto hare = make_shared<Hare>(mHareSpriteSheet);
-	hare->setPos(pos);
-	mBoard.addGameObject(dynamic_pointer_cast<GameObject>(hare));
+	mBoard.addHare(pos);
 }
 
 void Application::spawnBoulder(glm::tvec2<std::int32_t> pos)
 {
-	auto boulder = make_shared<Boulder>(mBoulderSprite);
-	boulder->setPos(pos);
-	mBoard.addGameObject(dynamic_pointer_cast<GameObject>(boulder));
+	mBoard.addBoulder(pos);
 }
 
 void Application::spawnBush(glm::tvec2<std::int32_t> pos)
 {
-	auto bush = make_shared<Bush>(mBushSprite);
-	bush->setPos(pos);
-	mBoard.addGameObject(dynamic_pointer_cast<GameObject>(bush));
+	mBoard.addBush(pos);
 }
 
 void Application::GlfwScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
@@ -682,7 +818,9 @@ void Application::setupBoard()
 	auto values = mMenuPanel.getValues();
 
 	// Board dimensions
-	mBoard.create(values[1], values[0], mBoardSpriteSheet, mRenderer);
+	mBoard.create(values[1], values[0], mBoardSpriteSheet, mSprites, mRenderer);
+	mBoard.setSprites(mWolfMaleSpriteSheet, mWolfFemaleSpriteSheet, mHareSpriteSheet,
+		mBoulderSprite, mBushSprite);
 	mCameraPos = glm::vec2{ -(values[1] * spriteSize / 2.0f), -(values[0] * spriteSize / 2.0f) };
 	mCameraZoom = 1.0f;
 
@@ -695,13 +833,15 @@ void Application::setupBoard()
 
 	for (int i = 0; i < values[3]; i++)
 		spawnHare({ distWidth(randomDev), distHeight(randomDev) });
+
+	mTimeline.create(TimelineOptions{}, &mJobs);
+	mTimeline.capture(mBoard.publishSnapshot());
+	mScrubbing = false;
+	mAnimatedLayer.invalidate();
 }
 
-void Application::setupWolfMaleSpriteSheet()
+void Application::setupWolfMaleSpriteSheet(const Image& spriteImg)
 {
-	Image spriteImg;
-	ifstream spriteFile{ wolfMaleSpriteSheetPath, ios_base::binary };
-	PngCodec{}.decode(spriteFile, spriteImg);
 	shared_ptr<Texture> spriteTex = make_shared<Texture>(spriteImg, mRenderer);
 	spriteTex->generateMipmaps(mRenderer);
 
@@ -852,11 +992,8 @@ void Application::setupWolfMaleSpriteSheet()
 		1.0f, spriteTex, mVaoSprite, mRenderer));
 }
 
-void Application::setupWolfFemaleSpriteSheet()
+void Application::setupWolfFemaleSpriteSheet(const Image& spriteImg)
 {
-	Image spriteImg;
-	ifstream spriteFile{ wolfFemaleSpriteSheetPath, ios_base::binary };
-	PngCodec{}.decode(spriteFile, spriteImg);
 	shared_ptr<Texture> spriteTex = make_shared<Texture>(spriteImg, mRenderer);
 	spriteTex->generateMipmaps(mRenderer);
 
@@ -1007,11 +1144,8 @@ void Application::setupWolfFemaleSpriteSheet()
 		1.0f, spriteTex, mVaoSprite, mRenderer));
 }
 
-void Application::setupHareSpriteSheet()
+void Application::setupHareSpriteSheet(const Image& spriteImg)
 {
-	Image spriteImg;
-	ifstream spriteFile{ hareSpriteSheetPath, ios_base::binary };
-	PngCodec{}.decode(spriteFile, spriteImg);
 	shared_ptr<Texture> spriteTex = make_shared<Texture>(spriteImg, mRenderer);
 	spriteTex->generateMipmaps(mRenderer);
 
@@ -1095,11 +1229,8 @@ void Application::setupHareSpriteSheet()
 
 }
 
-void Application::setupBoardSpriteSheet()
+void Application::setupBoardSpriteSheet(const Image& spriteImg)
 {
-	Image spriteImg;
-	ifstream spriteFile{ boardSpriteSheetPath, ios_base::binary };
-	PngCodec{}.decode(spriteFile, spriteImg);
 	shared_ptr<Texture> spriteTex = make_shared<Texture>(spriteImg, mRenderer);
 	spriteTex->generateMipmaps(mRenderer);
 
@@ -1114,56 +1245,53 @@ void Application::setupBoardSpriteSheet()
 	// Lower left tile
 	mBoardSpriteSheet->addSprite(make_shared<Sprite>(spriteSize,
 		glm::vec2{ 0.0f / w, 0.0f / h }, glm::vec2{ 48.0f / w, 48.0f / h }, 
-		0.0f, spriteTex, mVaoSpriteInstanced, mRenderer));
+		0.0f, spriteTex, mVaoSprite, mRenderer));
 
 	// Lower middle tile
 	mBoardSpriteSheet->addSprite(make_shared<Sprite>(spriteSize,
 		glm::vec2{ 48.0f / w, 0.0f / h }, glm::vec2{ 96.0f / w, 48.0f / h }, 
-		0.0f, spriteTex, mVaoSpriteInstanced, mRenderer));
+		0.0f, spriteTex, mVaoSprite, mRenderer));
 
 	// Lower right tile
 	mBoardSpriteSheet->addSprite(make_shared<Sprite>(spriteSize,
 		glm::vec2{ 96.0f / w, 0.0f / h }, glm::vec2{ 144.0f / w, 48.0f / h }, 
-		0.0f, spriteTex, mVaoSpriteInstanced, mRenderer));
+		0.0f, spriteTex, mVaoSprite, mRenderer));
 
 
 	// Middle left tile
 	mBoardSpriteSheet->addSprite(make_shared<Sprite>(spriteSize,
 		glm::vec2{ 0.0f / w, 48.0f / h }, glm::vec2{ 48.0f / w, 96.0f / h }, 
-		0.0f, spriteTex, mVaoSpriteInstanced, mRenderer));
+		0.0f, spriteTex, mVaoSprite, mRenderer));
 
 	// Center tile
 	mBoardSpriteSheet->addSprite(make_shared<Sprite>(spriteSize,
 		glm::vec2{ 48.0f / w, 48.0f / h }, glm::vec2{ 96.0f / w, 96.0f / h }, 
-		0.0f, spriteTex, mVaoSpriteInstanced, mRenderer));
+		0.0f, spriteTex, mVaoSprite, mRenderer));
 
 	// Middle right tile
 	mBoardSpriteSheet->addSprite(make_shared<Sprite>(spriteSize,
 		glm::vec2{ 96.0f / w, 48.0f / h }, glm::vec2{ 144.0f / w, 96.0f / h }, 
-		0.0f, spriteTex, mVaoSpriteInstanced, mRenderer));
+		0.0f, spriteTex, mVaoSprite, mRenderer));
 
 
 	// Upper left tile
 	mBoardSpriteSheet->addSprite(make_shared<Sprite>(spriteSize,
 		glm::vec2{ 0.0f / w, 96.0f / h }, glm::vec2{ 48.0f / w, 144.0f / h }, 
-		0.0f, spriteTex, mVaoSpriteInstanced, mRenderer));
+		0.0f, spriteTex, mVaoSprite, mRenderer));
 
 	// Upper middle tile
 	mBoardSpriteSheet->addSprite(make_shared<Sprite>(spriteSize,
 		glm::vec2{ 48.0f / w, 96.0f / h }, glm::vec2{ 96.0f / w, 144.0f / h }, 
-		0.0f, spriteTex, mVaoSpriteInstanced, mRenderer));
+		0.0f, spriteTex, mVaoSprite, mRenderer));
 
 	// Upper right tile
 	mBoardSpriteSheet->addSprite(make_shared<Sprite>(spriteSize,
 		glm::vec2{ 96.0f / w, 96.0f / h }, glm::vec2{ 144.0f / w, 144.0f / h }, 
-		0.0f, spriteTex, mVaoSpriteInstanced, mRenderer));
+		0.0f, spriteTex, mVaoSprite, mRenderer));
 }
 
-void Application::setupGuiSpriteSheet()
+void Application::setupGuiSpriteSheet(const Image& spriteImg)
 {
-	Image spriteImg;
-	ifstream spriteFile{ guiSpriteSheetPath, ios_base::binary };
-	PngCodec{}.decode(spriteFile, spriteImg);
 	shared_ptr<Texture> spriteTex = make_shared<Texture>(spriteImg, mRenderer);
 	spriteTex->generateMipmaps(mRenderer);
 
@@ -1256,3 +1384,24 @@ void Application::setupGuiSpriteSheet()
 		1.0f, spriteTex, mVaoSprite, mRenderer));
 }
 
+void Application::setupBoulderSprite(const Image& spriteImg)
+{
+	shared_ptr<Texture> spriteTex = make_shared<Texture>(spriteImg, mRenderer);
+	spriteTex->generateMipmaps(mRenderer);
+
+	glm::vec2 spriteSize{ Application::spriteSize, Application::spriteSize };
+	
+	mBoulderSprite = make_shared<Sprite>(spriteSize, glm::vec2{ 0.0f, 0.0f }, 
+		glm::vec2{ 1.0f, 1.0f }, 0.0f, spriteTex, mVaoSprite, mRenderer);
+}
+
+void Application::setupBushSprite(const Image& spriteImg)
+{
+	shared_ptr<Texture> spriteTex = make_shared<Texture>(spriteImg, mRenderer);
+	spriteTex->generateMipmaps(mRenderer);
+
+	glm::vec2 spriteSize{ Application::spriteSize, Application::spriteSize };
+
+	mBushSprite = make_shared<Sprite>(spriteSize, glm::vec2{ 0.0f, 0.0f },
+		glm::vec2{ 1.0f, 1.0f }, 0.0f, spriteTex, mVaoSprite, mRenderer);
+}
@@ -13,6 +13,10 @@
 #include "PngCodec.hpp"
 #include "VertexArray.hpp"
 #include "VertexBuffer.hpp"
+#include "SpriteArray.hpp"
+#include "StaticLayerCache.hpp"
+#include "AnimatedObjectLayer.hpp"
+#include "HeatmapLayer.hpp"
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
@@ -21,6 +25,8 @@
 #include "InformationPanel.hpp"
 #include "MenuPanel.hpp"
 #include "Button.hpp"
+#include "JobSystem.hpp"
+#include "Timeline.hpp"
 
 
 class ApplicationInitException : public std::exception 
@@ -57,6 +63,13 @@ public:
 	// Calculates logic of all entities in every fixed time step
 	void calculateLogic(double deltaTime);
 
+	// Continues the requested board turn for a part of the frame
+	void updateTurnSlice();
+
+	// Shows a kept turn before or after the shown one, turns stop until the last kept turn is
+	// reached or they're resumed from the shown one
+	void scrubTimeline(std::int32_t step);
+
 	// Updates animation once in every frame.
 	void animationUpdate(double deltaTime);
 
@@ -91,7 +104,22 @@ private:
 	bool mIsGlfw; // Stores information about glfw init state
 	double mRealDeltaTime; // Stores real time difference between two frames
 	Renderer mRenderer;
+	StaticLayerCache mStaticLayer;
+	AnimatedObjectLayer mAnimatedLayer;
+	HeatmapLayer mDensityLayer;
+	HeatmapLayer mOverlayLayer;
+	bool mOverlayShown;
+	std::uint32_t mDrawnSprites;
+	std::uint32_t mCachedSprites;
+	std::uint32_t mCulledSprites;
+	RendererCounters mFrameCounters;
 	float mColorChange;
+
+	// Seconds of animations played, moves of turns start from it
+	double mAnimationTime;
+
+	// Workers shared by board turns and resource loading, gl jobs are run by the main loop
+	JobSystem mJobs;
 	
 	// Resources
 	std::shared_ptr<Font> mFnt;
@@ -102,9 +130,17 @@ private:
 	std::shared_ptr<SpriteSheet> mGuiSpriteSheet;
 	std::shared_ptr<Sprite> mBoulderSprite;
 	std::shared_ptr<Sprite> mBushSprite;
+	std::shared_ptr<const SpriteArray> mSprites;
 
 	// Simulation objects
 	Board mBoard;
+	Timeline mTimeline;
+	bool mScrubbing;
+	std::int32_t mScrubDirection;
+	float mScrubTimer;
+
+	// Snapshot whose counters the information panel shows
+	std::shared_ptr<const WorldSnapshot> mCountedSnapshot;
 
 	// Menu controls
 	MenuPanel mMenuPanel;
@@ -119,7 +155,6 @@ private:
 	// Gpu resources
 	std::shared_ptr<VertexArray> mVaoText;
 	std::shared_ptr<VertexArray> mVaoSprite;
-	std::shared_ptr<VertexArray> mVaoSpriteInstanced;
 
 	glm::mat4 mOrthoMatrix;
 	glm::mat4 mCameraMatrix;
@@ -132,8 +167,10 @@ private:
 	float mCameraMoveMultiplier;
 	float mCameraZoom;
 	float mTourTimer;
+	bool mTurnRequested;
 	char mSpawnObjectTypeKey;
 	bool mObjectAlreadySpawned;
+	bool mOverlayKeyDown;
 	glm::tvec2<std::int32_t> mSpawnPos;
 
 	enum class State
@@ -145,10 +182,12 @@ private:
 	glm::tvec2<std::int32_t> getMouseoverSpawnPosition();
 
 	void setupBoard();
-	void setupWolfMaleSpriteSheet();
-	void setupWolfFemaleSpriteSheet();
-	void setupHareSpriteSheet();
-	void setupBoardSpriteSheet();
-	void setupGuiSpriteSheet();
+	void setupWolfMaleSpriteSheet(const Image& spriteImg);
+	void setupWolfFemaleSpriteSheet(const Image& spriteImg);
+	void setupHareSpriteSheet(const Image& spriteImg);
+	void setupBoardSpriteSheet(const Image& spriteImg);
+	void setupGuiSpriteSheet(const Image& spriteImg);
+	void setupBoulderSprite(const Image& spriteImg);
+	void setupBushSprite(const Image& spriteImg);
 };
 
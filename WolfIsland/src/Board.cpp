@@ -1,5 +1,7 @@
 #include "Board.hpp"
 #include "Renderer.hpp"
+#include "SpriteArray.hpp"
+#include "SpriteBatch.hpp"
 #include "Image.hpp"
 #include "Texture.hpp"
 #include "PngCodec.hpp"
@@ -8,142 +10,173 @@
 #include "VertexLayout.hpp"
 #include "GameObject.hpp"
 #include "Application.hpp"
+#include "WolfMale.hpp"
+#include "WolfFemale.hpp"
+#include "Hare.hpp"
+#include "Boulder.hpp"
+#include "Bush.hpp"
 #include <glm/gtx/transform.hpp>
 #include <glm/vec3.hpp>
 using namespace std;
 
 static const string groundSpriteSheetName{ "GroundSpriteSheet.png" };
 
+// Objects updated between checks of the turn slice budget
+static const uint32_t objectsPerBudgetCheck{ 64 };
+
+// Objects saved by a single job
+static const size_t objectsPerJob{ 4096 };
+
+// Object types in the order of object counters
+static const array<string, 5> objectTypes{ { "wolf_male", "wolf_female", "hare", "boulder",
+	"bush" } };
 
 Board::Board()
-	: mObjectCounters{ 0, 0, 0, 0, 0 }, mIsCountersChanged{ true }
+	: mWidth{ 0 }, mHeight{ 0 }, mTurn{ 0 }, mHeadless{ true }, mJobs{ nullptr },
+	mObjectsAdded{ 0 }, mSpatialIndexChanged{ true }, mObjectCounters{ 0, 0, 0, 0, 0 },
+	mIsCountersChanged{ true }, mHareFieldCurrent{ false }, mObstaclesChanged{ true },
+	mStaticVersion{ 0 }, mHareEngine{ HareEngine::AGENTS }, mTurnStage{ TurnStage::CLEANUP }, mTurnCursor{ 0 },
+	mTurnObjectsCount{ 0 }, mDrawnTiles{ 0 }
 {
 }
 
 Board::Board(uint32_t width, uint32_t height, shared_ptr<SpriteSheet> spriteSheet, 
-	Renderer& renderer)
-	: mObjectCounters{ 0, 0, 0, 0, 0 }, mIsCountersChanged{ true }
+	shared_ptr<const SpriteArray> sprites, Renderer& renderer)
+	: mTurn{ 0 }, mHeadless{ true }, mJobs{ nullptr }, mObjectsAdded{ 0 },
+	mSpatialIndexChanged{ true },
+	mObjectCounters{ 0, 0, 0, 0, 0 }, mIsCountersChanged{ true }, mHareFieldCurrent{ false },
+	mObstaclesChanged{ true }, mStaticVersion{ 0 }, mHareEngine{ HareEngine::AGENTS },
+	mTurnStage{ TurnStage::CLEANUP }, mTurnCursor{ 0 }, mTurnObjectsCount{ 0 }, mDrawnTiles{ 0 }
 {
-	create(width, height, spriteSheet, renderer);
+	create(width, height, spriteSheet, sprites, renderer);
 }
 
-void Board::create(uint32_t width, uint32_t height, shared_ptr<SpriteSheet> spriteSheet, 
-	Renderer& renderer)
+Board::Board(uint32_t width, uint32_t height, uint32_t seed)
+	: mTurn{ 0 }, mHeadless{ true }, mJobs{ nullptr }, mObjectsAdded{ 0 },
+	mSpatialIndexChanged{ true },
+	mObjectCounters{ 0, 0, 0, 0, 0 }, mIsCountersChanged{ true }, mHareFieldCurrent{ false },
+	mObstaclesChanged{ true }, mStaticVersion{ 0 }, mHareEngine{ HareEngine::AGENTS },
+	mTurnStage{ TurnStage::CLEANUP }, mTurnCursor{ 0 }, mTurnObjectsCount{ 0 }, mDrawnTiles{ 0 }
+{
+	create(width, height, seed);
+}
+
+void Board::create(uint32_t width, uint32_t height, uint32_t seed)
 {
 	mWidth = width;
 	mHeight = height;
-	mSpriteSheet = spriteSheet;
-
-	vector<PositionVertexLayout::Data> vec;
-
-	// lower left tile
-	vec.clear();
-	vec.push_back({ -Application::spriteSize, -Application::spriteSize, 0.0f });
-	mTileMap.push_back(make_shared<VertexBuffer<PositionVertexLayout>>(
-		vec.size(), renderer));
-	mTileMap.back()->add(vec, renderer);
-	
-
-	// lower middle tile
-	vec.clear();
-
-	for (int x = 0; x < mWidth; x++)
-		vec.push_back({ x * Application::spriteSize, -Application::spriteSize, 0.0f });
-
-	mTileMap.push_back(make_shared<VertexBuffer<PositionVertexLayout>>(
-		vec.size(), renderer));
-	mTileMap.back()->add(vec, renderer);
-	
-
-	// lower right tile
-	vec.clear();
-	vec.push_back({ mWidth * Application::spriteSize, -Application::spriteSize, 0.0f });
-	mTileMap.push_back(make_shared<VertexBuffer<PositionVertexLayout>>(
-		vec.size(), renderer));
-	mTileMap.back()->add(vec, renderer);
-
-
-	// middle left tile
-	vec.clear();
-
-	for (int y = 0; y < mHeight; y++)
-		vec.push_back({ -Application::spriteSize, y * Application::spriteSize, 0.0f });
-
-	mTileMap.push_back(make_shared<VertexBuffer<PositionVertexLayout>>(
-		vec.size(), renderer));
-	mTileMap.back()->add(vec, renderer);
-
-
-	// center tile
-	vec.clear();
-
-	for (int y = 0; y < mHeight; y++)
-	{
-		for (int x = 0; x < mWidth; x++)
-			vec.push_back({ x * Application::spriteSize, y * Application::spriteSize, 0.0f });
-	}
-	
-	mTileMap.push_back(make_shared<VertexBuffer<PositionVertexLayout>>(
-		vec.size(), renderer));
-	mTileMap.back()->add(vec, renderer);
+	mTurn = 0;
+	mHeadless = true;
+	mRandomEngine.seed(seed);
+	mRandom.create(seed);
+	mSplitTrials.clear();
+	mTurnStage = TurnStage::CLEANUP;
+	mTurnCursor = 0;
+	mTurnObjectsCount = 0;
 
+	mObjects.clear();
+	mEntities.clear();
+	mObjectSerials.clear();
+	mDirtyObjects.markAll();
+	mCorpses.clear();
+	mObjectsAdded = 0;
+	atomic_store(&mSnapshot, shared_ptr<const WorldSnapshot>{});
+	mSpatialIndex.create(width, height);
+	mSpatialIndexChanged = true;
+	mGovernor.create(GovernorOptions{}, 0, 0);
+	mHareSpawnStack = stack<glm::tvec2<int32_t>>{};
+	mWolfSpawnStack = stack<glm::tvec2<int32_t>>{};
+	mObjectCounters.fill(0);
+	mIsCountersChanged = true;
 
-	// middle right tile
-	vec.clear();
+	// Batch runs already use every core for separate boards and have no job system
+	mHareField.create(width, height, mJobs);
+	mHareFieldCurrent = false;
+	mObstaclesChanged = true;
+	mStaticVersion++;
+	mVegetation.create(width, height);
+	mTurnProfile.clear();
+	mMeanFieldOptions = MeanFieldOptions{};
+	mMeanField.create(0, 0, 1, 0);
+	mHareEngine = HareEngine::AGENTS;
+	mHareAutomaton.create(0, 0, 0);
+}
 
-	for (int y = 0; y < mHeight; y++)
-		vec.push_back({ mWidth * Application::spriteSize, 
-			y * Application::spriteSize, 0.0f });
+void Board::create(uint32_t width, uint32_t height, shared_ptr<SpriteSheet> spriteSheet, 
+	shared_ptr<const SpriteArray> sprites, Renderer& renderer)
+{
+	create(width, height, Application::randomDev());
+	mHeadless = false;
+	mSpriteSheet = spriteSheet;
+	mSprites = sprites;
+	mGroundQuad = make_shared<VertexArray>(SpriteBatch::CreateQuad(renderer), renderer);
 
-	mTileMap.push_back(make_shared<VertexBuffer<PositionVertexLayout>>(
-		vec.size(), renderer));
-	mTileMap.back()->add(vec, renderer);
+	// Ground is a 3x3 grid of tile groups, the middle ones span the board
+	for (uint32_t i = 0; i < mGroupTiles.size(); i++)
+		sprites->getInstance(*spriteSheet, i, glm::vec2{ 0.0f, 0.0f }, mGroupTiles[i]);
+}
 
 
-	// upper left tile
-	vec.clear();
-	vec.push_back({ -Application::spriteSize, mHeight * Application::spriteSize, 0.0f });
-	mTileMap.push_back(make_shared<VertexBuffer<PositionVertexLayout>>(
-		vec.size(), renderer));
-	mTileMap.back()->add(vec, renderer);
+Board::~Board()
+{
+}
 
-	// upper middle tile
-	vec.clear();
+void Board::draw(Renderer& renderer, const glm::tvec2<int32_t>& first,
+	const glm::tvec2<int32_t>& last)
+{
+	// Outer groups are a single row or column of tiles along the edge
+	auto size = glm::tvec2<int32_t>{ mWidth, mHeight };
+	auto tilesFirst = glm::max(first, glm::tvec2<int32_t>{ -1, -1 });
+	auto tilesLast = glm::min(last, size);
+	auto cells = glm::max(tilesLast - tilesFirst + 1, glm::tvec2<int32_t>{ 0, 0 });
+	mDrawnTiles = cells.x * cells.y;
 
-	for (int x = 0; x < mWidth; x++)
-		vec.push_back({ x * Application::spriteSize, 
-			mHeight * Application::spriteSize, 0.0f });
+	if (mDrawnTiles == 0)
+		return;
 
-	mTileMap.push_back(make_shared<VertexBuffer<PositionVertexLayout>>(
-		vec.size(), renderer));
-	mTileMap.back()->add(vec, renderer);
+	auto texture = mSprites->getTexture().lock();
 
-	// upper right tile
-	vec.clear();
-	vec.push_back({ mWidth * Application::spriteSize, 
-		mHeight * Application::spriteSize, 0.0f });
-	mTileMap.push_back(make_shared<VertexBuffer<PositionVertexLayout>>(
-		vec.size(), renderer));
-	mTileMap.back()->add(vec, renderer);
+	renderer.submit(renderer.getQueueKey(RenderLayer::GROUND, Renderer::Program::GROUND, *texture,
+		0.0f), [this, texture, tilesFirst, tilesLast, size](Renderer& renderer)
+		{
+			renderer.prepareDrawGround();
+			renderer.drawGround(*mGroundQuad, *texture, mGroupTiles, tilesFirst, tilesLast, size,
+				Application::spriteSize);
+		});
 }
 
+uint32_t Board::getTilesCount() const
+{
+	return (mWidth + 2) * (mHeight + 2);
+}
 
-Board::~Board()
+uint32_t Board::getDrawnTiles() const
 {
+	return mDrawnTiles;
 }
 
-void Board::draw(Renderer& renderer)
+uint32_t Board::getStaticVersion() const
 {
-	renderer.prepareDrawSpriteInstanced();
+	return mStaticVersion;
+}
 
-	auto vao = mSpriteSheet->getVao().lock();
+void Board::setSprites(shared_ptr<SpriteSheet> wolfMaleSpriteSheet,
+	shared_ptr<SpriteSheet> wolfFemaleSpriteSheet, shared_ptr<SpriteSheet> hareSpriteSheet,
+	shared_ptr<Sprite> boulderSprite, shared_ptr<Sprite> bushSprite)
+{
+	mWolfMaleSpriteSheet = wolfMaleSpriteSheet;
+	mWolfFemaleSpriteSheet = wolfFemaleSpriteSheet;
+	mHareSpriteSheet = hareSpriteSheet;
+	mBoulderSprite = boulderSprite;
+	mBushSprite = bushSprite;
+}
 
-	for (int i = 0; i < mTileMap.size(); i++)
-	{
-		vao->addInstanceBuffer(mTileMap[i], renderer);
-		renderer.drawSpriteInstanced(*mSpriteSheet->getSprite(i).lock(), glm::mat4{ 1.0f }, 
-			mTileMap[i]->getElementsCount());
-	}
+void Board::setJobSystem(JobSystem* jobs)
+{
+	mJobs = jobs;
+	mHareField.create(mWidth, mHeight, jobs);
+	mHareFieldCurrent = false;
+	mObstaclesChanged = true;
 }
 
 const vector<shared_ptr<GameObject>>& Board::getObjects() const
@@ -151,9 +184,22 @@ const vector<shared_ptr<GameObject>>& Board::getObjects() const
 	return mObjects;
 }
 
-void Board::addGameObject(shared_ptr<GameObject>& object)
+void Board::addGameObject(const shared_ptr<GameObject>& object)
 {
 	mObjects.push_back(object);
+	object->setHandle(mEntities.create(object.get()));
+
+	auto slot = object->getHandle().getIndex();
+
+	if (slot >= mObjectSerials.size())
+		mObjectSerials.resize(slot + 1);
+
+	mObjectSerials[slot] = mObjectsAdded++;
+	mDirtyObjects.mark(slot);
+
+	// Appending keeps the order of objects in buckets
+	if (!mSpatialIndexChanged)
+		mSpatialIndex.insert(object->getHandle(), object->getSavedPos());
 
 	if (object->getObjectType() == "wolf_male")
 		mObjectCounters[0]++;
@@ -162,9 +208,17 @@ void Board::addGameObject(shared_ptr<GameObject>& object)
 	else if (object->getObjectType() == "hare")
 		mObjectCounters[2]++;
 	else if (object->getObjectType() == "boulder")
+	{
 		mObjectCounters[3]++;
+		mObstaclesChanged = true;
+		mStaticVersion++;
+	}
 	else if (object->getObjectType() == "bush")
+	{
 		mObjectCounters[4]++;
+		mObstaclesChanged = true;
+		mStaticVersion++;
+	}
 
 	mIsCountersChanged = true;
 }
@@ -179,19 +233,188 @@ uint32_t Board::getHeight() const
 	return mHeight;
 }
 
+uint32_t Board::getTurn() const
+{
+	return mTurn;
+}
+
+bool Board::isHeadless() const
+{
+	return mHeadless;
+}
+
+mt19937& Board::getRandomEngine()
+{
+	return mRandomEngine;
+}
+
+CounterRandom& Board::getRandom()
+{
+	return mRandom;
+}
+
+bool Board::getSplitTrial() const
+{
+	return mTurnCursor > 0 && mTurnCursor <= mSplitTrials.size() && mSplitTrials[mTurnCursor - 1];
+}
+
+void Board::setParameters(const SimulationParameters& parameters)
+{
+	mParameters = parameters;
+}
+
+const SimulationParameters& Board::getParameters() const
+{
+	return mParameters;
+}
+
+const FlowField& Board::getHareField() const
+{
+	return mHareField;
+}
+
+bool Board::isHareFieldCurrent() const
+{
+	return mHareFieldCurrent;
+}
+
+VegetationField& Board::getVegetation()
+{
+	return mVegetation;
+}
+
+const VegetationField& Board::getVegetation() const
+{
+	return mVegetation;
+}
+
+void Board::setMeanField(const MeanFieldOptions& options)
+{
+	mMeanFieldOptions = options;
+
+	if (options.enabled)
+	{
+		mMeanField.create(mWidth, mHeight, options.regionSize, mRandomEngine());
+		mObstaclesChanged = true;
+	}
+	else
+		mMeanField.create(0, 0, 1, 0);
+}
+
+const MeanFieldOptions& Board::getMeanFieldOptions() const
+{
+	return mMeanFieldOptions;
+}
+
+void Board::setHareEngine(HareEngine engine)
+{
+	mHareEngine = engine;
+
+	if (engine == HareEngine::AUTOMATON)
+	{
+		mHareAutomaton.create(mWidth, mHeight, mRandomEngine());
+		mObstaclesChanged = true;
+	}
+	else
+		mHareAutomaton.create(0, 0, 0);
+}
+
+HareEngine Board::getHareEngine() const
+{
+	return mHareEngine;
+}
+
+uint32_t Board::getHareCount(const glm::tvec2<int32_t>& pos) const
+{
+	return mMeanField.getCount(pos) + (mHareAutomaton.get(pos) ? 1 : 0);
+}
+
+bool Board::eatCountedHare(const glm::tvec2<int32_t>& pos)
+{
+	return mMeanField.take(pos) || mHareAutomaton.take(pos);
+}
+
+uint64_t Board::getCountedHares() const
+{
+	return mMeanField.getTotal() + mHareAutomaton.getTotal();
+}
+
+void Board::setGovernor(const GovernorOptions& options)
+{
+	// Memory of an object with its owning pointer, entity slot and spatial index entry
+	uint32_t entityBytes = max({ sizeof(WolfMale), sizeof(WolfFemale), sizeof(Hare) }) +
+		sizeof(shared_ptr<GameObject>) + 64;
+
+	mGovernor.create(options, entityBytes, mSpatialIndex.getBucketsCount());
+}
+
+const PopulationGovernor& Board::getGovernor() const
+{
+	return mGovernor;
+}
+
+const TurnProfile& Board::getTurnProfile() const
+{
+	return mTurnProfile;
+}
+
 void Board::spawnWolf(glm::tvec2<int32_t> pos)
 {
-	mWolfSpawnStack.push(pos);
+	if (allowBirth(pos))
+		mWolfSpawnStack.push(pos);
 }
 
 void Board::spawnHare(glm::tvec2<int32_t> pos)
 {
-	mHareSpawnStack.push(pos);
+	if (allowBirth(pos))
+		mHareSpawnStack.push(pos);
+}
+
+void Board::addWolf(glm::tvec2<int32_t> pos)
+{
+	if (mRandom.next(2) == 1)
+	{
+		auto wolf = make_shared<WolfMale>(mWolfMaleSpriteSheet, *this);
+		wolf->setPos(pos);
+		addGameObject(wolf);
+	}
+	else
+	{
+		auto wolf = make_shared<WolfFemale>(mWolfFemaleSpriteSheet, *this);
+		wolf->setPos(pos);
+		addGameObject(wolf);
+	}
+}
+
+void Board::addHare(glm::tvec2<int32_t> pos)
+{
+	if (mHareEngine == HareEngine::AUTOMATON)
+	{
+		mHareAutomaton.add(pos);
+		return;
+	}
+
+	auto hare = make_shared<Hare>(mHareSpriteSheet, *this);
+	hare->setPos(pos);
+	addGameObject(hare);
+}
+
+void Board::addBoulder(glm::tvec2<int32_t> pos)
+{
+	auto boulder = make_shared<Boulder>(mBoulderSprite);
+	boulder->setPos(pos);
+	addGameObject(boulder);
+}
+
+void Board::addBush(glm::tvec2<int32_t> pos)
+{
+	auto bush = make_shared<Bush>(mBushSprite);
+	bush->setPos(pos);
+	addGameObject(bush);
 }
 
 const array<int32_t, 5>& Board::getObjectCounters()
 {
-	mIsCountersChanged = false;
 	return mObjectCounters;
 }
 
@@ -200,11 +423,436 @@ bool Board::isCountersChanged()
 	return mIsCountersChanged;
 }
 
-void Board::updateTurn(Application& app)
+void Board::updateCorpses(float deltaTime)
+{
+	for (auto handle : mCorpses)
+	{
+		auto obj = getObject(handle);
+
+		// Removed objects have stale handles
+		if (obj && !obj->isReadyToDelete())
+		{
+			obj->update(deltaTime);
+			mDirtyObjects.mark(handle.getIndex());
+		}
+	}
+}
+
+void Board::updateTurn()
+{
+	while (!updateTurn(numeric_limits<double>::infinity()));
+}
+
+bool Board::updateTurn(double budgetSeconds)
+{
+	auto sliceStart = chrono::steady_clock::now();
+	auto phaseStart = sliceStart;
+	auto endPhase = [this, &phaseStart](TurnPhase phase)
+	{
+		auto now = chrono::steady_clock::now();
+		mTurnProfile.add(phase, chrono::duration<double>(now - phaseStart).count());
+		phaseStart = now;
+	};
+
+	auto isBudgetSpent = [budgetSeconds, &sliceStart]()
+	{
+		return chrono::duration<double>(chrono::steady_clock::now() - sliceStart).count() >=
+			budgetSeconds;
+	};
+
+	// Objects added during the turn wait for the next one. Returns false when the budget
+	// ran out, the cursor keeps the next object.
+	auto updateObjects = [this, &isBudgetSpent](void (*update)(GameObject&, Board&))
+	{
+		for (uint32_t processed = 1; mTurnCursor < mTurnObjectsCount; processed++)
+		{
+			auto& obj = mObjects[mTurnCursor++];
+
+			// Update only active objects. Objects change only themselves and other active ones,
+			// so marking the updated ones covers every change. Static objects don't change.
+			if (obj->isActive())
+			{
+				if (!obj->isStatic())
+					mDirtyObjects.mark(obj->getHandle().getIndex());
+
+				update(*obj, *this);
+			}
+
+			if (processed % objectsPerBudgetCheck == 0 && mTurnCursor < mTurnObjectsCount &&
+				isBudgetSpent())
+				return false;
+		}
+
+		mTurnCursor = 0;
+		return true;
+	};
+
+	while (true)
+	{
+		switch (mTurnStage)
+		{
+		case TurnStage::CLEANUP:
+			mTurnProfile.clear();
+			mTurnProfile.turns = 1;
+			removeDeadObjects();
+			endPhase(TurnPhase::CLEANUP);
+			mTurnStage = TurnStage::SPAWN;
+			break;
+
+		case TurnStage::SPAWN:
+			while (!mHareSpawnStack.empty())
+			{
+				addHare(mHareSpawnStack.top());
+				mHareSpawnStack.pop();
+			}
+
+			while (!mWolfSpawnStack.empty())
+			{
+				addWolf(mWolfSpawnStack.top());
+				mWolfSpawnStack.pop();
+			}
+
+			mTurnObjectsCount = mObjects.size();
+			mTurnCursor = 0;
+			mGovernor.beginTurn();
+			endPhase(TurnPhase::SPAWN);
+			mTurnStage = TurnStage::SAVE_POSITIONS;
+			break;
+
+		case TurnStage::SAVE_POSITIONS:
+		{
+			mSpatialIndexChanged = true;
+			bool finished{ true };
+
+			// Objects are saved independently, so jobs take all of them in batches at once
+			if (mJobs)
+			{
+				mJobs->parallelFor(mTurnObjectsCount - mTurnCursor, objectsPerJob,
+					[this](size_t first, size_t last)
+					{
+						for (size_t i = mTurnCursor + first; i < mTurnCursor + last; i++)
+						{
+							if (mObjects[i]->isActive())
+								mObjects[i]->saveCurrentPos();
+						}
+					});
+
+				mTurnCursor = 0;
+			}
+			else
+				finished = updateObjects([](GameObject& obj, Board&) { obj.saveCurrentPos(); });
+
+			endPhase(TurnPhase::MOVE);
+
+			if (!finished)
+				return false;
+
+			mTurnStage = TurnStage::FLOW_FIELD;
+			break;
+		}
+
+		case TurnStage::FLOW_FIELD:
+			if (mObstaclesChanged && (mParameters.pursuitRange > 0 || mMeanFieldOptions.enabled ||
+				mHareEngine == HareEngine::AUTOMATON))
+				updateObstacles();
+
+			mHareFieldCurrent = mParameters.pursuitRange > 0 && isHareFieldNeeded();
+
+			if (mHareFieldCurrent)
+				updateHareField();
+
+			endPhase(TurnPhase::FLOW_FIELD);
+			mTurnStage = TurnStage::MOVE;
+			break;
+
+		case TurnStage::MOVE:
+		{
+			bool finished = updateObjects([](GameObject& obj, Board& board)
+				{ obj.updateMove(board); });
+			endPhase(TurnPhase::MOVE);
+
+			if (!finished)
+				return false;
+
+			// Split chance is out of 101 like the former draw from [0, 100]
+			mSplitTrials.resize(mTurnObjectsCount);
+			mRandom.fillTrials(mSplitTrials.data(), mSplitTrials.size(),
+				static_cast<uint32_t>(max(mParameters.splitChance, 0)), 101);
+			mTurnStage = TurnStage::ACTION;
+			break;
+		}
+
+		case TurnStage::ACTION:
+		{
+			bool finished = updateObjects([](GameObject& obj, Board& board)
+				{ obj.updateAction(board); });
+			endPhase(TurnPhase::ACTION);
+
+			if (!finished)
+				return false;
+
+			mTurnStage = TurnStage::FIELDS;
+			break;
+		}
+
+		case TurnStage::FIELDS:
+		{
+			if (mMeanFieldOptions.enabled)
+				updateMeanField();
+
+			endPhase(TurnPhase::MEAN_FIELD);
+
+			// The automaton doesn't share any data with vegetation, a job updates it meanwhile
+			JobHandle automaton;
+			double automatonTime{ 0.0 };
+
+			if (mHareEngine == HareEngine::AUTOMATON && mJobs)
+				automaton = mJobs->add([this, &automatonTime]()
+					{
+						auto start = chrono::steady_clock::now();
+						mHareAutomaton.update(mParameters);
+						automatonTime = chrono::duration<double>(
+							chrono::steady_clock::now() - start).count();
+					});
+			else if (mHareEngine == HareEngine::AUTOMATON)
+				mHareAutomaton.update(mParameters);
+
+			endPhase(TurnPhase::HARE_AUTOMATON);
+
+			if (mParameters.hareAppetite > 0.0f)
+				mVegetation.update(mParameters.vegetationGrowth, mParameters.vegetationDiffusion);
+
+			endPhase(TurnPhase::VEGETATION);
+
+			if (automaton)
+			{
+				mJobs->wait(automaton);
+				mTurnProfile.add(TurnPhase::HARE_AUTOMATON, automatonTime);
+				phaseStart = chrono::steady_clock::now();
+			}
+
+			// Nothing plays corpse animations on headless boards, so counters are kept exact
+			if (mHeadless)
+				removeDeadObjects();
+			else
+				findCorpses();
+
+			endPhase(TurnPhase::CLEANUP);
+			mTurn++;
+			mTurnStage = TurnStage::CLEANUP;
+			return true;
+		}
+		}
+
+		if (isBudgetSpent())
+			return false;
+	}
+}
+
+bool Board::isTurnInProgress() const
+{
+	return mTurnStage != TurnStage::CLEANUP;
+}
+
+shared_ptr<const WorldSnapshot> Board::publishSnapshot()
+{
+	if (isTurnInProgress())
+		throw BoardStateException();
+
+	auto previous = atomic_load(&mSnapshot);
+	auto snapshot = make_shared<WorldSnapshot>();
+	WorldSnapshot empty;
+	auto& base = previous ? *previous : empty;
+
+	snapshot->mWidth = mWidth;
+	snapshot->mHeight = mHeight;
+	snapshot->mTurn = mTurn;
+	snapshot->mHareEngine = mHareEngine;
+	snapshot->mMeanFieldEnabled = mMeanFieldOptions.enabled;
+	snapshot->mRandomSeed = mRandom.getSeed();
+	snapshot->mRandomCounter = mRandom.getCounter();
+	snapshot->mObjectsAdded = mObjectsAdded;
+
+	// Fields and objects mark chunks they write, the others are shared without being read
+	const auto& vegetation = mVegetation.getValues();
+	snapshot->mVegetation = ChunkedArray<float>{ vegetation.data(), vegetation.size(),
+		base.mVegetation, mVegetation.getDirtyChunks() };
+
+	auto& counts = mMeanField.getCounts();
+	snapshot->mHareCounts = ChunkedArray<uint32_t>{ counts.data(), counts.size(),
+		base.mHareCounts, mMeanField.getDirtyCounts() };
+
+	auto& regions = mMeanField.getCountedRegions();
+	snapshot->mCountedRegions = ChunkedArray<uint8_t>{ regions.data(), regions.size(),
+		base.mCountedRegions, mMeanField.getDirtyRegions() };
+
+	snapshot->mAutomaton = ChunkedArray<uint64_t>{ mHareAutomaton.getStateSize(),
+		base.mAutomaton, mHareAutomaton.getDirtyChunks(),
+		[this](size_t first, size_t last, uint64_t* words)
+		{ mHareAutomaton.getState(first, last, words); } };
+
+	// Objects by entity slot, which they keep for their whole life
+	snapshot->mObjects = ChunkedArray<ObjectState>{ mEntities.getSlotsCount(), base.mObjects,
+		mDirtyObjects, [this](size_t first, size_t last, ObjectState* records)
+		{
+			for (auto slot = static_cast<uint32_t>(first); slot < last; slot++)
+			{
+				auto& record = records[slot - first];
+				record.generation = mEntities.getGeneration(slot);
+
+				auto obj = mEntities.get(EntityHandle{
+					record.generation << EntityHandle::indexBits | slot });
+
+				if (!obj)
+					continue;
+
+				obj->saveState(record);
+				record.type = find(begin(objectTypes), end(objectTypes), obj->getObjectType()) -
+					begin(objectTypes) + 1;
+				record.serial = mObjectSerials[slot];
+			}
+		} };
+
+	mVegetation.clearDirtyChunks();
+	mMeanField.clearDirtyChunks();
+	mHareAutomaton.clearDirtyChunks();
+	mDirtyObjects.clear();
+
+	snapshot->mFreeSlots = mEntities.getFreeSlots();
+
+	for (auto spawnStack : { make_pair(mWolfSpawnStack, &snapshot->mWolfSpawns),
+		make_pair(mHareSpawnStack, &snapshot->mHareSpawns) })
+	{
+		for (; !spawnStack.first.empty(); spawnStack.first.pop())
+			spawnStack.second->push_back(spawnStack.first.top());
+
+		reverse(begin(*spawnStack.second), end(*spawnStack.second));
+	}
+
+	snapshot->count(base);
+	mIsCountersChanged = false;
+	atomic_store(&mSnapshot, shared_ptr<const WorldSnapshot>{ snapshot });
+
+	return snapshot;
+}
+
+shared_ptr<const WorldSnapshot> Board::getSnapshot() const
+{
+	return atomic_load(&mSnapshot);
+}
+
+void Board::loadSnapshot(const WorldSnapshot& snapshot)
+{
+	if (isTurnInProgress())
+		throw BoardStateException();
+
+	auto& objects = snapshot.mObjects;
+	vector<uint64_t> automaton(snapshot.mAutomaton.size());
+	snapshot.mAutomaton.copyTo(automaton.data());
+
+	bool valid = snapshot.mWidth == mWidth && snapshot.mHeight == mHeight &&
+		snapshot.mHareEngine == mHareEngine &&
+		snapshot.mMeanFieldEnabled == mMeanFieldOptions.enabled &&
+		snapshot.mVegetation.size() == mVegetation.getValues().size() &&
+		snapshot.mHareCounts.size() == mMeanField.getCounts().size() &&
+		snapshot.mCountedRegions.size() == mMeanField.getRegionsCount();
+
+	// The automaton checks its words, it's the last one to be changed by a wrong snapshot
+	if (!valid || !mHareAutomaton.setState(automaton))
+		throw BoardStateException();
+
+	mTurn = snapshot.mTurn;
+	snapshot.mVegetation.copyTo(mVegetation.getValues().data());
+	mVegetation.getDirtyChunks().markAll();
+
+	vector<uint32_t> counts(snapshot.mHareCounts.size());
+	snapshot.mHareCounts.copyTo(counts.data());
+	mMeanField.setCounts(counts);
+
+	for (uint32_t region = 0; region < snapshot.mCountedRegions.size(); region++)
+		mMeanField.setRegionCounted(region, snapshot.mCountedRegions[region] != 0);
+
+	// Objects are created in their former order and get their former handles
+	vector<uint32_t> generations(objects.size());
+	vector<uint32_t> slots;
+
+	for (uint32_t slot = 0; slot < objects.size(); slot++)
+	{
+		generations[slot] = objects[slot].generation;
+
+		if (objects[slot].type != 0)
+			slots.push_back(slot);
+	}
+
+	sort(begin(slots), end(slots), [&objects](uint32_t a, uint32_t b)
+		{ return objects[a].serial < objects[b].serial; });
+
+	mObjects.clear();
+	mEntities.restore(generations, snapshot.mFreeSlots);
+	mObjectSerials.assign(objects.size(), 0);
+	mDirtyObjects.markAll();
+	mObjectsAdded = snapshot.mObjectsAdded;
+	mObjectCounters.fill(0);
+
+	for (auto slot : slots)
+	{
+		auto& record = objects[slot];
+		auto object = createObject(record.type - 1);
+		object->loadState(record);
+		object->setHandle(EntityHandle{ record.generation << EntityHandle::indexBits | slot });
+		mEntities.set(object->getHandle(), object.get());
+		mObjectSerials[slot] = record.serial;
+		mObjectCounters[record.type - 1]++;
+		mObjects.push_back(object);
+	}
+
+	// Created objects took draws, the saved counter undoes them
+	mRandom.create(snapshot.mRandomSeed);
+	mRandom.setCounter(snapshot.mRandomCounter);
+	mSplitTrials.clear();
+
+	mWolfSpawnStack = stack<glm::tvec2<int32_t>>{};
+	mHareSpawnStack = stack<glm::tvec2<int32_t>>{};
+
+	for (auto& pos : snapshot.mWolfSpawns)
+		mWolfSpawnStack.push(pos);
+
+	for (auto& pos : snapshot.mHareSpawns)
+		mHareSpawnStack.push(pos);
+
+	mIsCountersChanged = true;
+	mSpatialIndexChanged = true;
+	mObstaclesChanged = true;
+	mStaticVersion++;
+	findCorpses();
+}
+
+shared_ptr<GameObject> Board::createObject(uint32_t type)
+{
+	switch (type)
+	{
+	case 0:
+		return make_shared<WolfMale>(mWolfMaleSpriteSheet, *this);
+
+	case 1:
+		return make_shared<WolfFemale>(mWolfFemaleSpriteSheet, *this);
+
+	case 2:
+		return make_shared<Hare>(mHareSpriteSheet, *this);
+
+	case 3:
+		return make_shared<Boulder>(mBoulderSprite);
+
+	default:
+		return make_shared<Bush>(mBushSprite);
+	}
+}
+
+void Board::removeDeadObjects()
 {
 	for (auto it{ begin(mObjects) }; it != end(mObjects);)
 	{
-		if ((*it)->isReadyToDelete())
+		if ((*it)->isReadyToDelete() || (mHeadless && !(*it)->isActive()))
 		{
 			if ((*it)->getObjectType() == "wolf_male")
 				mObjectCounters[0]--;
@@ -213,63 +861,320 @@ void Board::updateTurn(Application& app)
 			else if ((*it)->getObjectType() == "hare")
 				mObjectCounters[2]--;
 			else if ((*it)->getObjectType() == "boulder")
+			{
 				mObjectCounters[3]--;
+				mObstaclesChanged = true;
+				mStaticVersion++;
+			}
 			else if ((*it)->getObjectType() == "bush")
+			{
 				mObjectCounters[4]--;
+				mObstaclesChanged = true;
+				mStaticVersion++;
+			}
 
 			mIsCountersChanged = true;
+			mDirtyObjects.mark((*it)->getHandle().getIndex());
+			mEntities.destroy((*it)->getHandle());
+			mSpatialIndexChanged = true;
 			it = mObjects.erase(it);
 		}
 		else
 			it++;
 	}
+}
+
+void Board::findCorpses()
+{
+	mCorpses.clear();
+
+	for (auto& obj : mObjects)
+	{
+		if (!obj->isActive() && !obj->isReadyToDelete())
+			mCorpses.push_back(obj->getHandle());
+	}
+}
+
+void Board::updateObstacles()
+{
+	vector<glm::tvec2<int32_t>> blocked;
+
+	for (auto& obj : mObjects)
+	{
+		if (obj->getObjectType() == "boulder" || obj->getObjectType() == "bush")
+			blocked.push_back(obj->getPos());
+	}
+
+	mHareField.setBlocked(blocked);
+
+	if (mMeanFieldOptions.enabled)
+		mMeanField.setBlocked(blocked);
+
+	if (mHareEngine == HareEngine::AUTOMATON)
+		mHareAutomaton.setBlocked(blocked);
+
+	mObstaclesChanged = false;
+}
+
+bool Board::isHareFieldNeeded()
+{
+	// Flow distance is at least the distance in moves ignoring obstacles and equals it next to
+	// a hare, so only wolves with the nearest hare 2 to pursuitRange cells away pursue
+	int32_t range = static_cast<int32_t>(mParameters.pursuitRange);
+	bool counted = mMeanFieldOptions.enabled || mHareEngine == HareEngine::AUTOMATON;
+	vector<GameObject*> objects;
+
+	for (auto& obj : mObjects)
+	{
+		if (!obj->isActive() || (obj->getObjectType() != "wolf_male" &&
+			obj->getObjectType() != "wolf_female"))
+			continue;
+
+		auto pos = obj->getPos();
+		int32_t nearest = range + 1;
+
+		// Hares in blocked cells aren't sources of the field
+		auto consider = [this, &pos, &nearest](const glm::tvec2<int32_t>& hare)
+		{
+			auto offset = hare - pos;
+			int32_t distance = max(abs(offset.x), abs(offset.y));
+
+			if (distance < nearest && !mHareField.isBlocked(hare))
+				nearest = distance;
+		};
+
+		objects.clear();
+		getObjects(pos - range, pos + range, objects);
+
+		for (auto hare : objects)
+		{
+			if (hare->isActive() && hare->getObjectType() == "hare")
+				consider(hare->getSavedPos());
+		}
+
+		if (counted)
+		{
+			for (int32_t y = max(pos.y - range, 0); y <= min(pos.y + range,
+				static_cast<int32_t>(mHeight) - 1); y++)
+			{
+				for (int32_t x = max(pos.x - range, 0); x <= min(pos.x + range,
+					static_cast<int32_t>(mWidth) - 1); x++)
+				{
+					if (getHareCount({ x, y }) > 0)
+						consider({ x, y });
+				}
+			}
+		}
+
+		if (nearest > 1 && nearest <= range)
+			return true;
+	}
+
+	return false;
+}
 
-	while (!mHareSpawnStack.empty())
+void Board::updateHareField()
+{
+	vector<glm::tvec2<int32_t>> hares;
+	hares.reserve(mObjectCounters[2]);
+
+	for (auto& obj : mObjects)
 	{
-		app.spawnHare(mHareSpawnStack.top());
-		mHareSpawnStack.pop();
+		if (obj->isActive() && obj->getObjectType() == "hare")
+			hares.push_back(obj->getSavedPos());
 	}
 
-	while (!mWolfSpawnStack.empty())
+	// Counted hares are where the last turn left them, like saved positions
+	auto& counts = mMeanField.getCounts();
+
+	for (uint32_t i = 0; i < counts.size(); i++)
 	{
-		app.spawnWolf(mWolfSpawnStack.top());
-		mWolfSpawnStack.pop();
+		if (counts[i] > 0)
+			hares.push_back({ i % mWidth, i / mWidth });
 	}
+
+	mHareAutomaton.getPositions(hares);
+	mHareField.update(hares);
 }
 
-vector<shared_ptr<GameObject>> Board::getSurroundingObjects(const glm::tvec2<int32_t>& pos)
+void Board::updateMeanField()
 {
-	vector<shared_ptr<GameObject>> vec;
+	mMeanField.update(mParameters, mVegetation.getValues(), mVegetation.getDirtyChunks(), mTurn);
+
+	// Regions switch representation by density of both agents and counts
+	auto totals = mMeanField.getRegionTotals();
 
 	for (auto& obj : mObjects)
 	{
-		auto absDiff{ glm::abs(obj->getSavedPos() - pos) };
+		if (obj->isActive() && obj->getObjectType() == "hare")
+			totals[mMeanField.getRegion(obj->getPos())]++;
+	}
+
+	for (uint32_t region = 0; region < totals.size(); region++)
+	{
+		float density = static_cast<float>(totals[region]) / mMeanField.getRegionCells(region);
+
+		if (mMeanField.isRegionCounted(region))
+		{
+			if (density < mMeanFieldOptions.agentDensity)
+				mMeanField.setRegionCounted(region, false);
+		}
+		else if (density >= mMeanFieldOptions.countDensity)
+			mMeanField.setRegionCounted(region, true);
+	}
+
+	// Agents entering counted regions become counts
+	for (auto it{ begin(mObjects) }; it != end(mObjects);)
+	{
+		if ((*it)->isActive() && (*it)->getObjectType() == "hare" &&
+			mMeanField.isRegionCounted(mMeanField.getRegion((*it)->getPos())))
+		{
+			mMeanField.add((*it)->getPos(), 1);
+			mObjectCounters[2]--;
+			mIsCountersChanged = true;
+			mDirtyObjects.mark((*it)->getHandle().getIndex());
+			mEntities.destroy((*it)->getHandle());
+			mSpatialIndexChanged = true;
+			it = mObjects.erase(it);
+		}
+		else
+			it++;
+	}
+
+	// Counts left in agent regions become agents
+	auto& counts = mMeanField.getCounts();
+
+	for (uint32_t i = 0; i < counts.size(); i++)
+	{
+		glm::tvec2<int32_t> pos{ i % mWidth, i / mWidth };
+
+		if (counts[i] == 0 || mMeanField.isRegionCounted(mMeanField.getRegion(pos)))
+			continue;
 
-		if (obj->isActive() && (absDiff.x == 1 || absDiff.y == 1))
-			vec.push_back(obj);
+		for (uint32_t n = mMeanField.takeAll(i); n > 0; n--)
+			addHare(pos);
 	}
-	
-	return vec;
 }
 
-vector<shared_ptr<GameObject>> Board::getObjects(const glm::tvec2<int32_t>& pos, bool saved)
+Neighbourhood Board::getNeighbourhood(const glm::tvec2<int32_t>& pos)
 {
-	vector<shared_ptr<GameObject>> vec;
+	updateSpatialIndex();
 
-	if (saved)
-		for (auto& obj : mObjects)
+	Neighbourhood neighbourhood;
+	neighbourhood.inside = Neighbourhood::GetInsideMask(pos, mWidth, mHeight);
+
+	mNeighbourHandles.clear();
+	mSpatialIndex.query(pos - glm::tvec2<int32_t>{ 1, 1 }, pos + glm::tvec2<int32_t>{ 1, 1 },
+		mNeighbourHandles);
+
+	for (auto handle : mNeighbourHandles)
+	{
+		auto obj = mEntities.get(handle);
+
+		if (!obj->isActive() || obj->getSavedPos() == pos)
+			continue;
+
+		uint32_t cell = Neighbourhood::GetCell(obj->getSavedPos() - pos);
+		auto& type = obj->getObjectType();
+
+		if (type == "boulder")
+			neighbourhood.boulders |= 1 << cell;
+		else if (type == "bush")
+			neighbourhood.bushes |= 1 << cell;
+		else if (type == "hare")
+		{
+			neighbourhood.hares |= 1 << cell;
+			neighbourhood.hareHandles[cell] = handle;
+		}
+		else if (type == "wolf_female" && static_cast<WolfFemale*>(obj)->canPup())
+			neighbourhood.females |= 1 << cell;
+	}
+
+	// Hares of dense regions are counts without objects
+	if (mMeanFieldOptions.enabled || mHareEngine == HareEngine::AUTOMATON)
+	{
+		for (uint32_t cell = 0; cell < Neighbourhood::cellsCount; cell++)
 		{
-			if (obj->isActive() && obj->getSavedPos() == pos)
-				vec.push_back(obj);
+			if ((neighbourhood.inside & (1 << cell)) &&
+				getHareCount(pos + Neighbourhood::GetOffset(cell)) > 0)
+				neighbourhood.hares |= 1 << cell;
 		}
+	}
+
+	return neighbourhood;
+}
+
+vector<EntityHandle> Board::getObjects(const glm::tvec2<int32_t>& pos, bool saved)
+{
+	vector<EntityHandle> handles;
+
+	if (saved)
+	{
+		updateSpatialIndex();
+		mSpatialIndex.query(pos, pos, handles);
+
+		handles.erase(remove_if(begin(handles), end(handles), [this](EntityHandle handle)
+			{
+				return !mEntities.get(handle)->isActive();
+			}), end(handles));
+	}
 	else
 		for (auto& obj : mObjects)
 		{
 			if (obj->isActive() && obj->getPos() == pos)
-				vec.push_back(obj);
+				handles.push_back(obj->getHandle());
 		}
 
-	return vec;
+	return handles;
+}
+
+void Board::getObjects(const glm::tvec2<int32_t>& first, const glm::tvec2<int32_t>& last,
+	vector<GameObject*>& objects)
+{
+	updateSpatialIndex();
+	mViewHandles.clear();
+	mSpatialIndex.query(first, last, mViewHandles);
+
+	// Buckets are visited by position, objects overlap in the order they were added
+	sort(begin(mViewHandles), end(mViewHandles), [this](EntityHandle a, EntityHandle b)
+		{
+			return mObjectSerials[a.getIndex()] < mObjectSerials[b.getIndex()];
+		});
+
+	for (auto handle : mViewHandles)
+	{
+		if (auto object = mEntities.get(handle))
+			objects.push_back(object);
+	}
+}
+
+GameObject* Board::getObject(EntityHandle handle) const
+{
+	return mEntities.get(handle);
+}
+
+bool Board::allowBirth(const glm::tvec2<int32_t>& pos)
+{
+	if (!mGovernor.isEnabled())
+		return true;
+
+	updateSpatialIndex();
+	auto bucket = mSpatialIndex.getBucket(pos);
+
+	return mGovernor.allowBirth(mObjects.size(), bucket, mSpatialIndex.getBucketCount(bucket),
+		mSpatialIndex.getBucketCells(bucket));
 }
 
+void Board::updateSpatialIndex()
+{
+	if (!mSpatialIndexChanged)
+		return;
+
+	mSpatialIndex.clear();
+
+	for (auto& obj : mObjects)
+		mSpatialIndex.insert(obj->getHandle(), obj->getSavedPos());
+
+	mSpatialIndexChanged = false;
+}
 
@@ -1,55 +1,265 @@
 #pragma once
 #include "Prerequisites.hpp"
 #include "Sprite.hpp"
-#include "VertexBuffer.hpp"
+#include "VertexLayout.hpp"
+#include "SimulationParameters.hpp"
+#include "FlowField.hpp"
+#include "VegetationField.hpp"
+#include "TurnProfile.hpp"
+#include "MeanFieldLayer.hpp"
+#include "HareAutomaton.hpp"
+#include "EntityStore.hpp"
+#include "SpatialIndex.hpp"
+#include "Neighbourhood.hpp"
+#include "PopulationGovernor.hpp"
+#include "JobSystem.hpp"
+#include "CounterRandom.hpp"
+#include "WorldSnapshot.hpp"
 #include "gl_core_3_3.hpp"
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 
+class BoardStateException : public std::exception
+{
+	virtual const char* what() const noexcept
+	{
+		return "Board state doesn't match the board.";
+	}
+};
+
 class Board
 {
 public:
 	Board();
-	
-	Board(std::uint32_t width, std::uint32_t height, 
-		std::shared_ptr<class SpriteSheet> spriteSheet, class Renderer& renderer);
-	void create(std::uint32_t width, std::uint32_t height, 
-		std::shared_ptr<class SpriteSheet> spriteSheet, class Renderer& renderer);
-	
+
+	Board(std::uint32_t width, std::uint32_t height,
+		std::shared_ptr<class SpriteSheet> spriteSheet,
+		std::shared_ptr<const class SpriteArray> sprites, class Renderer& renderer);
+	void create(std::uint32_t width, std::uint32_t height,
+		std::shared_ptr<class SpriteSheet> spriteSheet,
+		std::shared_ptr<const class SpriteArray> sprites, class Renderer& renderer);
+
+	// Headless board without any gpu resources, used by batch simulations
+	Board(std::uint32_t width, std::uint32_t height, std::uint32_t seed);
+	void create(std::uint32_t width, std::uint32_t height, std::uint32_t seed);
+
 	~Board();
 
-	void draw(class Renderer& renderer);
+	// Draws tiles of cells inside the rectangle, corners included. Cells of the border around
+	// the board are -1 and the width or height. Tiles are generated by the shader, so
+	// the ground takes the same memory on any board.
+	void draw(class Renderer& renderer, const glm::tvec2<std::int32_t>& first,
+		const glm::tvec2<std::int32_t>& last);
+
+	// Tiles of the board and its border, and tiles of the last draw
+	std::uint32_t getTilesCount() const;
+	std::uint32_t getDrawnTiles() const;
+
+	// Changes whenever static objects are added or removed, or the board is recreated
+	std::uint32_t getStaticVersion() const;
+
+	// Sprites used by spawned objects, may be left empty on headless boards
+	void setSprites(std::shared_ptr<class SpriteSheet> wolfMaleSpriteSheet,
+		std::shared_ptr<class SpriteSheet> wolfFemaleSpriteSheet,
+		std::shared_ptr<class SpriteSheet> hareSpriteSheet,
+		std::shared_ptr<class Sprite> boulderSprite, std::shared_ptr<class Sprite> bushSprite);
+
+	// Jobs used for parts of the turn and building of vertices, the board runs everything on
+	// the calling thread without them. Has to outlive the board.
+	void setJobSystem(JobSystem* jobs);
 
 	const std::vector<std::shared_ptr<class GameObject>>& getObjects() const;
-	std::vector<std::shared_ptr<class GameObject>> getObjects(const glm::tvec2<std::int32_t>& pos, 
-		bool saved = true);
-	std::vector<std::shared_ptr<class GameObject>> getSurroundingObjects(
-		const glm::tvec2<std::int32_t>& pos);
-	void addGameObject(std::shared_ptr<class GameObject>& object);
+
+	// Active objects at the position in the order they were added. Saved positions are looked
+	// up in the spatial index, current ones are scanned.
+	std::vector<EntityHandle> getObjects(const glm::tvec2<std::int32_t>& pos, bool saved = true);
+
+	// Active objects saved in the 8 neighbouring cells and counted hares of all 9 cells
+	Neighbourhood getNeighbourhood(const glm::tvec2<std::int32_t>& pos);
+
+	// Objects with saved positions inside the rectangle, corners included, in the order they
+	// were added. Objects still shown after being killed are included.
+	void getObjects(const glm::tvec2<std::int32_t>& first, const glm::tvec2<std::int32_t>& last,
+		std::vector<class GameObject*>& objects);
+
+	// Null when the object was already removed from the board
+	class GameObject* getObject(EntityHandle handle) const;
+
+	void addGameObject(const std::shared_ptr<class GameObject>& object);
 	std::uint32_t getWidth() const;
 	std::uint32_t getHeight() const;
+	std::uint32_t getTurn() const;
+	bool isHeadless() const;
+
+	// Placement of objects between turns
+	std::mt19937& getRandomEngine();
+
+	// Draws of turns, batched and the same on every machine. Saved states keep only
+	// its counter.
+	CounterRandom& getRandom();
+
+	// Split trial of the object being updated in the action phase, all trials of a turn are
+	// drawn at once with the split chance
+	bool getSplitTrial() const;
+
+	// Species behaviour, applied to objects created after the change
+	void setParameters(const SimulationParameters& parameters);
+	const SimulationParameters& getParameters() const;
+
+	// Distance and step towards the nearest hare, built from saved positions on turns when
+	// some wolf may pursue a hare. Otherwise it's left from an earlier turn and not current.
+	const FlowField& getHareField() const;
+	bool isHareFieldCurrent() const;
+
+	// Food regrowing every turn, eaten by hares and replenished by bushes
+	VegetationField& getVegetation();
+	const VegetationField& getVegetation() const;
 
+	// Hybrid mode keeping hares of dense regions as per cell counts, disabled by default.
+	// Enabling it resets counted hares.
+	void setMeanField(const MeanFieldOptions& options);
+	const MeanFieldOptions& getMeanFieldOptions() const;
+
+	// Hares kept by the bit parallel automaton instead of agents, for hare dynamics studies.
+	// Switching resets automaton hares, agents already on the board stay.
+	void setHareEngine(HareEngine engine);
+	HareEngine getHareEngine() const;
+
+	// Hares without objects in a cell, from mean field counts or the automaton.
+	// Wolves eat them like agents.
+	std::uint32_t getHareCount(const glm::tvec2<std::int32_t>& pos) const;
+	bool eatCountedHare(const glm::tvec2<std::int32_t>& pos);
+	std::uint64_t getCountedHares() const;
+
+	// Limits of hare and wolf births, disabled by default
+	void setGovernor(const GovernorOptions& options);
+	const PopulationGovernor& getGovernor() const;
+
+	// Time spent in phases of the last turn
+	const TurnProfile& getTurnProfile() const;
+
+	// Queue objects to be spawned at the beginning of the next turn, births refused by
+	// the governor are dropped
 	void spawnWolf(glm::tvec2<std::int32_t> pos);
 	void spawnHare(glm::tvec2<std::int32_t> pos);
 
+	// Create objects immediately
+	void addWolf(glm::tvec2<std::int32_t> pos);
+	void addHare(glm::tvec2<std::int32_t> pos);
+	void addBoulder(glm::tvec2<std::int32_t> pos);
+	void addBush(glm::tvec2<std::int32_t> pos);
+
 	const std::array<std::int32_t, 5>& getObjectCounters();
+
+	// Objects were added or removed since the last published snapshot
 	bool isCountersChanged();
 
-	void updateTurn(class Application& app);
+	// Counts down corpses of objects killed in finished turns, they're removed by the turn
+	// after their time runs out
+	void updateCorpses(float deltaTime);
+
+	// Removes dead objects, spawns queued ones and runs move and action phases
+	void updateTurn();
+
+	// Runs the turn until the time budget is spent, returns true when the turn was finished.
+	// The next call resumes it. Objects are updated in slices, other phases can't be split.
+	bool updateTurn(double budgetSeconds);
+	bool isTurnInProgress() const;
+
+	// Immutable view of everything the next turns depend on, taken between turns. It shares
+	// chunks nothing wrote with the previous published snapshot, and other threads can read it
+	// while the board runs the next turns. The last published one can be got from any thread.
+	std::shared_ptr<const WorldSnapshot> publishSnapshot();
+	std::shared_ptr<const WorldSnapshot> getSnapshot() const;
+
+	// Loading requires the same dimensions, mean field and hare engine, and throws
+	// BoardStateException otherwise
+	void loadSnapshot(const WorldSnapshot& snapshot);
 
 private:
 	std::uint32_t mWidth;
 	std::uint32_t mHeight;
-	
+	std::uint32_t mTurn;
+	bool mHeadless;
+	JobSystem* mJobs;
+	std::mt19937 mRandomEngine;
+	CounterRandom mRandom;
+	std::vector<std::uint8_t> mSplitTrials;
+	SimulationParameters mParameters;
+
 	std::vector<std::shared_ptr<class GameObject>> mObjects;
+	EntityStore mEntities;
+
+	// Order of adding by entity slot, restores the order of objects
+	std::vector<std::uint32_t> mObjectSerials;
+	std::uint32_t mObjectsAdded;
+	std::shared_ptr<const WorldSnapshot> mSnapshot;
+
+	// Entity slots written since the last snapshot
+	DirtyChunks<ObjectState> mDirtyObjects;
+
+	// Objects by saved position, rebuilt after positions are saved or objects removed
+	SpatialIndex mSpatialIndex;
+	bool mSpatialIndexChanged;
+	std::vector<EntityHandle> mNeighbourHandles;
+	std::vector<EntityHandle> mViewHandles;
+
+	// Inactive objects found when turns finish or snapshots are loaded
+	std::vector<EntityHandle> mCorpses;
+	PopulationGovernor mGovernor;
 	std::stack<glm::tvec2<std::int32_t>> mHareSpawnStack;
 	std::stack<glm::tvec2<std::int32_t>> mWolfSpawnStack;
 
 	std::array<std::int32_t, 5> mObjectCounters;
 	bool mIsCountersChanged;
 
-	// Resources
-	std::vector<std::shared_ptr<VertexBuffer<PositionVertexLayout>>> mTileMap;
+	FlowField mHareField;
+	bool mHareFieldCurrent;
+	bool mObstaclesChanged;
+	std::uint32_t mStaticVersion;
+	VegetationField mVegetation;
+	TurnProfile mTurnProfile;
+	MeanFieldOptions mMeanFieldOptions;
+	MeanFieldLayer mMeanField;
+	HareEngine mHareEngine;
+	HareAutomaton mHareAutomaton;
+
+	// State of the turn being run in slices
+	enum class TurnStage
+	{
+		CLEANUP,
+		SPAWN,
+		SAVE_POSITIONS,
+		FLOW_FIELD,
+		MOVE,
+		ACTION,
+		FIELDS
+	} mTurnStage;
+
+	std::uint32_t mTurnCursor;
+	std::uint32_t mTurnObjectsCount;
+
+	// Resources, tiles of every group use their own sprite
+	std::shared_ptr<const class SpriteArray> mSprites;
+	std::shared_ptr<class VertexArray> mGroundQuad;
+	std::array<SpriteInstanceVertexLayout::Data, 9> mGroupTiles;
+	std::uint32_t mDrawnTiles;
 	std::shared_ptr<SpriteSheet> mSpriteSheet;
+	std::shared_ptr<SpriteSheet> mWolfMaleSpriteSheet;
+	std::shared_ptr<SpriteSheet> mWolfFemaleSpriteSheet;
+	std::shared_ptr<SpriteSheet> mHareSpriteSheet;
+	std::shared_ptr<Sprite> mBoulderSprite;
+	std::shared_ptr<Sprite> mBushSprite;
+
+	// Object of the type with index of object counters
+	std::shared_ptr<class GameObject> createObject(std::uint32_t type);
+	void removeDeadObjects();
+	void findCorpses();
+	void updateSpatialIndex();
+	bool allowBirth(const glm::tvec2<std::int32_t>& pos);
+	void updateObstacles();
+	bool isHareFieldNeeded();
+	void updateHareField();
+	void updateMeanField();
 };
 
@@ -1,5 +1,6 @@
 #include "Boulder.hpp"
 #include "Renderer.hpp"
+#include "SpriteBatch.hpp"
 #include "Application.hpp"
 #include <glm/gtx/transform.hpp>
 #include <glm/vec3.hpp>
@@ -35,10 +36,14 @@ const glm::vec2& Boulder::getRealPos()
 	return mRealPos;
 }
 
-void Boulder::draw(Renderer& renderer) const
+void Boulder::draw(SpriteBatch& batch) const
 {
-	renderer.prepareDrawSprite();
-	renderer.drawSprite(*mSprite, glm::translate(glm::vec3{ mRealPos.x, mRealPos.y, 0.0f }));
+	batch.add(*mSprite, mRealPos);
+}
+
+bool Boulder::isStatic() const
+{
+	return true;
 }
 
 void Boulder::updateMove(Board & board)
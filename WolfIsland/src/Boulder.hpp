@@ -13,7 +13,8 @@ public:
 
 	const glm::vec2& getRealPos();
 
-	void draw(class Renderer& renderer) const override;
+	void draw(class SpriteBatch& batch) const override;
+	bool isStatic() const override;
 
 	void updateMove(class Board& board) override;
 	void updateAction(class Board& board) override;
@@ -1,6 +1,8 @@
 #include "Bush.hpp"
 #include "Renderer.hpp"
+#include "SpriteBatch.hpp"
 #include "Application.hpp"
+#include "Board.hpp"
 #include <glm/gtx/transform.hpp>
 #include <glm/vec3.hpp>
 using namespace std;
@@ -35,10 +37,14 @@ const glm::vec2& Bush::getRealPos()
 	return mRealPos;
 }
 
-void Bush::draw(Renderer& renderer) const
+void Bush::draw(SpriteBatch& batch) const
 {
-	renderer.prepareDrawSprite();
-	renderer.drawSprite(*mSprite, glm::translate(glm::vec3{ mRealPos.x, mRealPos.y, 0.0f }));
+	batch.add(*mSprite, mRealPos);
+}
+
+bool Bush::isStatic() const
+{
+	return true;
 }
 
 void Bush::updateMove(Board & board)
@@ -48,7 +54,8 @@ void Bush::updateMove(Board & board)
 
 void Bush::updateAction(Board & board)
 {
-	// Bush do nothing
+	// Bush keeps its cell full of food, it spreads to neighbours with the diffusion
+	board.getVegetation().fill(mPos);
 }
 
 void Bush::update(float deltaTime)
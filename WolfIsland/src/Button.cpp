@@ -33,8 +33,7 @@ Button::~Button()
 
 void Button::draw(Renderer& renderer) const
 {
-	renderer.prepareDrawSprite();
-	renderer.drawSprite(
+	renderer.submitSprite(RenderLayer::GUI,
 		*mGuiSpriteSheet->getSprite(mPressed ? mPressedSpriteIndex : mSpriteIndex).lock(),
 		glm::translate(glm::vec3{ mPos.x, mPos.y, 0.0f }));
 }
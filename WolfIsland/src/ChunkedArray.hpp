@@ -0,0 +1,223 @@
+#pragma once
+#include "Prerequisites.hpp"
+
+template<typename T>
+class DirtyChunks;
+
+
+// Array of values split into chunks of equal size. Chunks are immutable, arrays of
+// consecutive versions share the ones whose values weren't written.
+template<typename T>
+class ChunkedArray
+{
+public:
+	static const std::size_t chunkBytes{ 4096 };
+	static const std::size_t chunkSize{ chunkBytes / sizeof(T) > 0 ? chunkBytes / sizeof(T) : 1 };
+
+	ChunkedArray();
+
+	// Copy of all values
+	ChunkedArray(const T* values, std::size_t count);
+
+	// Next version of the previous array, chunks which aren't dirty are shared without being
+	// read. Dirty chunks are copied from the values.
+	ChunkedArray(const T* values, std::size_t count, const ChunkedArray& previous,
+		const DirtyChunks<T>& dirty);
+
+	// Same, dirty chunks are filled by fill(first, last, values) with values [first, last)
+	template<typename Fill>
+	ChunkedArray(std::size_t count, const ChunkedArray& previous, const DirtyChunks<T>& dirty,
+		Fill fill);
+
+	std::size_t size() const;
+	const T& operator[](std::size_t i) const;
+	void copyTo(T* values) const;
+
+	std::size_t getChunksCount() const;
+	const std::vector<T>& getChunk(std::size_t index) const;
+	std::size_t getSharedChunks(const ChunkedArray& other) const;
+	bool isChunkShared(std::size_t index, const ChunkedArray& other) const;
+
+private:
+	std::vector<std::shared_ptr<const std::vector<T>>> mChunks;
+	std::size_t mSize;
+};
+
+// Chunks of an array written since its last chunked version was taken. Owners of arrays mark
+// values where they write them, so the next version copies only those chunks.
+// All chunks start dirty.
+template<typename T>
+class DirtyChunks
+{
+public:
+	DirtyChunks();
+
+	void mark(std::size_t i);
+
+	// Values [first, last)
+	void mark(std::size_t first, std::size_t last);
+	void markAll();
+
+	// Called when a version was taken
+	void clear();
+
+	bool isDirty(std::size_t chunk) const;
+
+private:
+	std::vector<std::uint8_t> mDirty;
+
+	// Chunks set in mDirty, so clearing takes only the marked ones
+	std::vector<std::size_t> mMarked;
+	bool mAll;
+};
+
+
+template<typename T>
+ChunkedArray<T>::ChunkedArray()
+	: mSize{ 0 }
+{
+}
+
+template<typename T>
+ChunkedArray<T>::ChunkedArray(const T* values, std::size_t count)
+	: ChunkedArray{ values, count, ChunkedArray{}, DirtyChunks<T>{} }
+{
+}
+
+template<typename T>
+ChunkedArray<T>::ChunkedArray(const T* values, std::size_t count, const ChunkedArray& previous,
+	const DirtyChunks<T>& dirty)
+	: ChunkedArray{ count, previous, dirty, [values](std::size_t first, std::size_t last, T* chunk)
+		{ std::copy(values + first, values + last, chunk); } }
+{
+}
+
+template<typename T>
+template<typename Fill>
+ChunkedArray<T>::ChunkedArray(std::size_t count, const ChunkedArray& previous,
+	const DirtyChunks<T>& dirty, Fill fill)
+	: mSize{ count }
+{
+	mChunks.reserve((count + chunkSize - 1) / chunkSize);
+
+	for (std::size_t first = 0; first < count; first += chunkSize)
+	{
+		auto last = std::min(first + chunkSize, count);
+		auto index = first / chunkSize;
+
+		// Chunks at the end of a resized array have other sizes, they're always filled
+		if (!dirty.isDirty(index) && index < previous.mChunks.size() &&
+			previous.mChunks[index]->size() == last - first)
+			mChunks.push_back(previous.mChunks[index]);
+		else
+		{
+			auto chunk = std::make_shared<std::vector<T>>(last - first);
+			fill(first, last, chunk->data());
+			mChunks.push_back(std::move(chunk));
+		}
+	}
+}
+
+template<typename T>
+std::size_t ChunkedArray<T>::size() const
+{
+	return mSize;
+}
+
+template<typename T>
+const T& ChunkedArray<T>::operator[](std::size_t i) const
+{
+	return (*mChunks[i / chunkSize])[i % chunkSize];
+}
+
+template<typename T>
+void ChunkedArray<T>::copyTo(T* values) const
+{
+	for (auto& chunk : mChunks)
+		values = std::copy(chunk->begin(), chunk->end(), values);
+}
+
+template<typename T>
+std::size_t ChunkedArray<T>::getChunksCount() const
+{
+	return mChunks.size();
+}
+
+template<typename T>
+const std::vector<T>& ChunkedArray<T>::getChunk(std::size_t index) const
+{
+	return *mChunks[index];
+}
+
+template<typename T>
+std::size_t ChunkedArray<T>::getSharedChunks(const ChunkedArray& other) const
+{
+	std::size_t shared{ 0 };
+
+	for (std::size_t i = 0; i < std::min(mChunks.size(), other.mChunks.size()); i++)
+		shared += mChunks[i] == other.mChunks[i] ? 1 : 0;
+
+	return shared;
+}
+
+
+template<typename T>
+bool ChunkedArray<T>::isChunkShared(std::size_t index, const ChunkedArray& other) const
+{
+	return index < mChunks.size() && index < other.mChunks.size() &&
+		mChunks[index] == other.mChunks[index];
+}
+
+
+template<typename T>
+DirtyChunks<T>::DirtyChunks()
+	: mAll{ true }
+{
+}
+
+template<typename T>
+void DirtyChunks<T>::mark(std::size_t i)
+{
+	if (mAll)
+		return;
+
+	auto chunk = i / ChunkedArray<T>::chunkSize;
+
+	if (chunk >= mDirty.size())
+		mDirty.resize(chunk + 1, 0);
+
+	if (!mDirty[chunk])
+	{
+		mDirty[chunk] = 1;
+		mMarked.push_back(chunk);
+	}
+}
+
+template<typename T>
+void DirtyChunks<T>::mark(std::size_t first, std::size_t last)
+{
+	for (auto i = first; i < last; i += ChunkedArray<T>::chunkSize - i % ChunkedArray<T>::chunkSize)
+		mark(i);
+}
+
+template<typename T>
+void DirtyChunks<T>::markAll()
+{
+	mAll = true;
+}
+
+template<typename T>
+void DirtyChunks<T>::clear()
+{
+	for (auto chunk : mMarked)
+		mDirty[chunk] = 0;
+
+	mMarked.clear();
+	mAll = false;
+}
+
+template<typename T>
+bool DirtyChunks<T>::isDirty(std::size_t chunk) const
+{
+	return mAll || (chunk < mDirty.size() && mDirty[chunk] != 0);
+}
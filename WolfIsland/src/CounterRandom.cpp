@@ -0,0 +1,235 @@
+#include "CounterRandom.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define COUNTER_RANDOM_AVX2
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace std;
+
+static const uint32_t lanes{ 8 };
+
+
+static inline uint32_t Value(uint32_t low, uint32_t highKey, uint32_t seedKey)
+{
+	return CounterRandom::Hash(CounterRandom::Hash(low + highKey) ^ seedKey);
+}
+
+// Top 32 bits of value * range, a uniform integer from [0, range)
+static inline uint32_t Reduce(uint32_t value, uint32_t range)
+{
+	return static_cast<uint32_t>((static_cast<uint64_t>(value) * range) >> 32);
+}
+
+// Values below the threshold are successes, certain ones have a threshold above all values
+static inline uint64_t GetThreshold(uint32_t numerator, uint32_t denominator)
+{
+	return numerator >= denominator ? uint64_t{ 1 } << 32 :
+		(static_cast<uint64_t>(numerator) << 32) / denominator;
+}
+
+#ifdef COUNTER_RANDOM_AVX2
+AVX2_FUNCTION static inline __m256i HashAvx2(__m256i x)
+{
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int32_t>(0x846ca68bu)));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+
+	return x;
+}
+
+// Blocks of 8 values with the same high part of the counter
+AVX2_FUNCTION static void GenerateAvx2(uint32_t* values, size_t blocks, uint32_t low,
+	uint32_t highKey, uint32_t seedKey)
+{
+	__m256i counter = _mm256_add_epi32(_mm256_set1_epi32(low + highKey),
+		_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	__m256i step = _mm256_set1_epi32(lanes);
+	__m256i key = _mm256_set1_epi32(seedKey);
+
+	for (size_t b = 0; b < blocks; b++)
+	{
+		__m256i v = HashAvx2(_mm256_xor_si256(HashAvx2(counter), key));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(values + b * lanes), v);
+		counter = _mm256_add_epi32(counter, step);
+	}
+}
+
+// Returns the first value that wasn't reduced
+AVX2_FUNCTION static size_t ReduceAvx2(uint32_t* values, size_t count, uint32_t range)
+{
+	__m256i r = _mm256_set1_epi32(range);
+	size_t i = 0;
+
+	for (; i + lanes <= count; i += lanes)
+	{
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+
+		// Products of even and odd lanes, their high halves are the results
+		__m256i even = _mm256_srli_epi64(_mm256_mul_epu32(v, r), 32);
+		__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(v, 32), r);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i),
+			_mm256_blend_epi32(even, odd, 0xaa));
+	}
+
+	return i;
+}
+#endif
+
+
+CounterRandom::CounterRandom()
+	: mSeed{ 0 }, mCounter{ 0 }, mSimdEnabled{ IsAvx2Supported() },
+	mBufferPos{ 0 }
+{
+	create(0);
+}
+
+CounterRandom::CounterRandom(uint32_t seed)
+	: mSeed{ 0 }, mCounter{ 0 }, mSimdEnabled{ IsAvx2Supported() },
+	mBufferPos{ 0 }
+{
+	create(seed);
+}
+
+void CounterRandom::create(uint32_t seed)
+{
+	mSeed = seed;
+	mCounter = 0;
+	mBufferPos = mBuffer.size();
+}
+
+CounterRandom::~CounterRandom()
+{
+}
+
+uint32_t CounterRandom::next()
+{
+	if (mBufferPos == mBuffer.size())
+	{
+		generate(mBuffer.data(), mBuffer.size());
+		mBufferPos = 0;
+	}
+
+	return mBuffer[mBufferPos++];
+}
+
+uint32_t CounterRandom::next(uint32_t range)
+{
+	return Reduce(next(), range);
+}
+
+bool CounterRandom::nextTrial(uint32_t numerator, uint32_t denominator)
+{
+	return next() < GetThreshold(numerator, denominator);
+}
+
+float CounterRandom::nextReal()
+{
+	// 24 bits fit the mantissa, so the result is never rounded up to 1
+	return static_cast<float>(next() >> 8) / (1 << 24);
+}
+
+void CounterRandom::fill(uint32_t* values, size_t count)
+{
+	// Buffered values come first to keep the order of the stream
+	size_t buffered = min<size_t>(count, mBuffer.size() - mBufferPos);
+	copy_n(mBuffer.data() + mBufferPos, buffered, values);
+	mBufferPos += buffered;
+
+	generate(values + buffered, count - buffered);
+}
+
+void CounterRandom::fillUniform(uint32_t* values, size_t count, uint32_t range)
+{
+	fill(values, count);
+	size_t i = 0;
+
+#ifdef COUNTER_RANDOM_AVX2
+	if (mSimdEnabled)
+		i = ReduceAvx2(values, count, range);
+#endif
+
+	for (; i < count; i++)
+		values[i] = Reduce(values[i], range);
+}
+
+void CounterRandom::fillTrials(uint8_t* values, size_t count, uint32_t numerator,
+	uint32_t denominator)
+{
+	auto threshold = GetThreshold(numerator, denominator);
+	array<uint32_t, 256> batch;
+
+	for (size_t first = 0; first < count; first += batch.size())
+	{
+		size_t size = min(batch.size(), count - first);
+		fill(batch.data(), size);
+
+		for (size_t i = 0; i < size; i++)
+			values[first + i] = batch[i] < threshold ? 1 : 0;
+	}
+}
+
+uint32_t CounterRandom::getSeed() const
+{
+	return mSeed;
+}
+
+uint64_t CounterRandom::getCounter() const
+{
+	return mCounter - (mBuffer.size() - mBufferPos);
+}
+
+void CounterRandom::setCounter(uint64_t counter)
+{
+	mCounter = counter;
+	mBufferPos = mBuffer.size();
+}
+
+void CounterRandom::setSimdEnabled(bool enabled)
+{
+	mSimdEnabled = enabled && IsAvx2Supported();
+}
+
+bool CounterRandom::isSimdEnabled() const
+{
+	return mSimdEnabled;
+}
+
+void CounterRandom::generate(uint32_t* values, size_t count)
+{
+	uint32_t seedKey = Hash(mSeed);
+	size_t i = 0;
+
+	while (i < count)
+	{
+		auto low = static_cast<uint32_t>(mCounter);
+		auto highKey = Hash(static_cast<uint32_t>(mCounter >> 32) ^ seedKey);
+
+		// Values up to the next wrap of the low part share the high key
+		size_t size = static_cast<size_t>(min<uint64_t>(count - i, (uint64_t{ 1 } << 32) - low));
+		size_t done = 0;
+
+#ifdef COUNTER_RANDOM_AVX2
+		if (mSimdEnabled)
+		{
+			done = size / lanes * lanes;
+			GenerateAvx2(values + i, done / lanes, low, highKey, seedKey);
+		}
+#endif
+
+		for (; done < size; done++)
+			values[i + done] = Value(low + static_cast<uint32_t>(done), highKey, seedKey);
+
+		i += size;
+		mCounter += size;
+	}
+}
+
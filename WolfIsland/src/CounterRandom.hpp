@@ -0,0 +1,72 @@
+#pragma once
+#include "Prerequisites.hpp"
+
+
+// Counter based random numbers, value n of the stream is a hash of the seed and n.
+// Batches are generated 8 values at a time with AVX2 when the processor supports it and
+// are identical to the scalar path, so a seed gives the same simulation on every machine.
+// Single draws are taken from a buffer filled in batches.
+class CounterRandom
+{
+public:
+	CounterRandom();
+
+	CounterRandom(std::uint32_t seed);
+	void create(std::uint32_t seed);
+
+	~CounterRandom();
+
+	std::uint32_t next();
+
+	// Uniform integer from [0, range), range has to be positive
+	std::uint32_t next(std::uint32_t range);
+
+	// True with probability numerator / denominator
+	bool nextTrial(std::uint32_t numerator, std::uint32_t denominator);
+
+	// Uniform real from [0, 1)
+	float nextReal();
+
+	// Next values of the stream, the same ones single draws would give
+	void fill(std::uint32_t* values, std::size_t count);
+	void fillUniform(std::uint32_t* values, std::size_t count, std::uint32_t range);
+	void fillTrials(std::uint8_t* values, std::size_t count, std::uint32_t numerator,
+		std::uint32_t denominator);
+
+	std::uint32_t getSeed() const;
+
+	// Values drawn since the seed was set. Setting it continues the stream from there,
+	// like after as many draws.
+	std::uint64_t getCounter() const;
+	void setCounter(std::uint64_t counter);
+
+	// Forces the scalar path, used to compare both paths
+	void setSimdEnabled(bool enabled);
+	bool isSimdEnabled() const;
+
+	// Bijective 32 bit mix, shared by layers hashing cells and turns
+	static std::uint32_t Hash(std::uint32_t x);
+
+private:
+	std::uint32_t mSeed;
+	std::uint64_t mCounter;
+	bool mSimdEnabled;
+
+	std::array<std::uint32_t, 256> mBuffer;
+	std::uint32_t mBufferPos;
+
+	void generate(std::uint32_t* values, std::size_t count);
+};
+
+// Inlined, cell layers hash every cell
+inline std::uint32_t CounterRandom::Hash(std::uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+
+	return x;
+}
+
@@ -0,0 +1,471 @@
+#include "EnsembleRunner.hpp"
+#include "Board.hpp"
+using namespace std;
+
+static const string journalHeader{ "ensemble" };
+static const array<double, 5> reportedPercentiles{ 0.05, 0.25, 0.5, 0.75, 0.95 };
+static const chrono::seconds progressInterval{ 1 };
+
+// FNV-1a, stable between builds unlike std::hash
+static const uint64_t hashOffset{ 14695981039346656037ull };
+static const uint64_t hashPrime{ 1099511628211ull };
+
+
+EnsembleRunner::EnsembleRunner()
+	: mThreads{ 0 }, mCompletedRuns{ 0 }
+{
+}
+
+EnsembleRunner::EnsembleRunner(const vector<EnsembleRun>& runs, uint32_t threads,
+	const string& journalPath)
+	: mThreads{ 0 }, mCompletedRuns{ 0 }
+{
+	create(runs, threads, journalPath);
+}
+
+void EnsembleRunner::create(const vector<EnsembleRun>& runs, uint32_t threads,
+	const string& journalPath)
+{
+	mRuns = runs;
+	mCompleted.assign(mRuns.size(), false);
+	mThreads = threads != 0 ? threads : max(thread::hardware_concurrency(), 1u);
+	mJobs.create(mThreads);
+	mJournalPath = journalPath;
+
+	mWolfSamples.clear();
+	mHareSamples.clear();
+	mObservedRuns.clear();
+	mCensoredRuns.clear();
+	mWolfExtinctionTurns.clear();
+	mHareExtinctionTurns.clear();
+	mLastTurns.clear();
+	mStopReasons.fill(0);
+	mProfile.clear();
+	mGovernor.clear();
+	mCompletedRuns = 0;
+
+	if (!mJournalPath.empty())
+		loadJournal();
+}
+
+EnsembleRunner::~EnsembleRunner()
+{
+}
+
+void EnsembleRunner::run(ostream& progress)
+{
+	mPending.clear();
+
+	for (uint32_t i = 0; i < mRuns.size(); i++)
+	{
+		if (!mCompleted[i])
+			mPending.push_back(i);
+	}
+
+	ofstream journal;
+	bool newJournal{ false };
+
+	if (!mJournalPath.empty())
+	{
+		ifstream existing{ mJournalPath };
+		newJournal = !existing.good() || existing.peek() == ifstream::traits_type::eof();
+		existing.close();
+		journal.open(mJournalPath, ios_base::app);
+
+		// Starts on a fresh line in case the last entry was cut by a crash
+		if (newJournal)
+			journal << journalHeader << " " << mRuns.size() << " " << HashRuns(mRuns) << endl;
+		else
+			journal << endl;
+	}
+
+	mJobs.resetWorkerStats();
+	vector<JobHandle> jobs;
+	ofstream* journalOutput = journal.is_open() ? &journal : nullptr;
+
+	for (auto index : mPending)
+		jobs.push_back(mJobs.add([this, index, journalOutput]() { simulate(index, journalOutput); }));
+
+	auto start = chrono::steady_clock::now();
+	uint32_t alreadyCompleted = mRuns.size() - mPending.size();
+
+	{
+		unique_lock<mutex> lock{ mMutex };
+
+		while (true)
+		{
+			chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+			ostringstream rate;
+			rate << fixed << setprecision(1)
+				<< (mCompletedRuns - alreadyCompleted) / max(elapsed.count(), 1e-3);
+
+			progress << "Completed " << mCompletedRuns << "/" << mRuns.size() << " runs ("
+				<< rate.str() << " runs/s)" << endl;
+
+			if (mCompletedRuns == mRuns.size())
+				break;
+
+			mProgressCondition.wait_for(lock, progressInterval,
+				[this]() { return mCompletedRuns == mRuns.size(); });
+		}
+	}
+
+	mJobs.wait(jobs);
+	mWorkerStats = mJobs.getWorkerStats();
+}
+
+void EnsembleRunner::writeStatistics(ostream& output)
+{
+	lock_guard<mutex> lock{ mMutex };
+
+	auto writeExtinction = [&output, this](const string& name,
+		const vector<int32_t>& extinctionTurns)
+	{
+		vector<uint32_t> turns;
+
+		for (auto t : extinctionTurns)
+		{
+			if (t >= 0)
+				turns.push_back(static_cast<uint32_t>(t));
+		}
+
+		output << "# " << name << "_extinction_probability "
+			<< ExtinctionProbability(extinctionTurns, mLastTurns) << endl;
+
+		if (turns.empty())
+			return;
+
+		for (auto p : reportedPercentiles)
+		{
+			output << "# " << name << "_extinction_turn_p" << static_cast<int>(p * 100.0) << " "
+				<< Percentile(turns, p) << endl;
+		}
+	};
+
+	output << "# runs " << mCompletedRuns << endl;
+
+	uint32_t censoredRuns{ 0 };
+
+	for (uint32_t i = 0; i < mStopReasons.size(); i++)
+	{
+		if (PopulationMonitor::IsCensoring(static_cast<StopReason>(i)))
+			censoredRuns += mStopReasons[i];
+	}
+
+	output << "# censored_runs " << censoredRuns << endl;
+
+	for (uint32_t i = 1; i < mStopReasons.size(); i++)
+	{
+		output << "# stopped_" << PopulationMonitor::GetReasonName(static_cast<StopReason>(i))
+			<< " " << mStopReasons[i] << endl;
+	}
+
+	writeExtinction("wolf", mWolfExtinctionTurns);
+	writeExtinction("hare", mHareExtinctionTurns);
+
+	// Runs loaded from the journal have no profile and governor telemetry
+	for (uint32_t i = 0; i < TurnProfile::phasesCount; i++)
+	{
+		auto phase = static_cast<TurnPhase>(i);
+		output << "# profile_" << TurnProfile::GetPhaseName(phase) << "_us_per_turn "
+			<< (mProfile.turns == 0 ? 0.0 : mProfile.get(phase) * 1e6 / mProfile.turns) << endl;
+	}
+
+	output << "# governor_births " << mGovernor.births << endl;
+	output << "# governor_suppressed_entities " << mGovernor.suppressedByEntities << endl;
+	output << "# governor_suppressed_region " << mGovernor.suppressedByRegion << endl;
+	output << "# governor_intervention_turns " << mGovernor.interventionTurns << "/"
+		<< mGovernor.turns << endl;
+
+	for (uint32_t i = 0; i < mWorkerStats.size(); i++)
+	{
+		output << "# worker_" << i << "_utilisation " << mWorkerStats[i].utilisation << " jobs "
+			<< mWorkerStats[i].jobs << " steals " << mWorkerStats[i].steals << endl;
+	}
+
+	output << "turn,runs,observed_runs,censored_runs";
+
+	for (auto& name : { "wolves", "hares" })
+	{
+		for (auto p : reportedPercentiles)
+			output << "," << name << "_p" << static_cast<int>(p * 100.0);
+	}
+
+	output << endl;
+
+	for (uint32_t turn = 0; turn < mWolfSamples.size(); turn++)
+	{
+		output << turn << "," << mWolfSamples[turn].size() << "," << mObservedRuns[turn] << ","
+			<< mCensoredRuns[turn];
+
+		for (auto p : reportedPercentiles)
+			output << "," << Percentile(mWolfSamples[turn], p);
+
+		for (auto p : reportedPercentiles)
+			output << "," << Percentile(mHareSamples[turn], p);
+
+		output << endl;
+	}
+}
+
+uint32_t EnsembleRunner::getCompletedRuns() const
+{
+	return mCompletedRuns;
+}
+
+uint32_t EnsembleRunner::getRunsCount() const
+{
+	return mRuns.size();
+}
+
+void EnsembleRunner::simulate(uint32_t index, ofstream* journal)
+{
+	auto result = Simulate(mRuns[index]);
+	result.index = index;
+
+	lock_guard<mutex> lock{ mMutex };
+	merge(result);
+
+	if (journal)
+	{
+		WriteJournalEntry(*journal, result);
+		journal->flush();
+	}
+
+	mProgressCondition.notify_all();
+}
+
+EnsembleResult EnsembleRunner::Simulate(const EnsembleRun& setup)
+{
+	Board board{ setup.width, setup.height, setup.seed };
+	board.setParameters(setup.parameters);
+	board.setMeanField(setup.meanField);
+	board.setHareEngine(setup.hareEngine);
+	board.setGovernor(setup.governor);
+
+	uniform_int_distribution<int32_t> distWidth{ 0, static_cast<int32_t>(setup.width) - 1 };
+	uniform_int_distribution<int32_t> distHeight{ 0, static_cast<int32_t>(setup.height) - 1 };
+
+	for (uint32_t i = 0; i < setup.wolves; i++)
+		board.addWolf({ distWidth(board.getRandomEngine()), distHeight(board.getRandomEngine()) });
+
+	for (uint32_t i = 0; i < setup.hares; i++)
+		board.addHare({ distWidth(board.getRandomEngine()), distHeight(board.getRandomEngine()) });
+
+	// Only agent hares are limited by the governor
+	bool agents = setup.hareEngine == HareEngine::AGENTS && !setup.meanField.enabled;
+	PopulationMonitor monitor{ setup.termination, agents ? board.getGovernor().getEntityLimit() :
+		numeric_limits<uint32_t>::max() };
+
+	EnsembleResult result;
+	result.index = 0;
+	result.wolfExtinctionTurn = -1;
+	result.hareExtinctionTurn = -1;
+	result.stopReason = StopReason::NONE;
+	result.wolfCounts.reserve(setup.turns + 1);
+	result.hareCounts.reserve(setup.turns + 1);
+
+	for (uint32_t turn = 0; turn <= setup.turns; turn++)
+	{
+		if (turn > 0)
+		{
+			board.updateTurn();
+			result.profile.add(board.getTurnProfile());
+		}
+
+		auto& counters = board.getObjectCounters();
+		uint32_t wolves = counters[0] + counters[1];
+		uint32_t hares = counters[2] + static_cast<uint32_t>(board.getCountedHares());
+
+		result.wolfCounts.push_back(wolves);
+		result.hareCounts.push_back(hares);
+
+		if (wolves == 0 && result.wolfExtinctionTurn < 0)
+			result.wolfExtinctionTurn = turn;
+
+		if (hares == 0 && result.hareExtinctionTurn < 0)
+			result.hareExtinctionTurn = turn;
+
+		result.stopReason = monitor.update(wolves, hares);
+
+		if (result.stopReason != StopReason::NONE)
+			break;
+	}
+
+	result.governor = board.getGovernor().getTelemetry();
+	return result;
+}
+
+void EnsembleRunner::merge(const EnsembleResult& result)
+{
+	// Runs stopped by extinction stay in their last state until their last turn, censored
+	// runs are unknown after their stop
+	uint32_t observed = result.wolfCounts.size();
+	uint32_t turns = observed == 0 ? 0 : max(observed, mRuns[result.index].turns + 1);
+	bool censored = PopulationMonitor::IsCensoring(result.stopReason);
+
+	if (mWolfSamples.size() < turns)
+	{
+		mWolfSamples.resize(turns);
+		mHareSamples.resize(turns);
+		mObservedRuns.resize(turns, 0);
+		mCensoredRuns.resize(turns, 0);
+	}
+
+	for (uint32_t turn = 0; turn < turns; turn++)
+	{
+		if (censored && turn >= observed)
+		{
+			mCensoredRuns[turn]++;
+			continue;
+		}
+
+		uint32_t sample = min(turn, observed - 1);
+		mWolfSamples[turn].push_back(result.wolfCounts[sample]);
+		mHareSamples[turn].push_back(result.hareCounts[sample]);
+
+		if (turn < observed)
+			mObservedRuns[turn]++;
+	}
+
+	mWolfExtinctionTurns.push_back(result.wolfExtinctionTurn);
+	mHareExtinctionTurns.push_back(result.hareExtinctionTurn);
+	mLastTurns.push_back(static_cast<int32_t>(censored ? observed : turns) - 1);
+	mStopReasons[static_cast<uint32_t>(result.stopReason)]++;
+	mProfile.add(result.profile);
+	mGovernor.add(result.governor);
+	mCompleted[result.index] = true;
+	mCompletedRuns++;
+}
+
+void EnsembleRunner::loadJournal()
+{
+	ifstream journal{ mJournalPath };
+
+	if (!journal.good())
+		return;
+
+	string header;
+	size_t runs;
+	uint64_t setupHash;
+
+	if (!(journal >> header))
+		return;
+
+	if (header != journalHeader || !(journal >> runs >> setupHash) || runs != mRuns.size() ||
+		setupHash != HashRuns(mRuns))
+		throw EnsembleJournalException();
+
+	string line;
+
+	while (getline(journal, line))
+	{
+		istringstream entry{ line };
+		EnsembleResult result;
+		uint32_t stopReason;
+		uint32_t turns;
+
+		if (!(entry >> result.index >> result.wolfExtinctionTurn >> result.hareExtinctionTurn
+			>> stopReason >> turns) || stopReason >= mStopReasons.size())
+			continue;
+
+		result.stopReason = static_cast<StopReason>(stopReason);
+		result.wolfCounts.resize(turns);
+		result.hareCounts.resize(turns);
+
+		for (uint32_t i = 0; i < turns; i++)
+			entry >> result.wolfCounts[i] >> result.hareCounts[i];
+
+		// Entry could be cut by a crash while it was written
+		if (!entry || result.index >= mRuns.size() || mCompleted[result.index])
+			continue;
+
+		merge(result);
+	}
+}
+
+void EnsembleRunner::WriteJournalEntry(ostream& output, const EnsembleResult& result)
+{
+	output << result.index << " " << result.wolfExtinctionTurn << " "
+		<< result.hareExtinctionTurn << " " << static_cast<uint32_t>(result.stopReason) << " "
+		<< result.wolfCounts.size();
+
+	for (uint32_t i = 0; i < result.wolfCounts.size(); i++)
+		output << " " << result.wolfCounts[i] << " " << result.hareCounts[i];
+
+	output << "\n";
+}
+
+uint64_t EnsembleRunner::HashRuns(const vector<EnsembleRun>& runs)
+{
+	// Written as text, so doubles and floats hash alike on every platform
+	ostringstream setup;
+	setup << setprecision(17);
+
+	for (auto& run : runs)
+	{
+		setup << run.width << " " << run.height << " " << run.wolves << " " << run.hares << " "
+			<< run.turns << " " << run.seed;
+
+		for (auto& name : SimulationParameters::GetNames())
+			setup << " " << run.parameters.get(name);
+
+		auto& termination = run.termination;
+		setup << " " << termination.wolfExtinction << " " << termination.hareExtinction << " "
+			<< termination.boomCap << " " << termination.window << " " << termination.steadyState
+			<< " " << termination.periodicOrbit << " " << termination.steadyTolerance << " "
+			<< termination.orbitTolerance;
+
+		setup << " " << run.meanField.enabled << " " << run.meanField.regionSize << " "
+			<< run.meanField.countDensity << " " << run.meanField.agentDensity << " "
+			<< static_cast<uint32_t>(run.hareEngine) << " " << run.governor.maxEntities << " "
+			<< run.governor.memoryBudget << " " << run.governor.regionCapacity << "\n";
+	}
+
+	uint64_t hash = hashOffset;
+
+	for (auto c : setup.str())
+		hash = (hash ^ static_cast<uint8_t>(c)) * hashPrime;
+
+	return hash;
+}
+
+double EnsembleRunner::Percentile(vector<uint32_t>& samples, double percentile)
+{
+	if (samples.empty())
+		return 0.0;
+
+	auto nth = begin(samples) + static_cast<size_t>(percentile * (samples.size() - 1) + 0.5);
+	nth_element(begin(samples), nth, end(samples));
+
+	return *nth;
+}
+
+double EnsembleRunner::ExtinctionProbability(const vector<int32_t>& extinctionTurns,
+	const vector<int32_t>& lastTurns)
+{
+	// Runs end with their extinction or leave the risk set after their last known turn,
+	// extinctions of a turn come before runs leaving at it
+	vector<pair<int32_t, bool>> ends;
+
+	for (size_t i = 0; i < extinctionTurns.size(); i++)
+	{
+		bool extinct = extinctionTurns[i] >= 0 && extinctionTurns[i] <= lastTurns[i];
+		ends.emplace_back(extinct ? extinctionTurns[i] : lastTurns[i], !extinct);
+	}
+
+	sort(begin(ends), end(ends));
+
+	double survival{ 1.0 };
+	size_t atRisk = ends.size();
+
+	for (auto& end : ends)
+	{
+		if (!end.second)
+			survival *= 1.0 - 1.0 / atRisk;
+
+		atRisk--;
+	}
+
+	return 1.0 - survival;
+}
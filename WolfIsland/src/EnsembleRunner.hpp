@@ -0,0 +1,125 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "SimulationParameters.hpp"
+#include "PopulationMonitor.hpp"
+#include "TurnProfile.hpp"
+#include "MeanFieldLayer.hpp"
+#include "HareAutomaton.hpp"
+#include "PopulationGovernor.hpp"
+#include "JobSystem.hpp"
+
+
+class EnsembleJournalException : public std::exception
+{
+	virtual const char* what() const noexcept
+	{
+		return "Ensemble journal doesn't match the requested runs.";
+	}
+};
+
+// Setup of a single headless simulation
+struct EnsembleRun
+{
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t wolves;
+	std::uint32_t hares;
+	std::uint32_t turns;
+	std::uint32_t seed;
+	SimulationParameters parameters;
+	TerminationPolicy termination;
+	MeanFieldOptions meanField;
+	HareEngine hareEngine;
+	GovernorOptions governor;
+};
+
+// Population history of a single headless simulation
+struct EnsembleResult
+{
+	std::uint32_t index;
+	std::int32_t wolfExtinctionTurn;
+	std::int32_t hareExtinctionTurn;
+	StopReason stopReason;
+	TurnProfile profile;
+	GovernorTelemetry governor;
+	std::vector<std::uint32_t> wolfCounts;
+	std::vector<std::uint32_t> hareCounts;
+};
+
+// Runs many independent headless islands on all cores and aggregates per turn statistics.
+// Finished runs are appended to a journal, so an interrupted ensemble can be resumed. The
+// journal header holds a hash of the setup of every run, journals of other runs are rejected.
+// Runs stopped by extinction are in a state they can't leave, they keep their last counts until
+// their last turn. Runs stopped by other detectors are censored: they're left out of turns after
+// their stop, and extinction probabilities are Kaplan-Meier estimates which count them only
+// while they were observed.
+class EnsembleRunner
+{
+public:
+	EnsembleRunner();
+
+	EnsembleRunner(const std::vector<EnsembleRun>& runs, std::uint32_t threads = 0,
+		const std::string& journalPath = std::string{});
+	void create(const std::vector<EnsembleRun>& runs, std::uint32_t threads = 0,
+		const std::string& journalPath = std::string{});
+
+	~EnsembleRunner();
+
+	// Runs all unfinished simulations and blocks until they are done
+	void run(std::ostream& progress);
+
+	// Writes percentiles of population counts for every turn with runs reaching it, extinction summary, average
+	// time of turn phases, births suppressed by the governor and utilisation of workers
+	void writeStatistics(std::ostream& output);
+
+	std::uint32_t getCompletedRuns() const;
+	std::uint32_t getRunsCount() const;
+
+	// Runs a single island from random initial placement, counts are recorded for every turn
+	// until the last one or until the termination policy stops the run
+	static EnsembleResult Simulate(const EnsembleRun& setup);
+
+private:
+	std::vector<EnsembleRun> mRuns;
+	std::vector<bool> mCompleted;
+	std::vector<std::uint32_t> mPending;
+	std::uint32_t mThreads;
+	std::string mJournalPath;
+
+	// Aggregated statistics, outer index is the turn number. Observed runs reached the turn,
+	// samples of extinct runs are carried forward, censored runs stopped before it.
+	std::vector<std::vector<std::uint32_t>> mWolfSamples;
+	std::vector<std::vector<std::uint32_t>> mHareSamples;
+	std::vector<std::uint32_t> mObservedRuns;
+	std::vector<std::uint32_t> mCensoredRuns;
+	std::vector<std::int32_t> mWolfExtinctionTurns;
+	std::vector<std::int32_t> mHareExtinctionTurns;
+
+	// Last turn with known counts of every run
+	std::vector<std::int32_t> mLastTurns;
+	std::array<std::uint32_t, 6> mStopReasons;
+	TurnProfile mProfile;
+	GovernorTelemetry mGovernor;
+
+	// Every run is a job, workers are busy only with runs of this ensemble
+	JobSystem mJobs;
+	std::vector<JobWorkerStats> mWorkerStats;
+
+	std::mutex mMutex;
+	std::condition_variable mProgressCondition;
+
+	// Written under the mutex, read by progress reporters without it
+	std::atomic<std::uint32_t> mCompletedRuns;
+
+	void simulate(std::uint32_t index, std::ofstream* journal);
+	void merge(const EnsembleResult& result);
+	void loadJournal();
+	static void WriteJournalEntry(std::ostream& output, const EnsembleResult& result);
+	static std::uint64_t HashRuns(const std::vector<EnsembleRun>& runs);
+	static double Percentile(std::vector<std::uint32_t>& samples, double percentile);
+
+	// Kaplan-Meier estimate of extinction by the last turn of the runs
+	static double ExtinctionProbability(const std::vector<std::int32_t>& extinctionTurns,
+		const std::vector<std::int32_t>& lastTurns);
+};
+
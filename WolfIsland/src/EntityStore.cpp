@@ -0,0 +1,148 @@
+#include "EntityStore.hpp"
+using namespace std;
+
+// Generations wrap around and skip 0, so no live handle is null
+static const uint32_t generationsCount{ 1u << (32 - EntityHandle::indexBits) };
+
+
+EntityHandle::EntityHandle()
+	: value{ 0 }
+{
+}
+
+EntityHandle::EntityHandle(uint32_t value)
+	: value{ value }
+{
+}
+
+uint32_t EntityHandle::getIndex() const
+{
+	return value & indexMask;
+}
+
+uint32_t EntityHandle::getGeneration() const
+{
+	return value >> indexBits;
+}
+
+bool EntityHandle::isNull() const
+{
+	return value == 0;
+}
+
+bool EntityHandle::operator==(const EntityHandle& other) const
+{
+	return value == other.value;
+}
+
+bool EntityHandle::operator!=(const EntityHandle& other) const
+{
+	return value != other.value;
+}
+
+
+EntityStore::EntityStore()
+	: mCount{ 0 }
+{
+}
+
+EntityStore::~EntityStore()
+{
+}
+
+void EntityStore::clear()
+{
+	mSlots.clear();
+	mFreeSlots.clear();
+	mCount = 0;
+}
+
+EntityHandle EntityStore::create(GameObject* object)
+{
+	uint32_t index;
+
+	if (!mFreeSlots.empty())
+	{
+		index = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else
+	{
+		if (mSlots.size() > EntityHandle::indexMask)
+			throw EntityStoreFullException();
+
+		index = mSlots.size();
+		mSlots.push_back({ nullptr, 1 });
+	}
+
+	mSlots[index].object = object;
+	mCount++;
+
+	return EntityHandle{ mSlots[index].generation << EntityHandle::indexBits | index };
+}
+
+void EntityStore::destroy(EntityHandle handle)
+{
+	if (!isValid(handle))
+		return;
+
+	auto& slot = mSlots[handle.getIndex()];
+	slot.object = nullptr;
+	slot.generation = slot.generation + 1 == generationsCount ? 1 : slot.generation + 1;
+	mFreeSlots.push_back(handle.getIndex());
+	mCount--;
+}
+
+GameObject* EntityStore::get(EntityHandle handle) const
+{
+	return isValid(handle) ? mSlots[handle.getIndex()].object : nullptr;
+}
+
+bool EntityStore::isValid(EntityHandle handle) const
+{
+	return handle.getIndex() < mSlots.size() && !handle.isNull() &&
+		mSlots[handle.getIndex()].generation == handle.getGeneration() &&
+		mSlots[handle.getIndex()].object != nullptr;
+}
+
+uint32_t EntityStore::getCount() const
+{
+	return mCount;
+}
+
+uint32_t EntityStore::getSlotsCount() const
+{
+	return mSlots.size();
+}
+
+uint32_t EntityStore::getGeneration(uint32_t slot) const
+{
+	return mSlots[slot].generation;
+}
+
+const vector<uint32_t>& EntityStore::getFreeSlots() const
+{
+	return mFreeSlots;
+}
+
+void EntityStore::restore(const vector<uint32_t>& generations, const vector<uint32_t>& freeSlots)
+{
+	mSlots.resize(generations.size());
+
+	for (uint32_t i = 0; i < mSlots.size(); i++)
+		mSlots[i] = { nullptr, generations[i] };
+
+	mFreeSlots = freeSlots;
+	mCount = 0;
+}
+
+void EntityStore::set(EntityHandle handle, GameObject* object)
+{
+	auto& slot = mSlots[handle.getIndex()];
+
+	if (slot.object == nullptr)
+		mCount++;
+
+	slot.object = object;
+	slot.generation = handle.getGeneration();
+}
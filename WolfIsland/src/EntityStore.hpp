@@ -0,0 +1,75 @@
+#pragma once
+#include "Prerequisites.hpp"
+
+
+// Weak 32 bit reference to an entity of the store, the low bits are the slot and the high
+// bits its generation. A handle becomes stale when its entity is destroyed, even when the
+// slot is reused later. Value 0 is never given to an entity.
+struct EntityHandle
+{
+	EntityHandle();
+	explicit EntityHandle(std::uint32_t value);
+
+	static const std::uint32_t indexBits{ 22 };
+	static const std::uint32_t indexMask{ (1u << indexBits) - 1 };
+
+	std::uint32_t value;
+
+	std::uint32_t getIndex() const;
+	std::uint32_t getGeneration() const;
+	bool isNull() const;
+
+	bool operator==(const EntityHandle& other) const;
+	bool operator!=(const EntityHandle& other) const;
+};
+
+class EntityStoreFullException : public std::exception
+{
+	virtual const char* what() const noexcept
+	{
+		return "Entity store has no free slots.";
+	}
+};
+
+// Slots of entities addressed by handles. Handles are checked in O(1) by comparing
+// generations and nothing is reference counted, owners of entities keep them alive.
+class EntityStore
+{
+public:
+	EntityStore();
+	~EntityStore();
+
+	void clear();
+
+	EntityHandle create(class GameObject* object);
+	void destroy(EntityHandle handle);
+
+	// Null for stale handles
+	class GameObject* get(EntityHandle handle) const;
+	bool isValid(EntityHandle handle) const;
+
+	std::uint32_t getCount() const;
+
+	// Slots for saving the store, free slots keep the generation of their next entity
+	std::uint32_t getSlotsCount() const;
+	std::uint32_t getGeneration(std::uint32_t slot) const;
+	const std::vector<std::uint32_t>& getFreeSlots() const;
+
+	// Replaces all slots with empty ones of the generations, entities are put back by set.
+	// Free slots are given out in the same order as by the saved store.
+	void restore(const std::vector<std::uint32_t>& generations,
+		const std::vector<std::uint32_t>& freeSlots);
+	void set(EntityHandle handle, class GameObject* object);
+
+private:
+	struct Slot
+	{
+		class GameObject* object;
+		std::uint32_t generation;
+	};
+
+	std::vector<Slot> mSlots;
+	std::vector<std::uint32_t> mFreeSlots;
+	std::uint32_t mCount;
+};
+
@@ -78,11 +78,31 @@ void FlipbookAnimation::setRepeat(bool state)
 }
 
 weak_ptr<const class Sprite> FlipbookAnimation::getCurrentSprite() const
+{
+	return mSpriteSheet->getSprite(getCurrentSpriteIndex());
+}
+
+uint32_t FlipbookAnimation::getCurrentSpriteIndex() const
 {
 	uint32_t index = static_cast<uint32_t>((mCurrentTime / mDuration) * mKeyFramesIndices.size());
 
 	if (index == mKeyFramesIndices.size())
 		index = 0;
 
-	return mSpriteSheet->getSprite(mKeyFramesIndices[index]);
+	return mKeyFramesIndices[index];
+}
+
+const SpriteSheet& FlipbookAnimation::getSpriteSheet() const
+{
+	return *mSpriteSheet;
+}
+
+const vector<uint32_t>& FlipbookAnimation::getKeyFrames() const
+{
+	return mKeyFramesIndices;
+}
+
+double FlipbookAnimation::getDuration() const
+{
+	return mDuration;
 }
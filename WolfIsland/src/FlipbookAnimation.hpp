@@ -34,6 +34,10 @@ public:
 	void setRepeat(bool state);
 
 	std::weak_ptr<const class Sprite> getCurrentSprite() const;
+	std::uint32_t getCurrentSpriteIndex() const;
+	const class SpriteSheet& getSpriteSheet() const;
+	const std::vector<std::uint32_t>& getKeyFrames() const;
+	double getDuration() const;
 
 private:
 	std::vector<std::uint32_t> mKeyFramesIndices;
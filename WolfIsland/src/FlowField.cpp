@@ -0,0 +1,410 @@
+#include "FlowField.hpp"
+using namespace std;
+
+const uint32_t FlowField::unreachable{ numeric_limits<uint32_t>::max() };
+
+// Same order as wolves scan their surroundings
+static const array<glm::tvec2<int32_t>, 8> directions{ {
+	{ -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } } };
+static const uint8_t noStep{ 8 };
+
+// Directions are symmetric, the opposite of direction d is oppositeDirection - d
+static const uint32_t oppositeDirection{ 7 };
+
+// Smaller fields aren't worth splitting to jobs
+static const size_t parallelCells{ 1 << 16 };
+
+// Repair searches only the regions of changed sources again, but visits their cells more
+// than once. It costs about as much as a rebuild once a third of the sources moved to another
+// cell, which changes two thirds of the source cells. The choice doesn't depend on workers.
+static const size_t sourcesPerChange{ 2 };
+
+
+FlowField::LevelSearch::LevelSearch(uint32_t parts, size_t cells)
+	: parts{ parts }, stripCells{ (cells + parts - 1) / parts },
+	reached(parts, vector<vector<Reached>>(parts)), claimed(parts)
+{
+}
+
+FlowField::FlowField()
+	: mWidth{ 0 }, mHeight{ 0 }, mJobs{ nullptr }, mRebuild{ true }, mLastUpdateIncremental{ false }
+{
+}
+
+FlowField::FlowField(uint32_t width, uint32_t height, JobSystem* jobs)
+	: mWidth{ 0 }, mHeight{ 0 }, mJobs{ nullptr }, mRebuild{ true }, mLastUpdateIncremental{ false }
+{
+	create(width, height, jobs);
+}
+
+void FlowField::create(uint32_t width, uint32_t height, JobSystem* jobs)
+{
+	mWidth = width;
+	mHeight = height;
+	mJobs = jobs;
+	mRebuild = true;
+	mLastUpdateIncremental = false;
+
+	mBlocked.assign(width * height, 0);
+	mDistances.assign(width * height, unreachable);
+	mSteps.assign(width * height, noStep);
+	mOrigins.assign(width * height, unreachable);
+	mSources.clear();
+}
+
+FlowField::~FlowField()
+{
+}
+
+void FlowField::setBlocked(const vector<glm::tvec2<int32_t>>& cells)
+{
+	fill(begin(mBlocked), end(mBlocked), 0);
+
+	for (auto& c : cells)
+	{
+		if (c.x >= 0 && c.y >= 0 && c.x < static_cast<int32_t>(mWidth) &&
+			c.y < static_cast<int32_t>(mHeight))
+			mBlocked[c.y * mWidth + c.x] = 1;
+	}
+
+	mRebuild = true;
+}
+
+void FlowField::update(const vector<glm::tvec2<int32_t>>& sources)
+{
+	vector<uint32_t> cells;
+	cells.reserve(sources.size());
+
+	for (auto& s : sources)
+	{
+		if (s.x < 0 || s.y < 0 || s.x >= static_cast<int32_t>(mWidth) ||
+			s.y >= static_cast<int32_t>(mHeight))
+			continue;
+
+		uint32_t cell = s.y * mWidth + s.x;
+
+		if (!mBlocked[cell])
+			cells.push_back(cell);
+	}
+
+	sort(begin(cells), end(cells));
+	cells.erase(unique(begin(cells), end(cells)), end(cells));
+
+	vector<uint32_t> removed;
+	vector<uint32_t> added;
+	set_difference(begin(mSources), end(mSources), begin(cells), end(cells),
+		back_inserter(removed));
+	set_difference(begin(cells), end(cells), begin(mSources), end(mSources),
+		back_inserter(added));
+
+	// Only cells which gained their first source or lost their last one change the field
+	size_t changes = removed.size() + added.size();
+	size_t sourcesCount = max(mSources.size(), cells.size());
+
+	mSources = move(cells);
+	mLastUpdateIncremental = !mRebuild && changes * sourcesPerChange <= sourcesCount;
+
+	if (mLastUpdateIncremental)
+		repair(removed, added);
+	else
+		rebuild();
+
+	mRebuild = false;
+}
+
+uint32_t FlowField::getDistance(const glm::tvec2<int32_t>& pos) const
+{
+	if (pos.x < 0 || pos.y < 0 || pos.x >= static_cast<int32_t>(mWidth) ||
+		pos.y >= static_cast<int32_t>(mHeight))
+		return unreachable;
+
+	return mDistances[pos.y * mWidth + pos.x];
+}
+
+bool FlowField::isBlocked(const glm::tvec2<int32_t>& pos) const
+{
+	return pos.x < 0 || pos.y < 0 || pos.x >= static_cast<int32_t>(mWidth) ||
+		pos.y >= static_cast<int32_t>(mHeight) || mBlocked[pos.y * mWidth + pos.x];
+}
+
+glm::tvec2<int32_t> FlowField::getStep(const glm::tvec2<int32_t>& pos) const
+{
+	if (pos.x < 0 || pos.y < 0 || pos.x >= static_cast<int32_t>(mWidth) ||
+		pos.y >= static_cast<int32_t>(mHeight))
+		return { 0, 0 };
+
+	auto step = mSteps[pos.y * mWidth + pos.x];
+	return step == noStep ? glm::tvec2<int32_t>{ 0, 0 } : directions[step];
+}
+
+uint32_t FlowField::getWidth() const
+{
+	return mWidth;
+}
+
+uint32_t FlowField::getHeight() const
+{
+	return mHeight;
+}
+
+bool FlowField::isLastUpdateIncremental() const
+{
+	return mLastUpdateIncremental;
+}
+
+void FlowField::rebuild()
+{
+	fill(begin(mDistances), end(mDistances), unreachable);
+	fill(begin(mSteps), end(mSteps), noStep);
+	fill(begin(mOrigins), end(mOrigins), unreachable);
+
+	for (auto s : mSources)
+	{
+		mDistances[s] = 0;
+		mOrigins[s] = s;
+	}
+
+	uint32_t parts = getSearchParts();
+	bool parallel = parts > 1;
+	LevelSearch search{ parts, mDistances.size() };
+	search.frontier = mSources;
+
+	auto forEachPart = [this, parallel, parts](const function<void(uint32_t)>& function)
+	{
+		if (parallel)
+			mJobs->parallelFor(parts, 1, [&function](size_t first, size_t)
+				{ function(static_cast<uint32_t>(first)); });
+		else
+			function(0);
+	};
+
+	for (uint32_t distance = 1; !search.frontier.empty(); distance++)
+	{
+		forEachPart([this, &search](uint32_t part) { expandLevel(search, part); });
+		forEachPart([this, &search, distance](uint32_t part)
+			{ claimLevel(search, part, distance); });
+
+		search.frontier.clear();
+
+		for (uint32_t p = 0; p < parts; p++)
+		{
+			for (auto& r : search.reached[p])
+				r.clear();
+
+			search.frontier.insert(end(search.frontier), begin(search.claimed[p]),
+				end(search.claimed[p]));
+			search.claimed[p].clear();
+		}
+	}
+}
+
+void FlowField::expandLevel(LevelSearch& search, uint32_t part)
+{
+	auto& reached = search.reached[part];
+
+	// Every part expands its share of the frontier, the field is only read here
+	size_t chunk = (search.frontier.size() + search.parts - 1) / search.parts;
+	size_t last = min((part + 1) * chunk, search.frontier.size());
+
+	for (size_t i = min(part * chunk, last); i < last; i++)
+	{
+		uint32_t cell = search.frontier[i];
+		array<uint32_t, 8> neighbours;
+		getNeighbours(cell, neighbours);
+
+		for (uint32_t d = 0; d < directions.size(); d++)
+		{
+			uint32_t n = neighbours[d];
+
+			if (n == unreachable || mDistances[n] != unreachable)
+				continue;
+
+			auto strip = search.parts > 1 ? n / search.stripCells : 0;
+			reached[strip].push_back({ n, cell, static_cast<uint8_t>(oppositeDirection - d) });
+		}
+	}
+}
+
+void FlowField::claimLevel(LevelSearch& search, uint32_t part, uint32_t distance)
+{
+	auto& claimed = search.claimed[part];
+
+	// Cells are claimed by the part owning their strip, in frontier order,
+	// so the field doesn't depend on the number of parts
+	for (uint32_t p = 0; p < search.parts; p++)
+	{
+		for (auto& r : search.reached[p][part])
+		{
+			if (mDistances[r.cell] != unreachable)
+				continue;
+
+			mDistances[r.cell] = distance;
+			mSteps[r.cell] = r.step;
+			mOrigins[r.cell] = mOrigins[r.parent];
+			claimed.push_back(r.cell);
+		}
+	}
+
+	sort(begin(claimed), end(claimed));
+}
+
+void FlowField::repair(const vector<uint32_t>& removed, const vector<uint32_t>& added)
+{
+	// Cells leading to a removed source form a connected region around it
+	vector<uint32_t> invalid;
+
+	for (auto r : removed)
+	{
+		if (mOrigins[r] != r)
+			continue;
+
+		size_t first = invalid.size();
+		invalid.push_back(r);
+		mOrigins[r] = unreachable;
+
+		for (size_t i = first; i < invalid.size(); i++)
+		{
+			array<uint32_t, 8> neighbours;
+			getNeighbours(invalid[i], neighbours);
+
+			for (auto n : neighbours)
+			{
+				if (n != unreachable && mOrigins[n] == r)
+				{
+					mOrigins[n] = unreachable;
+					invalid.push_back(n);
+				}
+			}
+		}
+	}
+
+	for (auto c : invalid)
+	{
+		mDistances[c] = unreachable;
+		mSteps[c] = noStep;
+	}
+
+	// Search continues from valid cells around the invalid region and from new sources,
+	// buckets keep cells ordered by distance
+	vector<vector<uint32_t>> buckets(1);
+
+	for (auto c : invalid)
+	{
+		array<uint32_t, 8> neighbours;
+		getNeighbours(c, neighbours);
+
+		for (auto n : neighbours)
+		{
+			if (n != unreachable && mDistances[n] != unreachable)
+			{
+				if (buckets.size() <= mDistances[n])
+					buckets.resize(mDistances[n] + 1);
+
+				buckets[mDistances[n]].push_back(n);
+			}
+		}
+	}
+
+	for (auto a : added)
+	{
+		mDistances[a] = 0;
+		mSteps[a] = noStep;
+		mOrigins[a] = a;
+		buckets[0].push_back(a);
+	}
+
+	// Rebuild claims cells in sorted frontier order, so the parent of a cell is its neighbour
+	// one step closer with the lowest index. Buckets are expanded in the same order and cells
+	// whose parent or origin changed are expanded again to update the cells following them.
+	for (uint32_t distance = 0; distance < buckets.size(); distance++)
+	{
+		auto cells = move(buckets[distance]);
+		sort(begin(cells), end(cells));
+		cells.erase(unique(begin(cells), end(cells)), end(cells));
+
+		for (auto cell : cells)
+		{
+			if (mDistances[cell] != distance)
+				continue;
+
+			array<uint32_t, 8> neighbours;
+			getNeighbours(cell, neighbours);
+
+			for (uint32_t d = 0; d < directions.size(); d++)
+			{
+				uint32_t n = neighbours[d];
+
+				if (n == unreachable || mDistances[n] < distance + 1)
+					continue;
+
+				uint32_t parent = cell;
+				auto step = static_cast<uint8_t>(oppositeDirection - d);
+
+				if (mDistances[n] > distance + 1)
+				{
+					// Cells closer to sources are final, the lowest of them is the parent
+					array<uint32_t, 8> parents;
+					getNeighbours(n, parents);
+					mDistances[n] = distance + 1;
+
+					for (uint32_t p = 0; p < directions.size(); p++)
+					{
+						if (parents[p] < parent && mDistances[parents[p]] == distance)
+						{
+							parent = parents[p];
+							step = static_cast<uint8_t>(p);
+						}
+					}
+				}
+				else
+				{
+					// Cells already at the distance keep a lower parent, cells following this
+					// one take its origin
+					auto current = getParent(n);
+
+					if (current < cell || (current == cell && mOrigins[n] == mOrigins[cell]))
+						continue;
+				}
+
+				mSteps[n] = step;
+				mOrigins[n] = mOrigins[parent];
+
+				if (buckets.size() <= distance + 1)
+					buckets.resize(distance + 2);
+
+				buckets[distance + 1].push_back(n);
+			}
+		}
+	}
+}
+
+uint32_t FlowField::getParent(uint32_t cell) const
+{
+	if (mSteps[cell] == noStep)
+		return unreachable;
+
+	auto& step = directions[mSteps[cell]];
+	return (cell / mWidth + step.y) * mWidth + cell % mWidth + step.x;
+}
+
+uint32_t FlowField::getSearchParts() const
+{
+	return mJobs && mDistances.size() >= parallelCells ? mJobs->getWorkersCount() + 1 : 1;
+}
+
+void FlowField::getNeighbours(uint32_t cell, array<uint32_t, 8>& neighbours) const
+{
+	int32_t x = cell % mWidth;
+	int32_t y = cell / mWidth;
+
+	for (uint32_t d = 0; d < directions.size(); d++)
+	{
+		int32_t nx = x + directions[d].x;
+		int32_t ny = y + directions[d].y;
+		uint32_t n = ny * mWidth + nx;
+
+		neighbours[d] = nx < 0 || ny < 0 || nx >= static_cast<int32_t>(mWidth) ||
+			ny >= static_cast<int32_t>(mHeight) || mBlocked[n] ? unreachable : n;
+	}
+}
+
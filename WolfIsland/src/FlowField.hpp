@@ -0,0 +1,92 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "JobSystem.hpp"
+#include <glm/vec2.hpp>
+
+
+// Distance and best step towards the nearest source cell, moves go to any of 8 neighbours.
+// Built by multi-source breadth first search, large fields are searched by jobs.
+// Sources moving by a turn change the field only around them, so it's repaired in place unless
+// sources appeared or disappeared in more cells than half the sources. Repaired fields are the
+// same as rebuilt ones.
+class FlowField
+{
+public:
+	FlowField();
+
+	// Without a job system the field is searched on the calling thread
+	FlowField(std::uint32_t width, std::uint32_t height, JobSystem* jobs = nullptr);
+	void create(std::uint32_t width, std::uint32_t height, JobSystem* jobs = nullptr);
+
+	~FlowField();
+
+	// Cells that can't be entered, forces a full rebuild on the next update
+	void setBlocked(const std::vector<glm::tvec2<std::int32_t>>& cells);
+	void update(const std::vector<glm::tvec2<std::int32_t>>& sources);
+
+	std::uint32_t getDistance(const glm::tvec2<std::int32_t>& pos) const;
+	bool isBlocked(const glm::tvec2<std::int32_t>& pos) const;
+
+	// Offset of the neighbour closer to the nearest source, zero at sources and unreachable cells
+	glm::tvec2<std::int32_t> getStep(const glm::tvec2<std::int32_t>& pos) const;
+
+	std::uint32_t getWidth() const;
+	std::uint32_t getHeight() const;
+	bool isLastUpdateIncremental() const;
+
+	static const std::uint32_t unreachable;
+
+private:
+	std::uint32_t mWidth;
+	std::uint32_t mHeight;
+	JobSystem* mJobs;
+	bool mRebuild;
+	bool mLastUpdateIncremental;
+
+	std::vector<std::uint8_t> mBlocked;
+	std::vector<std::uint32_t> mDistances;
+	std::vector<std::uint8_t> mSteps;
+
+	// Source cell each cell leads to, needed to repair the field when a source disappears
+	std::vector<std::uint32_t> mOrigins;
+
+	// Sorted cell indices of current sources
+	std::vector<std::uint32_t> mSources;
+
+	// State shared by parts of the search, every level is expanded and claimed by one job
+	// for every part
+	struct LevelSearch
+	{
+		LevelSearch(std::uint32_t parts, std::size_t cells);
+
+		std::uint32_t parts;
+		std::size_t stripCells;
+		std::vector<std::uint32_t> frontier;
+
+		struct Reached
+		{
+			std::uint32_t cell;
+			std::uint32_t parent;
+			std::uint8_t step;
+		};
+
+		// Cells reached by every part, split by the strip of the field they belong to
+		std::vector<std::vector<std::vector<Reached>>> reached;
+		std::vector<std::vector<std::uint32_t>> claimed;
+	};
+
+	void rebuild();
+
+	// Rebuilds of large fields are split to jobs
+	std::uint32_t getSearchParts() const;
+	void expandLevel(LevelSearch& search, std::uint32_t part);
+	void claimLevel(LevelSearch& search, std::uint32_t part, std::uint32_t distance);
+	void repair(const std::vector<std::uint32_t>& removed,
+		const std::vector<std::uint32_t>& added);
+	// Neighbour the step of the cell leads to, unreachable without a step
+	std::uint32_t getParent(std::uint32_t cell) const;
+
+	// Indices of 8 neighbours in scan order, unreachable for blocked and outside cells
+	void getNeighbours(std::uint32_t cell, std::array<std::uint32_t, 8>& neighbours) const;
+};
+
@@ -0,0 +1,80 @@
+#include "Framebuffer.hpp"
+#include "Texture.hpp"
+#include "Renderer.hpp"
+using namespace std;
+
+Framebuffer::Framebuffer()
+	: mDimensions{ 0, 0 }
+{
+}
+
+Framebuffer::Framebuffer(Framebuffer&& rhs)
+	: GpuResource(move(rhs))
+{
+	swap(mTexture, rhs.mTexture);
+	swap(mDimensions, rhs.mDimensions);
+}
+
+Framebuffer& Framebuffer::operator=(Framebuffer&& rhs)
+{
+	GpuResource::operator=(move(rhs));
+	swap(mTexture, rhs.mTexture);
+	swap(mDimensions, rhs.mDimensions);
+	return *this;
+}
+
+Framebuffer::Framebuffer(const glm::tvec2<int32_t>& dimensions, Renderer& renderer)
+	: mDimensions{ 0, 0 }
+{
+	create(dimensions, renderer);
+}
+
+void Framebuffer::create(const glm::tvec2<int32_t>& dimensions, Renderer& renderer)
+{
+	if (mID != 0)
+		clear();
+
+	mDimensions = dimensions;
+	mTexture = make_shared<Texture>(dimensions.x, dimensions.y, Image::Format::RGBA8, renderer);
+	gl::GenFramebuffers(1, &mID);
+
+	renderer.bindFramebuffer(*this);
+	gl::FramebufferTexture2D(gl::FRAMEBUFFER, gl::COLOR_ATTACHMENT0, gl::TEXTURE_2D,
+		mTexture->getID(), 0);
+	auto status = gl::CheckFramebufferStatus(gl::FRAMEBUFFER);
+	renderer.bindDefaultFramebuffer();
+
+	if (status != gl::FRAMEBUFFER_COMPLETE)
+	{
+		clear();
+		throw FramebufferIncompleteException();
+	}
+}
+
+Framebuffer::~Framebuffer()
+{
+	clear();
+}
+
+void Framebuffer::clear()
+{
+	gl::DeleteFramebuffers(1, &mID);
+	mID = 0;
+	mTexture.reset();
+}
+
+weak_ptr<Texture> Framebuffer::getTexture() const
+{
+	return mTexture;
+}
+
+const glm::tvec2<int32_t>& Framebuffer::getDimensions() const
+{
+	return mDimensions;
+}
+
+uint32_t Framebuffer::getSize() const
+{
+	return mTexture ? mTexture->getSize() : 0;
+}
+
@@ -0,0 +1,44 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "GpuResource.hpp"
+#include <glm/vec2.hpp>
+
+class FramebufferIncompleteException : public std::exception
+{
+	virtual const char* what() const noexcept
+	{
+		return "Framebuffer can't be rendered to.";
+	}
+};
+
+// Framebuffer drawing into a texture, which can be drawn like any other texture afterwards
+class Framebuffer : public GpuResource
+{
+	friend class Renderer;
+
+public:
+	Framebuffer();
+
+	// Copy/Move constructors and assignments
+	Framebuffer(const Framebuffer& lhs) = delete;
+	Framebuffer(Framebuffer&& rhs);
+	Framebuffer& operator=(const Framebuffer& lhs) = delete;
+	Framebuffer& operator=(Framebuffer&& rhs);
+
+	// Creates an rgba texture of the size, throws FramebufferIncompleteException when
+	// the driver can't render to it
+	Framebuffer(const glm::tvec2<std::int32_t>& dimensions, class Renderer& renderer);
+	void create(const glm::tvec2<std::int32_t>& dimensions, class Renderer& renderer);
+
+	~Framebuffer();
+	void clear() override;
+
+	std::weak_ptr<class Texture> getTexture() const;
+	const glm::tvec2<std::int32_t>& getDimensions() const;
+	std::uint32_t getSize() const override;
+
+private:
+	std::shared_ptr<class Texture> mTexture;
+	glm::tvec2<std::int32_t> mDimensions;
+};
+
@@ -1,8 +1,16 @@
 #include "GameObject.hpp"
 
 
+ObjectState::ObjectState()
+	: type{ 0 }, serial{ 0 }, generation{ 0 }, flags{ 0 }, pos{ 0, 0 }, savedPos{ 0, 0 },
+	disorder{ 0.0f, 0.0f }, idle{ 0 }, tourTimer{ 0 }, lifeTours{ 0 }, fat{ 0.0f },
+	corpseTimer{ 0.0f }
+{
+}
+
+
 GameObject::GameObject()
-	: mReadyToDelete{ false }
+	: mPos{ 0, 0 }, mSavedPos{ 0, 0 }, mReadyToDelete{ false }
 {
 }
 
@@ -11,6 +19,19 @@ GameObject::~GameObject()
 {
 }
 
+void GameObject::draw(SpriteBatch& batch) const
+{
+}
+
+void GameObject::draw(AnimatedObjectLayer& layer) const
+{
+}
+
+bool GameObject::isStatic() const
+{
+	return false;
+}
+
 void GameObject::saveCurrentPos()
 {
 	mSavedPos = mPos;
@@ -46,3 +67,29 @@ bool GameObject::isReadyToDelete() const
 	return mReadyToDelete;
 }
 
+void GameObject::saveState(ObjectState& state) const
+{
+	state.flags = (mActive ? ObjectState::active : 0) |
+		(mReadyToDelete ? ObjectState::readyToDelete : 0);
+	state.pos = mPos;
+	state.savedPos = mSavedPos;
+}
+
+void GameObject::loadState(const ObjectState& state)
+{
+	setPos(state.pos);
+	mSavedPos = state.savedPos;
+	mActive = (state.flags & ObjectState::active) != 0;
+	mReadyToDelete = (state.flags & ObjectState::readyToDelete) != 0;
+}
+
+EntityHandle GameObject::getHandle() const
+{
+	return mHandle;
+}
+
+void GameObject::setHandle(EntityHandle handle)
+{
+	mHandle = handle;
+}
+
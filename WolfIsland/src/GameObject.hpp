@@ -1,9 +1,43 @@
 #pragma once
 #include "Prerequisites.hpp"
+#include "EntityStore.hpp"
 #include "gl_core_3_3.hpp"
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 
+// Logic state of an object between turns, saved by the timeline. Every field has 4 bytes,
+// so records have no padding and unchanged objects keep the same bytes. Fields unused by
+// a type stay 0.
+struct ObjectState
+{
+	ObjectState();
+
+	// Flags
+	static const std::uint32_t active{ 1 };
+	static const std::uint32_t readyToDelete{ 2 };
+	static const std::uint32_t eaten{ 4 };
+	static const std::uint32_t chaseHare{ 8 };
+
+	// Filled by the board: index of the type in object counters plus 1 or 0 for free slots,
+	// order of adding and generation of the entity slot
+	std::uint32_t type;
+	std::uint32_t serial;
+	std::uint32_t generation;
+
+	std::uint32_t flags;
+	glm::tvec2<std::int32_t> pos;
+	glm::tvec2<std::int32_t> savedPos;
+	glm::vec2 disorder;
+	std::uint32_t idle;
+
+	// Split, mate or pup timer
+	std::uint32_t tourTimer;
+	std::uint32_t lifeTours;
+	float fat;
+	float corpseTimer;
+	EntityHandle target;
+};
+
 class GameObject
 {
 public:
@@ -11,10 +45,18 @@ public:
 	virtual ~GameObject() = 0;
 
 
-	virtual void draw(class Renderer& renderer) const = 0;
+	// Static objects draw their sprites, moving ones their moves and clips, the other draw
+	// does nothing
+	virtual void draw(class SpriteBatch& batch) const;
+	virtual void draw(class AnimatedObjectLayer& layer) const;
+
+	// Static objects never move or animate, they are drawn with the ground
+	virtual bool isStatic() const;
 
 	virtual void updateMove(class Board& board) = 0;
 	virtual void updateAction(class Board& board) = 0;
+
+	// Counts down the corpse of an inactive object, moves and clips are played by the shader
 	virtual void update(float deltaTime) = 0;
 
 	void saveCurrentPos();
@@ -26,11 +68,20 @@ public:
 	bool isActive() const;
 	bool isReadyToDelete() const;
 
+	// Loading puts the object at rest in its idle animation
+	virtual void saveState(ObjectState& state) const;
+	virtual void loadState(const ObjectState& state);
+
+	// Given by the board when the object is added
+	EntityHandle getHandle() const;
+	void setHandle(EntityHandle handle);
+
 protected:
 	std::string mType;
 	glm::tvec2<std::int32_t> mPos;
 	glm::tvec2<std::int32_t> mSavedPos;
 	bool mActive;
 	bool mReadyToDelete;
+	EntityHandle mHandle;
 };
 
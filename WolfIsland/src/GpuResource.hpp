@@ -6,6 +6,7 @@
 class GpuResource : public Resource
 {
 	friend class Renderer;
+	friend class Framebuffer;
 
 public:	
 	GpuResource();
@@ -3,35 +3,31 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/vec3.hpp>
 #include "Renderer.hpp"
+#include "AnimatedObjectLayer.hpp"
 #include "Application.hpp"
 #include "Board.hpp"
 using namespace std;
 
-static const float transitionTime{ 0.5f };
-static const int32_t splitChance{ 10 };
 static const string objectType{ "hare" };
-static const uint32_t splitTourTime{ 5 };
-static const uint32_t maxLifeTours{ 20 };
-static const uint32_t minLifeTours{ 15 };
 static const float corpseTime{ 5.0f };
 
 
 Hare::Hare()
-	: GameObject{}, mTransitionTimer{ 0.5f }, mSplitTourTimer{ splitTourTime }, mIsEaten{ false },
+	: GameObject{}, mTransitionTime{ 0.5f }, mSplitTourTimer{ 0 }, mIsEaten{ false },
 	mCorpseTimer{ corpseTime }
 {
 	mType = objectType;
 }
 
-Hare::Hare(shared_ptr<SpriteSheet> spriteSheet)
-	: GameObject{}, mTransitionTimer{ 0.5f }, mSplitTourTimer{ splitTourTime }, mIsEaten{ false },
+Hare::Hare(shared_ptr<SpriteSheet> spriteSheet, Board& board)
+	: GameObject{}, mTransitionTime{ 0.5f }, mSplitTourTimer{ 0 }, mIsEaten{ false },
 	mCorpseTimer{ corpseTime }
 {
 	mType = objectType;
-	create(spriteSheet);
+	create(spriteSheet, board);
 }
 
-void Hare::create(shared_ptr<SpriteSheet> spriteSheet)
+void Hare::create(shared_ptr<SpriteSheet> spriteSheet, Board& board)
 {
 	// Move forward
 	mAnimations[0].create(spriteSheet, { 0, 1, 2 }, 1.0);
@@ -62,9 +58,18 @@ void Hare::create(shared_ptr<SpriteSheet> spriteSheet)
 
 	mCurrentAnimation = 4;
 	mCurrentIdle = 4;
-	mAnimations[4].start();
-	mLifeTours = uniform_int_distribution<uint32_t>{ minLifeTours, maxLifeTours }(
-		Application::randomDev);
+
+	auto& parameters = board.getParameters();
+	mTransitionTime = parameters.hareTransitionTime;
+	mSplitTourTimer = parameters.splitTourTime;
+	mLifeTours = parameters.minLifeTours +
+		board.getRandom().next(parameters.maxLifeTours - parameters.minLifeTours + 1);
+
+	// Objects are created during turns, so draws come from the turn's stream
+	float disorder = Application::spriteSize / 4.0f;
+	mRandomDisorder = glm::vec2{ board.getRandom().nextReal() * disorder - disorder,
+		board.getRandom().nextReal() * disorder };
+
 	mActive = true;
 }
 
@@ -72,104 +77,54 @@ Hare::~Hare()
 {
 }
 
-const glm::vec2& Hare::getRealPos()
+void Hare::draw(AnimatedObjectLayer& layer) const
 {
-	return mRealPos;
-}
+	// Objects move from positions saved at the start of the turn, corpses stay where they died
+	auto to = glm::vec2{ mPos } * Application::spriteSize + mRandomDisorder;
+	auto from = mActive ? glm::vec2{ mSavedPos } * Application::spriteSize + mRandomDisorder : to;
+	auto move = from != to ? mCurrentAnimation : mCurrentIdle;
 
-void Hare::draw(Renderer& renderer) const
-{
-	auto pos = mRealPos + mRandomDisorder;
-
-	renderer.prepareDrawSprite();
-	renderer.drawSprite(*(mAnimations[mCurrentAnimation].getCurrentSprite().lock()),
-		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	layer.add(mAnimations[move], mAnimations[mCurrentIdle], from, to, mTransitionTime);
 }
 
 void Hare::updateMove(Board& board)
 {
-	glm::tvec2<int32_t> maxPos{ board.getWidth() - 1, board.getHeight() - 1 };
-	auto surrObjects{ board.getSurroundingObjects(mPos) };
-	vector<glm::tvec2<int32_t>> movePosVec;
-
-	for (int i = -1; i <= 1; i++)
-	{
-		for (int j = -1; j <= 1; j++)
-		{
-			auto movePos{ mPos + glm::tvec2<int32_t>{i, j} };
-
-
-			if (movePos.x < 0 || movePos.y < 0 || movePos.x > maxPos.x || movePos.y > maxPos.y)
-				continue;
-
-			bool canMove = true;
-
-			for (auto& obj : surrObjects)
-			{
-				if (obj->getSavedPos() == movePos)
-				{
-					if (obj->getObjectType() == "boulder")
-						canMove = false;
-				}
-			}
-
-			if (canMove)
-				movePosVec.push_back(movePos);
-		}
-	}
+	// Only boulders block hares, bushes don't
+	auto neighbourhood = board.getNeighbourhood(mPos);
+	auto passable = neighbourhood.inside & ~neighbourhood.boulders;
 
 	// Can't move.
-	if (movePosVec.size() == 0)
+	if (passable == 0)
 		return;
 
-	uniform_int_distribution<int32_t> dist{ 0, static_cast<int32_t>(movePosVec.size() - 1) };
-
-
-	mTransitionStartPos = glm::vec2{ mPos.x * Application::spriteSize,
-		mPos.y * Application::spriteSize };
-	mTransitionTimer = 0.0f;
-
-	auto newPos = movePosVec.at(dist(Application::randomDev));
+	auto newPos = mPos + Neighbourhood::GetOffset(Neighbourhood::Select(passable,
+		board.getRandom().next(Neighbourhood::GetCount(passable))));
 
 	// Avoid animation change
 	if (newPos == mPos)
 		return;
 
-	mPos = newPos;
-
 	// Animation controling
-	auto direction = glm::vec2{ mPos.x * Application::spriteSize,
-		mPos.y * Application::spriteSize } -mTransitionStartPos;
+	auto direction = newPos - mPos;
+	mPos = newPos;
 
-	if (direction.x < 0.0f)
+	if (direction.x < 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[2].reset();
-		mAnimations[2].start();
 		mCurrentAnimation = 2;
 		mCurrentIdle = 6;
 	}
-	else if (direction.x > 0.0f)
+	else if (direction.x > 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[3].reset();
-		mAnimations[3].start();
 		mCurrentAnimation = 3;
 		mCurrentIdle = 7;
 	}
-	else if (direction.y < 0.0f)
+	else if (direction.y < 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[0].reset();
-		mAnimations[0].start();
 		mCurrentAnimation = 0;
 		mCurrentIdle = 4;
 	}
-	else if (direction.y > 0.0f)
+	else if (direction.y > 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[1].reset();
-		mAnimations[1].start();
 		mCurrentAnimation = 1;
 		mCurrentIdle = 5;
 	}
@@ -177,12 +132,16 @@ void Hare::updateMove(Board& board)
 
 void Hare::updateAction(Board& board)
 {
-	uniform_int_distribution<int32_t> dist{ 0, 100 };
+	auto& parameters = board.getParameters();
+
+	// Without vegetation hares never go hungry
+	bool fed = parameters.hareAppetite <= 0.0f ||
+		board.getVegetation().consume(mPos, parameters.hareAppetite) >= parameters.hareAppetite;
 
-	if (mSplitTourTimer == 0 && dist(Application::randomDev) < splitChance)
+	if (mSplitTourTimer == 0 && fed && board.getSplitTrial())
 	{
 		board.spawnHare(mPos);
-		mSplitTourTimer = splitTourTime;
+		mSplitTourTimer = parameters.splitTourTime;
 	}
 
 	if (mSplitTourTimer > 0)
@@ -202,51 +161,45 @@ void Hare::updateAction(Board& board)
 void Hare::update(float deltaTime)
 {
 	if (mActive)
-	{
-		if (mTransitionTimer < transitionTime)
-		{
-			glm::vec2 transitionEndPos{ mPos.x * Application::spriteSize,
-				mPos.y * Application::spriteSize };
-
-			mRealPos = glm::mix(mTransitionStartPos, transitionEndPos,
-				mTransitionTimer / transitionTime);
-
-			mTransitionTimer += deltaTime;
-
-			if (mTransitionTimer >= transitionTime)
-			{
-				mAnimations[mCurrentAnimation].stop();
-				mAnimations[mCurrentIdle].start();
-				mCurrentAnimation = mCurrentIdle;
-			}
-		}
-	}
-	else
-	{
-		if (mCurrentAnimation != mCurrentIdle)
-		{
-			mAnimations[mCurrentAnimation].stop();
-			mAnimations[mCurrentIdle].start();
-			mCurrentAnimation = mCurrentIdle;
-		}
-
-		if (mCorpseTimer <= 0.0f)
-			mReadyToDelete = true;
+		return;
 
-		mCorpseTimer -= deltaTime;
-	}
+	if (mCorpseTimer <= 0.0f)
+		mReadyToDelete = true;
 
-	mAnimations[mCurrentAnimation].update(deltaTime);
+	mCorpseTimer -= deltaTime;
 }
 
 void Hare::setPos(const glm::tvec2<int32_t>& pos)
 {
 	mPos = pos;
-	mRealPos = glm::vec2{ pos.x * Application::spriteSize, pos.y * Application::spriteSize };
 
-	uniform_real_distribution<float> dist{ 0.0f, Application::spriteSize / 4.0f };
-	mRandomDisorder = glm::vec2{ dist(Application::randomDev) - Application::spriteSize / 4.0f,
-		dist(Application::randomDev) };
+	// Placed objects rest until their next move
+	mSavedPos = pos;
+}
+
+void Hare::saveState(ObjectState& state) const
+{
+	GameObject::saveState(state);
+	state.flags |= mIsEaten ? ObjectState::eaten : 0;
+	state.disorder = mRandomDisorder;
+	state.idle = mCurrentIdle;
+	state.tourTimer = mSplitTourTimer;
+	state.lifeTours = mLifeTours;
+	state.corpseTimer = mCorpseTimer;
+}
+
+void Hare::loadState(const ObjectState& state)
+{
+	GameObject::loadState(state);
+	mIsEaten = (state.flags & ObjectState::eaten) != 0;
+	mRandomDisorder = state.disorder;
+	mSplitTourTimer = state.tourTimer;
+	mLifeTours = state.lifeTours;
+	mCorpseTimer = state.corpseTimer;
+
+	// Last move isn't saved, a replayed move plays the idle clip
+	mCurrentIdle = min<uint32_t>(state.idle, mAnimations.size() - 1);
+	mCurrentAnimation = mCurrentIdle;
 }
 
 void Hare::setEaten(bool state)
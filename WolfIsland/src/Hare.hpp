@@ -11,32 +11,30 @@ class Hare : public GameObject
 {
 public:
 	Hare();
-	Hare(std::shared_ptr<class SpriteSheet> spriteSheet);
-	void create(std::shared_ptr<class SpriteSheet> spriteSheet);
+	Hare(std::shared_ptr<class SpriteSheet> spriteSheet, class Board& board);
+	void create(std::shared_ptr<class SpriteSheet> spriteSheet, class Board& board);
 
 	~Hare();
 
-	const glm::vec2& getRealPos();
-
-	void draw(class Renderer& renderer) const override;
+	void draw(class AnimatedObjectLayer& layer) const override;
 
 	void updateMove(class Board& board) override;
 	void updateAction(class Board& board) override;
 	void update(float deltaTime) override;
 	void setPos(const glm::tvec2<std::int32_t>& pos);
+	void saveState(ObjectState& state) const override;
+	void loadState(const ObjectState& state) override;
 	void setEaten(bool state);
 	bool isEaten();
 
 private:
-	glm::vec2 mRealPos;
 	glm::vec2 mRandomDisorder;
 	
 	// Animations
 	std::array<FlipbookAnimation, 9> mAnimations;
 	std::uint32_t mCurrentAnimation;
 	std::uint32_t mCurrentIdle;
-	glm::vec2 mTransitionStartPos;
-	float mTransitionTimer;
+	float mTransitionTime;
 	float mCorpseTimer;
 
 
@@ -0,0 +1,427 @@
+#include "HareAutomaton.hpp"
+using namespace std;
+
+// Same order as agents scan their surroundings
+static const array<glm::tvec2<int32_t>, 8> directions{ {
+	{ -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } } };
+
+static const uint32_t maxAge{ 31 };
+
+
+static inline uint64_t PopCount64(uint64_t x)
+{
+	x = x - ((x >> 1) & 0x5555555555555555ull);
+	x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+
+	return (x * 0x0101010101010101ull) >> 56;
+}
+
+static inline uint32_t ChanceNumerator(double chance)
+{
+	return static_cast<uint32_t>(min(max(llround(chance * 256.0), 0ll), 256ll));
+}
+
+
+HareAutomaton::HareAutomaton()
+	: mWidth{ 0 }, mHeight{ 0 }, mRowWords{ 0 }, mLastWordMask{ 0 }, mRandomState{ 0 }
+{
+}
+
+HareAutomaton::HareAutomaton(uint32_t width, uint32_t height, uint64_t seed)
+	: mWidth{ 0 }, mHeight{ 0 }, mRowWords{ 0 }, mLastWordMask{ 0 }, mRandomState{ 0 }
+{
+	create(width, height, seed);
+}
+
+void HareAutomaton::create(uint32_t width, uint32_t height, uint64_t seed)
+{
+	mWidth = width;
+	mHeight = height;
+	mRowWords = (width + 63) / 64;
+	mLastWordMask = width % 64 == 0 ? ~0ull : (1ull << (width % 64)) - 1;
+	mRandomState = seed;
+
+	uint32_t words = mRowWords * height;
+	mOccupied.assign(words, 0);
+
+	for (auto& plane : mAge)
+		plane.assign(words, 0);
+
+	for (auto& plane : mChosen)
+		plane.assign(words, 0);
+
+	mParents.assign(words, 0);
+	mTarget.assign(words, 0);
+	mSource.assign(words, 0);
+	mMoved.assign(words, 0);
+	mShifted.assign(words, 0);
+	mDirtyChunks.markAll();
+
+	setBlocked({});
+}
+
+HareAutomaton::~HareAutomaton()
+{
+}
+
+void HareAutomaton::setBlocked(const vector<glm::tvec2<int32_t>>& cells)
+{
+	mOpen.assign(mRowWords * mHeight, ~0ull);
+
+	for (uint32_t y = 0; y < mHeight; y++)
+		mOpen[(y + 1) * mRowWords - 1] = mLastWordMask;
+
+	for (auto& c : cells)
+	{
+		if (isInside(c))
+			mOpen[c.y * mRowWords + c.x / 64] &= ~(1ull << (c.x % 64));
+	}
+
+	for (uint32_t k = 0; k < mOccupied.size(); k++)
+	{
+		mOccupied[k] &= mOpen[k];
+
+		for (auto& plane : mAge)
+			plane[k] &= mOpen[k];
+	}
+
+	mDirtyChunks.markAll();
+}
+
+void HareAutomaton::update(const SimulationParameters& parameters)
+{
+	uint32_t words = mOccupied.size();
+	mDirtyChunks.markAll();
+
+	uint32_t minLife = min(max(parameters.minLifeTours, 1u), maxAge);
+	uint32_t maxLife = min(max(parameters.maxLifeTours, minLife), maxAge);
+
+	// Lifetime of agents is uniform between min and max, here it's a constant chance
+	// of death after the min
+	uint32_t deathNumerator = ChanceNumerator(1.0 / (maxLife - minLife + 1));
+
+	// Births at the average rate of agents waiting the split time and then drawing
+	// the split chance every turn
+	uint32_t birthNumerator = parameters.splitChance <= 0 ? 0 :
+		ChanceNumerator(1.0 / (parameters.splitTourTime + 101.0 / parameters.splitChance));
+
+	for (uint32_t k = 0; k < words; k++)
+	{
+		// Ripple carry increment of all ages, saturated at the max
+		uint64_t carry = mOccupied[k];
+
+		for (auto& plane : mAge)
+		{
+			uint64_t next = plane[k] & carry;
+			plane[k] ^= carry;
+			carry = next;
+		}
+
+		for (auto& plane : mAge)
+			plane[k] |= carry;
+
+		uint64_t dead = mOccupied[k] & (ageAtLeast(k, maxLife) |
+			(ageAtLeast(k, minLife) & randomMask(deathNumerator)));
+
+		mOccupied[k] &= ~dead;
+
+		for (auto& plane : mAge)
+			plane[k] &= ~dead;
+
+		mParents[k] = mOccupied[k] & randomMask(birthNumerator);
+
+		// Every hare picks one of 8 directions or staying with equal chance
+		uint64_t remaining = mOccupied[k];
+
+		for (uint32_t d = 0; d < mChosen.size(); d++)
+		{
+			mChosen[d][k] = remaining & randomMask(ChanceNumerator(1.0 / (9 - d)));
+			remaining &= ~mChosen[d][k];
+		}
+	}
+
+	// Directions are resolved one after another in random order, so two hares never
+	// enter the same cell
+	array<uint32_t, 8> order{ { 0, 1, 2, 3, 4, 5, 6, 7 } };
+
+	for (uint32_t i = order.size() - 1; i > 0; i--)
+		swap(order[i], order[nextRandom() % (i + 1)]);
+
+	for (auto d : order)
+	{
+		moveTo(mParents, directions[d], false);
+
+		for (uint32_t k = 0; k < words; k++)
+			mParents[k] &= ~mSource[k];
+	}
+
+	for (auto d : order)
+		moveTo(mChosen[d], directions[d], true);
+}
+
+bool HareAutomaton::get(const glm::tvec2<int32_t>& pos) const
+{
+	if (!isInside(pos))
+		return false;
+
+	return (mOccupied[pos.y * mRowWords + pos.x / 64] >> (pos.x % 64)) & 1;
+}
+
+bool HareAutomaton::add(const glm::tvec2<int32_t>& pos)
+{
+	if (!isInside(pos))
+		return false;
+
+	uint32_t word = pos.y * mRowWords + pos.x / 64;
+	uint64_t bit = 1ull << (pos.x % 64);
+
+	if ((mOccupied[word] & bit) || !(mOpen[word] & bit))
+		return false;
+
+	mOccupied[word] |= bit;
+	markWord(word);
+
+	return true;
+}
+
+bool HareAutomaton::take(const glm::tvec2<int32_t>& pos)
+{
+	if (!get(pos))
+		return false;
+
+	uint32_t word = pos.y * mRowWords + pos.x / 64;
+	uint64_t bit = 1ull << (pos.x % 64);
+	mOccupied[word] &= ~bit;
+
+	for (auto& plane : mAge)
+		plane[word] &= ~bit;
+
+	markWord(word);
+	return true;
+}
+
+uint64_t HareAutomaton::getTotal() const
+{
+	uint64_t total{ 0 };
+
+	for (auto w : mOccupied)
+		total += PopCount64(w);
+
+	return total;
+}
+
+void HareAutomaton::getPositions(vector<glm::tvec2<int32_t>>& positions) const
+{
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		for (uint32_t k = 0; k < mRowWords; k++)
+		{
+			for (uint64_t w = mOccupied[y * mRowWords + k]; w != 0; w &= w - 1)
+			{
+				// Index of the lowest set bit
+				uint32_t bit = static_cast<uint32_t>(PopCount64((w & (~w + 1)) - 1));
+				positions.push_back({ k * 64 + bit, y });
+			}
+		}
+	}
+}
+
+void HareAutomaton::getState(vector<uint64_t>& words) const
+{
+	words.resize(getStateSize());
+	getState(0, words.size(), words.data());
+}
+
+bool HareAutomaton::setState(const vector<uint64_t>& words)
+{
+	if (words.size() != 1 + mOccupied.size() * (1 + agePlanes))
+		return false;
+
+	mRandomState = words[0];
+	auto it = begin(words) + 1;
+	copy_n(it, mOccupied.size(), begin(mOccupied));
+
+	for (auto& plane : mAge)
+	{
+		it += plane.size();
+		copy_n(it, plane.size(), begin(plane));
+	}
+
+	mDirtyChunks.markAll();
+	return true;
+}
+
+size_t HareAutomaton::getStateSize() const
+{
+	return 1 + mOccupied.size() * (1 + agePlanes);
+}
+
+void HareAutomaton::getState(size_t first, size_t last, uint64_t* words) const
+{
+	size_t planeSize = mOccupied.size();
+
+	for (size_t i = first; i < last; i++)
+	{
+		if (i == 0)
+		{
+			*words++ = mRandomState;
+			continue;
+		}
+
+		// Copies the rest of the plane the word is in
+		size_t plane = (i - 1) / planeSize;
+		size_t offset = (i - 1) % planeSize;
+		auto& values = plane == 0 ? mOccupied : mAge[plane - 1];
+		size_t count = min(planeSize - offset, last - i);
+
+		words = copy_n(begin(values) + offset, count, words);
+		i += count - 1;
+	}
+}
+
+const DirtyChunks<uint64_t>& HareAutomaton::getDirtyChunks() const
+{
+	return mDirtyChunks;
+}
+
+void HareAutomaton::clearDirtyChunks()
+{
+	mDirtyChunks.clear();
+}
+
+uint64_t HareAutomaton::nextRandom()
+{
+	// splitmix64
+	uint64_t z = (mRandomState += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+	return z ^ (z >> 31);
+}
+
+uint64_t HareAutomaton::randomMask(uint32_t numerator)
+{
+	if (numerator == 0)
+		return 0;
+
+	if (numerator >= 256)
+		return ~0ull;
+
+	// Binary digits of the chance from the lowest one, a set digit ors a random word
+	// and a clear one ands it. Digits below the lowest set one don't change the zero mask.
+	uint64_t mask{ 0 };
+	uint32_t bit = static_cast<uint32_t>(PopCount64((numerator & (~numerator + 1)) - 1));
+
+	for (; bit < 8; bit++)
+	{
+		if ((numerator >> bit) & 1)
+			mask |= nextRandom();
+		else
+			mask &= nextRandom();
+	}
+
+	return mask;
+}
+
+uint64_t HareAutomaton::ageAtLeast(uint32_t word, uint32_t age) const
+{
+	// Bit sliced comparison from the highest bit
+	uint64_t greater{ 0 };
+	uint64_t equal{ ~0ull };
+
+	for (int32_t p = agePlanes - 1; p >= 0; p--)
+	{
+		uint64_t bits = mAge[p][word];
+
+		if ((age >> p) & 1)
+			equal &= bits;
+		else
+		{
+			greater |= equal & bits;
+			equal &= ~bits;
+		}
+	}
+
+	return greater | equal;
+}
+
+void HareAutomaton::shift(const vector<uint64_t>& source, vector<uint64_t>& target,
+	const glm::tvec2<int32_t>& offset) const
+{
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		uint64_t* out = &target[y * mRowWords];
+		int32_t sourceY = static_cast<int32_t>(y) - offset.y;
+
+		if (sourceY < 0 || sourceY >= static_cast<int32_t>(mHeight))
+		{
+			fill(out, out + mRowWords, 0);
+			continue;
+		}
+
+		const uint64_t* in = &source[sourceY * mRowWords];
+
+		if (offset.x > 0)
+		{
+			for (uint32_t k = 0; k < mRowWords; k++)
+				out[k] = (in[k] << 1) | (k > 0 ? in[k - 1] >> 63 : 0);
+		}
+		else if (offset.x < 0)
+		{
+			for (uint32_t k = 0; k < mRowWords; k++)
+				out[k] = (in[k] >> 1) | (k + 1 < mRowWords ? in[k + 1] << 63 : 0);
+		}
+		else
+			copy(in, in + mRowWords, out);
+
+		out[mRowWords - 1] &= mLastWordMask;
+	}
+}
+
+void HareAutomaton::moveTo(const vector<uint64_t>& selected, const glm::tvec2<int32_t>& offset,
+	bool carryAge)
+{
+	uint32_t words = mOccupied.size();
+
+	shift(selected, mTarget, offset);
+
+	for (uint32_t k = 0; k < words; k++)
+		mTarget[k] &= mOpen[k] & ~mOccupied[k];
+
+	shift(mTarget, mSource, -offset);
+
+	// Newborns start at age zero, which free cells already have
+	if (carryAge)
+	{
+		for (auto& plane : mAge)
+		{
+			for (uint32_t k = 0; k < words; k++)
+				mMoved[k] = plane[k] & mSource[k];
+
+			shift(mMoved, mShifted, offset);
+
+			for (uint32_t k = 0; k < words; k++)
+				plane[k] = (plane[k] & ~mSource[k]) | mShifted[k];
+		}
+
+		for (uint32_t k = 0; k < words; k++)
+			mOccupied[k] &= ~mSource[k];
+	}
+
+	for (uint32_t k = 0; k < words; k++)
+		mOccupied[k] |= mTarget[k];
+}
+
+void HareAutomaton::markWord(uint32_t word)
+{
+	for (uint32_t plane = 0; plane < 1 + agePlanes; plane++)
+		mDirtyChunks.mark(1 + plane * mOccupied.size() + word);
+}
+
+bool HareAutomaton::isInside(const glm::tvec2<int32_t>& pos) const
+{
+	return pos.x >= 0 && pos.y >= 0 && pos.x < static_cast<int32_t>(mWidth) &&
+		pos.y < static_cast<int32_t>(mHeight);
+}
+
@@ -0,0 +1,105 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "SimulationParameters.hpp"
+#include "ChunkedArray.hpp"
+#include <glm/vec2.hpp>
+
+
+// How the board keeps its hares
+enum class HareEngine
+{
+	AGENTS,
+	AUTOMATON
+};
+
+// Hares as a cellular automaton, at most one hare in a cell. Occupancy and every bit of the
+// age are separate bit planes with 64 cells of a row in a word, so ageing, deaths, births
+// and moves of whole words are done with bitwise operations.
+// Hares move to a uniformly chosen neighbour when it is free, and give birth into a free
+// neighbour. Chances are rounded to multiples of 1/256 and ages are capped at 31 turns.
+class HareAutomaton
+{
+public:
+	HareAutomaton();
+
+	HareAutomaton(std::uint32_t width, std::uint32_t height, std::uint64_t seed);
+	void create(std::uint32_t width, std::uint32_t height, std::uint64_t seed);
+
+	~HareAutomaton();
+
+	// Cells that can't be entered, hares in them are removed
+	void setBlocked(const std::vector<glm::tvec2<std::int32_t>>& cells);
+
+	// Ageing, deaths, births and moves of all hares for one turn
+	void update(const SimulationParameters& parameters);
+
+	bool get(const glm::tvec2<std::int32_t>& pos) const;
+
+	// Puts a new hare in a free open cell, returns false when it can't be placed
+	bool add(const glm::tvec2<std::int32_t>& pos);
+
+	// Removes the hare from the cell, returns false when the cell is empty
+	bool take(const glm::tvec2<std::int32_t>& pos);
+
+	std::uint64_t getTotal() const;
+	void getPositions(std::vector<glm::tvec2<std::int32_t>>& positions) const;
+
+	// Random state, occupancy and age planes, returns false when the words don't match
+	// the automaton
+	void getState(std::vector<std::uint64_t>& words) const;
+	bool setState(const std::vector<std::uint64_t>& words);
+
+	// Words [first, last) of the state
+	std::size_t getStateSize() const;
+	void getState(std::size_t first, std::size_t last, std::uint64_t* words) const;
+
+	// Words of the state written since the chunks were cleared. Turns write all of them.
+	const DirtyChunks<std::uint64_t>& getDirtyChunks() const;
+	void clearDirtyChunks();
+
+private:
+	static const std::uint32_t agePlanes{ 5 };
+
+	std::uint32_t mWidth;
+	std::uint32_t mHeight;
+	std::uint32_t mRowWords;
+	std::uint64_t mLastWordMask;
+	std::uint64_t mRandomState;
+
+	// Bit planes, row by row
+	std::vector<std::uint64_t> mOccupied;
+	std::vector<std::uint64_t> mOpen;
+	std::array<std::vector<std::uint64_t>, agePlanes> mAge;
+	DirtyChunks<std::uint64_t> mDirtyChunks;
+
+	// Scratch planes of a turn
+	std::array<std::vector<std::uint64_t>, 8> mChosen;
+	std::vector<std::uint64_t> mParents;
+	std::vector<std::uint64_t> mTarget;
+	std::vector<std::uint64_t> mSource;
+	std::vector<std::uint64_t> mMoved;
+	std::vector<std::uint64_t> mShifted;
+
+	std::uint64_t nextRandom();
+
+	// Word with every bit set with the chance of numerator / 256
+	std::uint64_t randomMask(std::uint32_t numerator);
+
+	// Cells of the word with age at least the given one
+	std::uint64_t ageAtLeast(std::uint32_t word, std::uint32_t age) const;
+
+	// Target cell is the source cell moved by offset, cells leaving the board are dropped
+	void shift(const std::vector<std::uint64_t>& source, std::vector<std::uint64_t>& target,
+		const glm::tvec2<std::int32_t>& offset) const;
+
+	// Moves hares of selected cells by offset when target cells are free, or places newborns
+	// there when age isn't carried. Selected cells which succeeded are left in mSource.
+	void moveTo(const std::vector<std::uint64_t>& selected, const glm::tvec2<std::int32_t>& offset,
+		bool carryAge);
+
+	bool isInside(const glm::tvec2<std::int32_t>& pos) const;
+
+	// Marks the word in the occupancy and age planes of the state
+	void markWord(std::uint32_t word);
+};
+
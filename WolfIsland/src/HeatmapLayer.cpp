@@ -0,0 +1,322 @@
+#include "HeatmapLayer.hpp"
+#include "Texture.hpp"
+#include "VertexArray.hpp"
+#include "VertexBuffer.hpp"
+#include "SpriteBatch.hpp"
+#include "Renderer.hpp"
+#include "Board.hpp"
+#include "GameObject.hpp"
+#include "WorldSnapshot.hpp"
+#include "Application.hpp"
+#include <glm/gtx/transform.hpp>
+using namespace std;
+
+// Colour added by every animal of a cell, four of a species saturate it
+static const uint32_t densityStep{ 64 };
+
+// Opacity of debug overlays at their highest values
+static const float overlayAlpha{ 0.75f };
+
+// Distance to hares at which their scent fades out
+static const float scentCells{ 16.0f };
+
+// Alpha of an overlay texel with the value from 0 to 1
+static uint8_t OverlayAlpha(float value)
+{
+	return static_cast<uint8_t>(glm::clamp(value, 0.0f, 1.0f) * overlayAlpha * 255.0f);
+}
+
+static void AddSaturated(uint8_t& channel, uint32_t value)
+{
+	channel = static_cast<uint8_t>(min(channel + value, 255u));
+}
+
+
+HeatmapLayer::HeatmapLayer()
+	: mMode{ HeatmapMode::DENSITY }, mSize{ 0, 0 }, mUploadedRows{ 0 }, mValid{ false }
+{
+}
+
+HeatmapLayer::HeatmapLayer(HeatmapMode mode, Renderer& renderer)
+	: mMode{ HeatmapMode::DENSITY }, mSize{ 0, 0 }, mUploadedRows{ 0 }, mValid{ false }
+{
+	create(mode, renderer);
+}
+
+void HeatmapLayer::create(HeatmapMode mode, Renderer& renderer)
+{
+	mMode = mode;
+	mTexture.reset();
+	mQuad = make_shared<VertexArray>(SpriteBatch::CreateQuad(renderer), renderer);
+	mSize = glm::tvec2<int32_t>{ 0, 0 };
+	mValid = false;
+	mSnapshot.reset();
+}
+
+HeatmapLayer::~HeatmapLayer()
+{
+}
+
+void HeatmapLayer::setMode(HeatmapMode mode)
+{
+	if (mode != mMode)
+		mValid = false;
+
+	mMode = mode;
+}
+
+HeatmapMode HeatmapLayer::getMode() const
+{
+	return mMode;
+}
+
+void HeatmapLayer::update(Board& board, Renderer& renderer)
+{
+	auto size = glm::tvec2<int32_t>{ board.getWidth(), board.getHeight() };
+	auto snapshot = board.getSnapshot();
+	mUploadedRows = 0;
+
+	// Boards match their last snapshot between turns when they didn't add or remove objects
+	if (!snapshot || board.isTurnInProgress() || board.isCountersChanged() ||
+		(mValid && size == mSize && snapshot == mSnapshot))
+		return;
+
+	bool valid = mValid && mSnapshot;
+	mValid = true;
+	mSnapshot = snapshot;
+
+	if (size.x <= 0 || size.y <= 0)
+		return;
+
+	// Texels of a new texture are undefined, all rows are uploaded
+	bool uploadAll = !mTexture || size != mSize;
+
+	if (uploadAll)
+	{
+		mSize = size;
+		mTexture = make_shared<Texture>(size.x, size.y, Image::Format::RGBA8, renderer);
+		mTexels.assign(4 * size.x * size.y, 0);
+	}
+
+	size_t rowBytes = 4 * size.x;
+	mChangedRows.assign(size.y, uploadAll ? 1 : 0);
+
+	if (valid && !uploadAll && mMode != HeatmapMode::SCENT)
+		buildChanged(board, *snapshot);
+	else
+	{
+		build(board);
+
+		for (int32_t y = 0; y < size.y; y++)
+		{
+			if (!equal(begin(mNextTexels) + y * rowBytes, begin(mNextTexels) + (y + 1) * rowBytes,
+				begin(mTexels) + y * rowBytes))
+				mChangedRows[y] = 1;
+		}
+
+		swap(mTexels, mNextTexels);
+	}
+
+	// Runs of consecutive changed rows are uploaded at once
+	int32_t first = 0;
+
+	for (int32_t y = 0; y <= size.y; y++)
+	{
+		if (y < size.y && mChangedRows[y])
+			continue;
+
+		if (y > first)
+		{
+			mTexture->update(0, first, size.x, y - first, mTexels.data() + first * rowBytes,
+				renderer);
+			mUploadedRows += y - first;
+		}
+
+		first = y + 1;
+	}
+}
+
+void HeatmapLayer::draw(Renderer& renderer)
+{
+	if (!mTexture)
+		return;
+
+	auto transform = glm::scale(glm::vec3{ glm::vec2{ mSize } * Application::spriteSize, 1.0f });
+	auto quad = mQuad;
+	auto texture = mTexture;
+
+	renderer.submit(renderer.getQueueKey(RenderLayer::OBJECTS, Renderer::Program::SPRITE,
+		*texture, 0.0f), [quad, texture, transform](Renderer& renderer)
+		{
+			renderer.prepareDrawSprite();
+			renderer.drawTexture(*quad, *texture, transform);
+		});
+}
+
+uint32_t HeatmapLayer::getUploadedRows() const
+{
+	return mUploadedRows;
+}
+
+void HeatmapLayer::build(Board& board)
+{
+	mNextTexels.assign(4 * mSize.x * mSize.y, 0);
+
+	auto texel = [this](const glm::tvec2<int32_t>& pos)
+	{
+		return mNextTexels.data() + 4 * (pos.y * mSize.x + pos.x);
+	};
+
+	if (mMode == HeatmapMode::DENSITY || mMode == HeatmapMode::FAT)
+	{
+		mObjects.clear();
+		board.getObjects(glm::tvec2<int32_t>{ 0, 0 }, mSize - 1, mObjects);
+
+		for (auto obj : mObjects)
+			addObject(*obj, texel(obj->getSavedPos()));
+	}
+
+	for (int32_t y = 0; y < mSize.y; y++)
+	{
+		for (int32_t x = 0; x < mSize.x; x++)
+			addFields(board, glm::tvec2<int32_t>{ x, y }, texel(glm::tvec2<int32_t>{ x, y }));
+	}
+}
+
+void HeatmapLayer::buildChanged(Board& board, const WorldSnapshot& snapshot)
+{
+	mChangedCells.clear();
+
+	if (mMode == HeatmapMode::DENSITY || mMode == HeatmapMode::FAT)
+	{
+		// Objects which changed leave the cell of their former record and enter the new one
+		auto& objects = snapshot.getObjects();
+		auto& former = mSnapshot->getObjects();
+		auto chunkSize = ChunkedArray<ObjectState>::chunkSize;
+		auto slots = max(objects.size(), former.size());
+
+		for (size_t i = 0; i < max(objects.getChunksCount(), former.getChunksCount()); i++)
+		{
+			if (objects.isChunkShared(i, former))
+				continue;
+
+			for (size_t slot = i * chunkSize; slot < min((i + 1) * chunkSize, slots); slot++)
+			{
+				auto record = slot < objects.size() ? &objects[slot] : nullptr;
+				auto formerRecord = slot < former.size() ? &former[slot] : nullptr;
+
+				if (record && formerRecord && record->type == formerRecord->type &&
+					record->flags == formerRecord->flags &&
+					record->savedPos == formerRecord->savedPos && record->fat == formerRecord->fat)
+					continue;
+
+				for (auto changed : { record, formerRecord })
+				{
+					if (changed && changed->type != 0)
+						mChangedCells.push_back(changed->savedPos);
+				}
+			}
+		}
+	}
+
+	if (mMode == HeatmapMode::DENSITY)
+		snapshot.getHareCountChanges(*mSnapshot, mChangedCells);
+
+	if (mMode == HeatmapMode::VEGETATION)
+	{
+		auto& vegetation = snapshot.getVegetation();
+		auto& former = mSnapshot->getVegetation();
+		auto chunkSize = ChunkedArray<float>::chunkSize;
+		bool sameSize = vegetation.size() == former.size();
+
+		for (size_t i = 0; i < vegetation.getChunksCount(); i++)
+		{
+			if (vegetation.isChunkShared(i, former))
+				continue;
+
+			for (size_t c = i * chunkSize; c < min((i + 1) * chunkSize, vegetation.size()); c++)
+			{
+				if (!sameSize || vegetation[c] != former[c])
+					mChangedCells.push_back(glm::tvec2<int32_t>{ static_cast<int32_t>(c % mSize.x),
+						static_cast<int32_t>(c / mSize.x) });
+			}
+		}
+	}
+
+	// Texels are built again from all objects of their cells
+	for (auto& pos : mChangedCells)
+	{
+		if (pos.x < 0 || pos.y < 0 || pos.x >= mSize.x || pos.y >= mSize.y)
+			continue;
+
+		array<uint8_t, 4> texel{};
+
+		if (mMode == HeatmapMode::DENSITY || mMode == HeatmapMode::FAT)
+		{
+			for (auto handle : board.getObjects(pos))
+				addObject(*board.getObject(handle), texel.data());
+		}
+
+		addFields(board, pos, texel.data());
+		auto cell = begin(mTexels) + 4 * (pos.y * mSize.x + pos.x);
+
+		if (!equal(begin(texel), end(texel), cell))
+		{
+			copy(begin(texel), end(texel), cell);
+			mChangedRows[pos.y] = 1;
+		}
+	}
+}
+
+void HeatmapLayer::addObject(GameObject& obj, uint8_t* cell) const
+{
+	if (!obj.isActive() || obj.isStatic())
+		return;
+
+	auto& type = obj.getObjectType();
+
+	if (mMode == HeatmapMode::DENSITY)
+		AddSaturated(cell[type == "wolf_male" ? 0 : type == "wolf_female" ? 2 : 1], densityStep);
+	else if (mMode == HeatmapMode::FAT && type != "hare")
+	{
+		// Red for starving wolves up to yellow for fed ones
+		ObjectState state;
+		obj.saveState(state);
+		auto fat = static_cast<uint8_t>(glm::clamp(state.fat, 0.0f, 1.0f) * 255.0f);
+
+		cell[0] = 255;
+		cell[1] = cell[3] == 0 ? fat : max(cell[1], fat);
+		cell[3] = OverlayAlpha(1.0f);
+	}
+}
+
+void HeatmapLayer::addFields(Board& board, const glm::tvec2<int32_t>& pos, uint8_t* cell) const
+{
+	switch (mMode)
+	{
+	case HeatmapMode::DENSITY:
+		// Hares without objects are only counted
+		AddSaturated(cell[1], board.getHareCount(pos) * densityStep);
+		cell[3] = max({ cell[0], cell[1], cell[2] });
+		break;
+
+	case HeatmapMode::VEGETATION:
+		cell[1] = 255;
+		cell[3] = OverlayAlpha(board.getVegetation().get(pos) / VegetationField::capacity);
+		break;
+
+	case HeatmapMode::SCENT:
+	{
+		auto distance = board.getHareField().getDistance(pos);
+
+		cell[0] = 255;
+		cell[1] = 128;
+		cell[3] = distance == FlowField::unreachable ? 0 :
+			OverlayAlpha(1.0f - distance / scentCells);
+		break;
+	}
+
+	default:
+		break;
+	}
+}
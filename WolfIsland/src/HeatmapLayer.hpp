@@ -0,0 +1,77 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include <glm/vec2.hpp>
+
+// What texels of a heatmap show about their cells
+enum class HeatmapMode : std::uint8_t
+{
+	// Wolves and hares, red for males, blue for females and green for hares
+	DENSITY,
+
+	// Debug overlays of the fattest wolf, food and distance to the nearest hare
+	FAT,
+	VEGETATION,
+	SCENT
+};
+
+// Board drawn as a texture with a texel for every cell, in place of sprites when they would
+// be too small to see or over them as a debug overlay. Texels follow snapshots the board
+// publishes: only cells of objects, counted hares and food which changed since the last
+// snapshot are built again, and only rows with changed texels are uploaded. Scent is built
+// whole, the flow field isn't part of snapshots.
+class HeatmapLayer
+{
+public:
+	HeatmapLayer();
+
+	HeatmapLayer(HeatmapMode mode, class Renderer& renderer);
+	void create(HeatmapMode mode, class Renderer& renderer);
+
+	~HeatmapLayer();
+
+	void setMode(HeatmapMode mode);
+	HeatmapMode getMode() const;
+
+	// Builds texels when the board published a snapshot since the last update. Boards with
+	// a turn in progress or changes which weren't published yet keep the last texels.
+	// Objects are looked up in the spatial index of the board.
+	void update(class Board& board, class Renderer& renderer);
+
+	// Queues the texture over the board on the objects layer, below sprites
+	void draw(class Renderer& renderer);
+
+	// Rows of the texture uploaded by the last update
+	std::uint32_t getUploadedRows() const;
+
+private:
+	HeatmapMode mMode;
+	std::shared_ptr<class Texture> mTexture;
+	std::shared_ptr<class VertexArray> mQuad;
+	glm::tvec2<std::int32_t> mSize;
+
+	// Rgba texels of the texture and the ones being built by whole builds
+	std::vector<std::uint8_t> mTexels;
+	std::vector<std::uint8_t> mNextTexels;
+	std::vector<class GameObject*> mObjects;
+	std::vector<glm::tvec2<std::int32_t>> mChangedCells;
+	std::vector<std::uint8_t> mChangedRows;
+	std::uint32_t mUploadedRows;
+
+	// Snapshot the texels were built from
+	bool mValid;
+	std::shared_ptr<const class WorldSnapshot> mSnapshot;
+
+	// Builds all texels into the next ones
+	void build(class Board& board);
+
+	// Builds texels of cells which changed since the last snapshot in place
+	void buildChanged(class Board& board, const class WorldSnapshot& snapshot);
+
+	// Adds the active object to the texel of its cell
+	void addObject(class GameObject& obj, std::uint8_t* cell) const;
+
+	// Adds fields of the cell to its texel after its objects
+	void addFields(class Board& board, const glm::tvec2<std::int32_t>& pos,
+		std::uint8_t* cell) const;
+};
+
@@ -192,7 +192,37 @@ void Image::setPixel(uint32_t x, uint32_t y, const vector<uint8_t> &bytes)
 	uint32_t row = y * mWidth * bytesPerPixel;
 	uint32_t col = x * bytesPerPixel;
 
-	copy(begin(bytes), end(bytes), begin(mBytes) + row + col);
+	std::copy(begin(bytes), end(bytes), begin(mBytes) + row + col);
+}
+
+void Image::copy(const Image &img, uint32_t x, uint32_t y)
+{
+	uint8_t bytesPerPixel = getBytesPerPixel();
+	bool addAlpha = mFormat == Format::RGBA8 && img.mFormat == Format::RGB8;
+
+	if (bytesPerPixel == 0 || isCompressed() || (img.mFormat != mFormat && !addAlpha))
+		throw ImageFormatException();
+
+	uint32_t width = x < mWidth ? min(img.mWidth, mWidth - x) : 0;
+	uint32_t height = y < mHeight ? min(img.mHeight, mHeight - y) : 0;
+
+	for (uint32_t v = 0; v < height; v++)
+	{
+		auto source = begin(img.mBytes) + v * img.mWidth * img.getBytesPerPixel();
+		auto target = begin(mBytes) + ((y + v) * mWidth + x) * bytesPerPixel;
+
+		if (!addAlpha)
+		{
+			std::copy(source, source + width * bytesPerPixel, target);
+			continue;
+		}
+
+		for (uint32_t u = 0; u < width; u++, source += 3, target += 4)
+		{
+			std::copy(source, source + 3, target);
+			target[3] = 255;
+		}
+	}
 }
 
 void Image::flipVerticaly()
@@ -3,6 +3,14 @@
 #include "Resource.hpp"
 
 
+class ImageFormatException : public std::exception
+{
+	virtual const char* what() const noexcept
+	{
+		return "Image can't be copied into an image of its format.";
+	}
+};
+
 class Image : public Resource
 {
 	friend class Texture;
@@ -81,6 +89,11 @@ public:
 
 	// x and y must be in range [0, mWidth] and [0, mHeight]
 	void setPixel(std::uint32_t x, std::uint32_t y, const std::vector<std::uint8_t> &bytes);
+
+	// Copies the image with its top left corner at x and y, parts outside are cut off.
+	// Formats have to match, except for rgb images copied to rgba ones, which get full alpha.
+	// Throws ImageFormatException for other formats, compressed or empty images.
+	void copy(const Image &img, std::uint32_t x, std::uint32_t y);
 	void flipVerticaly();
 	
 	std::uint32_t getSize() const override;
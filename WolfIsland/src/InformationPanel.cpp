@@ -10,6 +10,7 @@ static const glm::vec2 wolfFemaleCounterOffset{ 166.0f, 88.0f + 30.0f };
 static const glm::vec2 hareCounterOffset{ 166.0f, 68.0f + 30.0f };
 static const glm::vec2 boulderCounterOffset{ 166.0f, 48.0f + 30.0f };
 static const glm::vec2 bushCounterOffset{ 166.0f, 28.0f + 30.0f };
+static const glm::vec2 statsOffset{ 10.0f, -20.0f };
 static const int32_t panelIndex{ 2 };
 
 InformationPanel::InformationPanel()
@@ -19,16 +20,18 @@ InformationPanel::InformationPanel()
 InformationPanel::InformationPanel(std::shared_ptr<class SpriteSheet> guiSpriteSheet, 
 	shared_ptr<class Text> wolfMaleCouterText, shared_ptr<class Text> woflFemaleCouterText, 
 	shared_ptr<class Text> hareCouterText, shared_ptr<class Text> boulderCouterText, 
-	shared_ptr<class Text> bushCouterText, const glm::vec2& pos, Renderer& renderer)
+	shared_ptr<class Text> bushCouterText, shared_ptr<class Text> statsText, const glm::vec2& pos,
+	Renderer& renderer)
 {
 	create(guiSpriteSheet, wolfMaleCouterText, woflFemaleCouterText, hareCouterText, 
-		boulderCouterText, bushCouterText, pos, renderer);
+		boulderCouterText, bushCouterText, statsText, pos, renderer);
 }
 
 void InformationPanel::create(shared_ptr<class SpriteSheet> guiSpriteSheet, 
 	shared_ptr<class Text> wolfMaleCouterText, shared_ptr<class Text> woflFemaleCouterText, 
 	shared_ptr<class Text> hareCouterText, shared_ptr<class Text> boulderCouterText, 
-	shared_ptr<class Text> bushCouterText, const glm::vec2& pos, Renderer& renderer)
+	shared_ptr<class Text> bushCouterText, shared_ptr<class Text> statsText, const glm::vec2& pos,
+	Renderer& renderer)
 {
 	mGuiSpriteSheet = guiSpriteSheet;
 	mWolfMaleCouterText = wolfMaleCouterText;
@@ -36,6 +39,7 @@ void InformationPanel::create(shared_ptr<class SpriteSheet> guiSpriteSheet,
 	mHareCouterText = hareCouterText;
 	mBoulderCouterText = boulderCouterText;
 	mBushCouterText = bushCouterText;
+	mStatsText = statsText;
 
 	// initial values set to 0;
 	string zeroStr = "0";
@@ -44,6 +48,7 @@ void InformationPanel::create(shared_ptr<class SpriteSheet> guiSpriteSheet,
 	mHareCouterText->updateContent(zeroStr, renderer);
 	mBoulderCouterText->updateContent(zeroStr, renderer);
 	mBushCouterText->updateContent(zeroStr, renderer);
+	updateStats(0, 0, 0, RendererCounters{}, renderer);
 
 	setPos(pos);
 }
@@ -55,21 +60,27 @@ InformationPanel::~InformationPanel()
 
 void InformationPanel::draw(Renderer& renderer) const
 {
-	renderer.prepareDrawSprite();
-	renderer.drawSprite(*mGuiSpriteSheet->getSprite(panelIndex).lock(),
+	renderer.submitSprite(RenderLayer::GUI, *mGuiSpriteSheet->getSprite(panelIndex).lock(),
 		glm::translate(glm::vec3{ mPos.x, mPos.y, 0.0f }));
 
-	renderer.prepareDrawText();
 	auto pos = mPos + wolfMaleCounterOffset;
-	renderer.drawText(*mWolfMaleCouterText, glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	renderer.submitText(RenderLayer::GUI_TEXT, *mWolfMaleCouterText,
+		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
 	pos = mPos + wolfFemaleCounterOffset;
-	renderer.drawText(*mWolfFemaleCouterText, glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	renderer.submitText(RenderLayer::GUI_TEXT, *mWolfFemaleCouterText,
+		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
 	pos = mPos + hareCounterOffset;
-	renderer.drawText(*mHareCouterText, glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	renderer.submitText(RenderLayer::GUI_TEXT, *mHareCouterText,
+		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
 	pos = mPos + boulderCounterOffset;
-	renderer.drawText(*mBoulderCouterText, glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	renderer.submitText(RenderLayer::GUI_TEXT, *mBoulderCouterText,
+		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
 	pos = mPos + bushCounterOffset;
-	renderer.drawText(*mBushCouterText, glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	renderer.submitText(RenderLayer::GUI_TEXT, *mBushCouterText,
+		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	pos = mPos + statsOffset;
+	renderer.submitText(RenderLayer::GUI_TEXT, *mStatsText,
+		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
 }
 
 void InformationPanel::grabInput(const glm::mat4& orthoMatrix, Application& app)
@@ -99,6 +110,19 @@ void InformationPanel::updateCounters(const std::array<std::int32_t, 5>& counter
 	mBushCouterText->updateContent(str.str(), renderer);
 }
 
+void InformationPanel::updateStats(uint32_t drawn, uint32_t cached, uint32_t culled,
+	const RendererCounters& counters, Renderer& renderer)
+{
+	stringstream str;
+	auto binds = counters.programBinds + counters.vertexArrayBinds + counters.textureBinds +
+		counters.samplerBinds + counters.capabilityChanges;
+
+	str << "Sprites " << drawn << ", cached " << cached << ", culled " << culled << "\nDraws "
+		<< counters.drawCalls << ", binds " << binds << ", avoided " << counters.avoidedStateChanges
+		<< ", orphans " << counters.bufferOrphans;
+	mStatsText->updateContent(str.str(), renderer);
+}
+
 void InformationPanel::setPos(const glm::vec2& pos)
 {
 	mPos = pos;
@@ -14,6 +14,7 @@ public:
 		std::shared_ptr<class Text> hareCouterText,
 		std::shared_ptr<class Text> boulderCouterText,
 		std::shared_ptr<class Text> bushCouterText, 
+		std::shared_ptr<class Text> statsText,
 		const glm::vec2& pos, class Renderer& renderer);
 	
 	void create(std::shared_ptr<class SpriteSheet> guiSpriteSheet,
@@ -22,6 +23,7 @@ public:
 		std::shared_ptr<class Text> hareCouterText,
 		std::shared_ptr<class Text> boulderCouterText,
 		std::shared_ptr<class Text> bushCouterText,
+		std::shared_ptr<class Text> statsText,
 		const glm::vec2& pos, class Renderer& renderer);
 
 	~InformationPanel();
@@ -32,6 +34,11 @@ public:
 
 	void updateCounters(const std::array<std::int32_t, 5>& counters, Renderer& renderer);
 
+	// Sprites and renderer calls of the last frame, drawn below the counters. Cached sprites
+	// are drawn from the static layer cache.
+	void updateStats(std::uint32_t drawn, std::uint32_t cached, std::uint32_t culled,
+		const struct RendererCounters& counters, Renderer& renderer);
+
 	void setPos(const glm::vec2& pos);
 
 private:
@@ -45,5 +52,6 @@ private:
 	std::shared_ptr<class Text> mHareCouterText;
 	std::shared_ptr<class Text> mBoulderCouterText;
 	std::shared_ptr<class Text> mBushCouterText;
+	std::shared_ptr<class Text> mStatsText;
 };
 
@@ -0,0 +1,389 @@
+#include "JobSystem.hpp"
+using namespace std;
+
+// Waiting threads look for new jobs at least this often
+static const chrono::microseconds idleWait{ 200 };
+
+// Worker of the system running on this thread, outside threads aren't workers of any
+static thread_local const JobSystem* currentSystem{ nullptr };
+static thread_local uint32_t currentWorker{ 0 };
+
+
+class Job
+{
+public:
+	std::function<void()> function;
+	JobAffinity affinity;
+
+	// Unfinished dependencies and one held while the job is being added
+	std::atomic<std::uint32_t> dependencies;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool finished;
+	std::exception_ptr exception;
+	std::vector<JobHandle> continuations;
+};
+
+
+JobSystem::JobSystem()
+	: mQueuedJobs{ 0 }, mNextQueue{ 0 }, mStopping{ false }
+{
+	create(0);
+}
+
+JobSystem::JobSystem(uint32_t workers)
+	: mQueuedJobs{ 0 }, mNextQueue{ 0 }, mStopping{ false }
+{
+	create(workers);
+}
+
+void JobSystem::create(uint32_t workers)
+{
+	destroy();
+
+	mMainThread = this_thread::get_id();
+	mQueues.clear();
+	mCounters.clear();
+
+	for (uint32_t i = 0; i <= workers; i++)
+	{
+		mQueues.push_back(make_unique<Queue>());
+		mCounters.push_back(make_unique<Counters>());
+	}
+
+	resetWorkerStats();
+	mQueuedJobs = 0;
+	mNextQueue = 0;
+	mStopping = false;
+
+	for (uint32_t i = 0; i < workers; i++)
+		mWorkers.emplace_back(&JobSystem::worker, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	destroy();
+}
+
+JobHandle JobSystem::add(function<void()> function, JobAffinity affinity)
+{
+	return add(move(function), vector<JobHandle>{}, affinity);
+}
+
+JobHandle JobSystem::add(function<void()> function, const vector<JobHandle>& dependencies,
+	JobAffinity affinity)
+{
+	auto job = make_shared<Job>();
+	job->function = move(function);
+	job->affinity = affinity;
+	job->dependencies = dependencies.size() + 1;
+	job->finished = false;
+
+	for (auto& d : dependencies)
+	{
+		lock_guard<std::mutex> lock{ d->mutex };
+
+		if (d->finished)
+			job->dependencies--;
+		else
+			d->continuations.push_back(job);
+	}
+
+	if (--job->dependencies == 0)
+		schedule(job);
+
+	return job;
+}
+
+void JobSystem::wait(const JobHandle& job)
+{
+	uint32_t queue = getQueue();
+	bool mainThread = isMainThread();
+
+	while (!isFinished(job))
+	{
+		JobHandle next = mainThread ? takeMain() : nullptr;
+
+		if (!next)
+			next = take(queue);
+
+		if (next)
+		{
+			execute(next, queue);
+			continue;
+		}
+
+		unique_lock<mutex> lock{ job->mutex };
+		job->condition.wait_for(lock, idleWait, [&job]() { return job->finished; });
+	}
+
+	if (job->exception)
+		rethrow_exception(job->exception);
+}
+
+void JobSystem::wait(const vector<JobHandle>& jobs)
+{
+	for (auto& job : jobs)
+		wait(job);
+}
+
+bool JobSystem::isFinished(const JobHandle& job) const
+{
+	lock_guard<mutex> lock{ job->mutex };
+	return job->finished;
+}
+
+void JobSystem::parallelFor(size_t count, size_t batchSize,
+	const function<void(size_t, size_t)>& function)
+{
+	batchSize = max<size_t>(batchSize, 1);
+
+	if (count <= batchSize)
+	{
+		if (count > 0)
+			function(0, count);
+
+		return;
+	}
+
+	vector<JobHandle> batches;
+
+	for (size_t first = batchSize; first < count; first += batchSize)
+	{
+		size_t last = min(first + batchSize, count);
+		batches.push_back(add([&function, first, last]() { function(first, last); }));
+	}
+
+	// The caller takes the first batch instead of waiting idle
+	exception_ptr exception;
+
+	try
+	{
+		function(0, batchSize);
+	}
+	catch (...)
+	{
+		exception = current_exception();
+	}
+
+	// Batches refer to the function, all of them have to finish before leaving
+	for (auto& b : batches)
+	{
+		try
+		{
+			wait(b);
+		}
+		catch (...)
+		{
+			if (!exception)
+				exception = current_exception();
+		}
+	}
+
+	if (exception)
+		rethrow_exception(exception);
+}
+
+void JobSystem::runMainThreadJobs()
+{
+	uint32_t queue = getQueue();
+
+	while (auto job = takeMain())
+		execute(job, queue);
+}
+
+uint32_t JobSystem::getWorkersCount() const
+{
+	return mWorkers.size();
+}
+
+bool JobSystem::isMainThread() const
+{
+	return this_thread::get_id() == mMainThread;
+}
+
+vector<JobWorkerStats> JobSystem::getWorkerStats() const
+{
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - mStatsStart).count();
+	vector<JobWorkerStats> stats;
+
+	for (auto& c : mCounters)
+	{
+		double busy = c->busyNanoseconds * 1e-9;
+		stats.push_back({ c->jobs, c->steals, busy, elapsed > 0.0 ? busy / elapsed : 0.0 });
+	}
+
+	return stats;
+}
+
+void JobSystem::resetWorkerStats()
+{
+	for (auto& c : mCounters)
+	{
+		c->jobs = 0;
+		c->steals = 0;
+		c->busyNanoseconds = 0;
+	}
+
+	mStatsStart = chrono::steady_clock::now();
+}
+
+uint32_t JobSystem::GetDefaultWorkers()
+{
+	return max(thread::hardware_concurrency(), 1u) - 1;
+}
+
+void JobSystem::destroy()
+{
+	{
+		lock_guard<mutex> lock{ mWakeMutex };
+		mStopping = true;
+	}
+
+	mWakeCondition.notify_all();
+
+	for (auto& w : mWorkers)
+		w.join();
+
+	mWorkers.clear();
+}
+
+void JobSystem::worker(uint32_t index)
+{
+	currentSystem = this;
+	currentWorker = index;
+
+	while (true)
+	{
+		if (auto job = take(index))
+		{
+			execute(job, index);
+			continue;
+		}
+
+		unique_lock<mutex> lock{ mWakeMutex };
+		mWakeCondition.wait(lock, [this]() { return mStopping || mQueuedJobs > 0; });
+
+		if (mStopping)
+			return;
+	}
+}
+
+void JobSystem::schedule(const JobHandle& job)
+{
+	if (job->affinity == JobAffinity::MAIN)
+	{
+		lock_guard<mutex> lock{ mMainQueue.mutex };
+		mMainQueue.jobs.push_back(job);
+		return;
+	}
+
+	// Forked jobs stay with their worker, others are spread over all queues
+	uint32_t queue = currentSystem == this ? currentWorker : mNextQueue++ % mQueues.size();
+
+	{
+		lock_guard<mutex> lock{ mQueues[queue]->mutex };
+		mQueues[queue]->jobs.push_back(job);
+		mQueuedJobs++;
+	}
+
+	// Taking the lock orders the notification after a worker checked for jobs
+	{
+		lock_guard<mutex> lock{ mWakeMutex };
+	}
+
+	mWakeCondition.notify_one();
+}
+
+JobHandle JobSystem::take(uint32_t queue)
+{
+	for (uint32_t i = 0; i < mQueues.size(); i++)
+	{
+		uint32_t victim = (queue + i) % mQueues.size();
+		auto& q = *mQueues[victim];
+		lock_guard<mutex> lock{ q.mutex };
+
+		if (q.jobs.empty())
+			continue;
+
+		JobHandle job;
+
+		// Own jobs are taken newest first while their data is still in cache
+		if (i == 0)
+		{
+			job = move(q.jobs.back());
+			q.jobs.pop_back();
+		}
+		else
+		{
+			job = move(q.jobs.front());
+			q.jobs.pop_front();
+			mCounters[queue]->steals++;
+		}
+
+		mQueuedJobs--;
+		return job;
+	}
+
+	return nullptr;
+}
+
+JobHandle JobSystem::takeMain()
+{
+	lock_guard<mutex> lock{ mMainQueue.mutex };
+
+	if (mMainQueue.jobs.empty())
+		return nullptr;
+
+	auto job = move(mMainQueue.jobs.front());
+	mMainQueue.jobs.pop_front();
+	return job;
+}
+
+void JobSystem::execute(const JobHandle& job, uint32_t queue)
+{
+	auto start = chrono::steady_clock::now();
+
+	try
+	{
+		job->function();
+	}
+	catch (...)
+	{
+		job->exception = current_exception();
+	}
+
+	auto& counters = *mCounters[queue];
+	counters.jobs++;
+	counters.busyNanoseconds += chrono::duration_cast<chrono::nanoseconds>(
+		chrono::steady_clock::now() - start).count();
+
+	finish(job);
+}
+
+void JobSystem::finish(const JobHandle& job)
+{
+	vector<JobHandle> continuations;
+
+	{
+		lock_guard<mutex> lock{ job->mutex };
+		job->finished = true;
+		job->function = nullptr;
+		swap(continuations, job->continuations);
+	}
+
+	job->condition.notify_all();
+
+	for (auto& c : continuations)
+	{
+		if (--c->dependencies == 0)
+			schedule(c);
+	}
+}
+
+uint32_t JobSystem::getQueue() const
+{
+	return currentSystem == this ? currentWorker : mQueues.size() - 1;
+}
+
@@ -0,0 +1,107 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include <functional>
+#include <exception>
+
+
+// Threads allowed to run a job, gpu resources can only be touched by the main thread
+enum class JobAffinity
+{
+	ANY,
+	MAIN
+};
+
+typedef std::shared_ptr<class Job> JobHandle;
+
+// Work done by a single thread since the counters were reset
+struct JobWorkerStats
+{
+	std::uint64_t jobs;
+	std::uint64_t steals;
+	double busyTime;
+	double utilisation;
+};
+
+// Work stealing scheduler. Every worker owns a deque, it runs its newest jobs first and
+// steals the oldest ones of others when it runs out of work. Threads waiting for a job help
+// with running others, so jobs can fork and join without blocking workers. Jobs can be
+// continuations started only after their dependencies are finished.
+class JobSystem
+{
+public:
+	JobSystem();
+
+	// Threads waiting for jobs take part too, so with no workers jobs run only inside wait()
+	JobSystem(std::uint32_t workers);
+	void create(std::uint32_t workers);
+
+	~JobSystem();
+
+	JobHandle add(std::function<void()> function, JobAffinity affinity = JobAffinity::ANY);
+
+	// Continuation started after all dependencies are finished
+	JobHandle add(std::function<void()> function, const std::vector<JobHandle>& dependencies,
+		JobAffinity affinity = JobAffinity::ANY);
+
+	// Runs other jobs until the job is finished and rethrows its exception. Main thread jobs
+	// are run only by waits on the thread which created the system.
+	void wait(const JobHandle& job);
+	void wait(const std::vector<JobHandle>& jobs);
+	bool isFinished(const JobHandle& job) const;
+
+	// Splits [0, count) to ranges of batchSize and blocks until all of them are done
+	void parallelFor(std::size_t count, std::size_t batchSize,
+		const std::function<void(std::size_t, std::size_t)>& function);
+
+	// Runs ready main thread jobs without waiting for others, called once per frame
+	void runMainThreadJobs();
+
+	std::uint32_t getWorkersCount() const;
+	bool isMainThread() const;
+
+	// Workers followed by threads outside the system, which share the last entry
+	std::vector<JobWorkerStats> getWorkerStats() const;
+	void resetWorkerStats();
+
+	// One worker less than hardware threads, the main thread is busy too
+	static std::uint32_t GetDefaultWorkers();
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	struct Counters
+	{
+		std::atomic<std::uint64_t> jobs;
+		std::atomic<std::uint64_t> steals;
+		std::atomic<std::uint64_t> busyNanoseconds;
+	};
+
+	std::vector<std::thread> mWorkers;
+	std::thread::id mMainThread;
+
+	// Queue of every worker and a shared one for outside threads
+	std::vector<std::unique_ptr<Queue>> mQueues;
+	std::vector<std::unique_ptr<Counters>> mCounters;
+	std::chrono::steady_clock::time_point mStatsStart;
+	Queue mMainQueue;
+
+	std::atomic<std::uint32_t> mQueuedJobs;
+	std::atomic<std::uint32_t> mNextQueue;
+	std::mutex mWakeMutex;
+	std::condition_variable mWakeCondition;
+	bool mStopping;
+
+	void destroy();
+	void worker(std::uint32_t index);
+	void schedule(const JobHandle& job);
+	JobHandle take(std::uint32_t queue);
+	JobHandle takeMain();
+	void execute(const JobHandle& job, std::uint32_t queue);
+	void finish(const JobHandle& job);
+	std::uint32_t getQueue() const;
+};
+
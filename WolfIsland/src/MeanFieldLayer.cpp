@@ -0,0 +1,609 @@
+#include "MeanFieldLayer.hpp"
+#include "CounterRandom.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MEAN_FIELD_AVX2
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace std;
+
+// Same order as agents scan their surroundings
+static const array<glm::tvec2<int32_t>, 8> directions{ {
+	{ -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } } };
+
+// Fewer trials are sampled one by one, more use the normal approximation
+static const uint32_t exactLimit{ 16 };
+
+// Numbers of random draws of a cell: 4 for every approximated binomial, then the direction
+// offset, then one for every exact trial
+static const uint32_t offsetCounter{ 12 };
+static const uint32_t exactCounter{ 16 };
+static const float sqrt3{ 1.7320508f };
+static const float uniformScale{ 1.0f / 16777216.0f };
+
+
+static inline float Uniform(uint32_t cellKey, uint32_t counter)
+{
+	return static_cast<float>(CounterRandom::Hash(cellKey + counter) >> 8) * uniformScale;
+}
+
+static inline uint32_t PopCount8(uint32_t x)
+{
+	x = x - ((x >> 1) & 0x55u);
+	x = (x & 0x33u) + ((x >> 2) & 0x33u);
+
+	return (x + (x >> 4)) & 0x0Fu;
+}
+
+#ifdef MEAN_FIELD_AVX2
+// Same mix as CounterRandom::Hash in every lane
+AVX2_FUNCTION static inline __m256i HashAvx2(__m256i x)
+{
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int32_t>(0x846ca68bu)));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+
+	return x;
+}
+
+AVX2_FUNCTION static inline __m256 UniformAvx2(__m256i cellKey, uint32_t counter)
+{
+	__m256i h = HashAvx2(_mm256_add_epi32(cellKey, _mm256_set1_epi32(counter)));
+	return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)),
+		_mm256_set1_ps(uniformScale));
+}
+
+AVX2_FUNCTION static inline __m256i PopCount8Avx2(__m256i x)
+{
+	x = _mm256_sub_epi32(x, _mm256_and_si256(_mm256_srli_epi32(x, 1), _mm256_set1_epi32(0x55)));
+	x = _mm256_add_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x33)),
+		_mm256_and_si256(_mm256_srli_epi32(x, 2), _mm256_set1_epi32(0x33)));
+
+	return _mm256_and_si256(_mm256_add_epi32(x, _mm256_srli_epi32(x, 4)),
+		_mm256_set1_epi32(0x0F));
+}
+
+// True when some lane has between 1 and exactLimit - 1 trials
+AVX2_FUNCTION static inline bool NeedsExactAvx2(__m256i trials)
+{
+	__m256i small = _mm256_cmpgt_epi32(_mm256_set1_epi32(exactLimit), trials);
+	__m256i empty = _mm256_cmpeq_epi32(trials, _mm256_setzero_si256());
+
+	return !_mm256_testc_si256(empty, small);
+}
+
+// Normal approximation only, lanes must have no trials or at least exactLimit trials
+AVX2_FUNCTION static inline __m256i BinomialAvx2(__m256i trials, float chance,
+	__m256i cellKey, uint32_t stage)
+{
+	__m256 trialsF = _mm256_cvtepi32_ps(trials);
+	__m256 mean = _mm256_mul_ps(trialsF, _mm256_set1_ps(chance));
+	__m256 deviation = _mm256_sqrt_ps(_mm256_mul_ps(mean, _mm256_set1_ps(1.0f - chance)));
+
+	__m256 sum = _mm256_add_ps(
+		_mm256_add_ps(UniformAvx2(cellKey, stage * 4), UniformAvx2(cellKey, stage * 4 + 1)),
+		_mm256_add_ps(UniformAvx2(cellKey, stage * 4 + 2), UniformAvx2(cellKey, stage * 4 + 3)));
+	__m256 z = _mm256_mul_ps(_mm256_sub_ps(sum, _mm256_set1_ps(2.0f)), _mm256_set1_ps(sqrt3));
+
+	__m256 value = _mm256_floor_ps(_mm256_add_ps(
+		_mm256_add_ps(mean, _mm256_mul_ps(deviation, z)), _mm256_set1_ps(0.5f)));
+	value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), trialsF);
+
+	return _mm256_cvttps_epi32(value);
+}
+#endif
+
+
+MeanFieldOptions::MeanFieldOptions()
+	: enabled{ false }, regionSize{ 8 }, countDensity{ 4.0f }, agentDensity{ 1.0f }
+{
+}
+
+MeanFieldLayer::MeanFieldLayer()
+	: mWidth{ 0 }, mHeight{ 0 }, mRegionSize{ 1 }, mRegionsWidth{ 0 }, mRegionsHeight{ 0 },
+	mSeed{ 0 }, mSimdEnabled{ IsAvx2Supported() }
+{
+}
+
+MeanFieldLayer::MeanFieldLayer(uint32_t width, uint32_t height, uint32_t regionSize,
+	uint32_t seed)
+	: mWidth{ 0 }, mHeight{ 0 }, mRegionSize{ 1 }, mRegionsWidth{ 0 }, mRegionsHeight{ 0 },
+	mSeed{ 0 }, mSimdEnabled{ IsAvx2Supported() }
+{
+	create(width, height, regionSize, seed);
+}
+
+void MeanFieldLayer::create(uint32_t width, uint32_t height, uint32_t regionSize,
+	uint32_t seed)
+{
+	mWidth = width;
+	mHeight = height;
+	mRegionSize = max(regionSize, 1u);
+	mRegionsWidth = (width + mRegionSize - 1) / mRegionSize;
+	mRegionsHeight = (height + mRegionSize - 1) / mRegionSize;
+	mSeed = seed;
+
+	mCounts.assign(width * height, 0);
+	mNextCounts.assign(width * height, 0);
+	mRegionCounted.assign(mRegionsWidth * mRegionsHeight, 0);
+	mStay.assign(width * height, 0);
+	mShares.assign(width * height, 0);
+	mExtraMoves.assign(width * height, 0);
+	mDirtyRegions.markAll();
+
+	setBlocked({});
+}
+
+MeanFieldLayer::~MeanFieldLayer()
+{
+}
+
+void MeanFieldLayer::setBlocked(const vector<glm::tvec2<int32_t>>& cells)
+{
+	mOpen.assign(mWidth * mHeight, 0xFFFFFFFFu);
+
+	for (auto& c : cells)
+	{
+		if (c.x >= 0 && c.y >= 0 && c.x < static_cast<int32_t>(mWidth) &&
+			c.y < static_cast<int32_t>(mHeight))
+		{
+			mOpen[c.y * mWidth + c.x] = 0;
+			mCounts[c.y * mWidth + c.x] = 0;
+		}
+	}
+
+	mValidMoves.assign(mWidth * mHeight, 0);
+	mDirtyCounts.markAll();
+
+	for (int32_t y = 0; y < static_cast<int32_t>(mHeight); y++)
+	{
+		for (int32_t x = 0; x < static_cast<int32_t>(mWidth); x++)
+		{
+			for (uint32_t d = 0; d < directions.size(); d++)
+			{
+				int32_t nx = x + directions[d].x;
+				int32_t ny = y + directions[d].y;
+
+				if (nx >= 0 && ny >= 0 && nx < static_cast<int32_t>(mWidth) &&
+					ny < static_cast<int32_t>(mHeight) && mOpen[ny * mWidth + nx])
+					mValidMoves[y * mWidth + x] |= 1u << d;
+			}
+		}
+	}
+}
+
+void MeanFieldLayer::update(const SimulationParameters& parameters, vector<float>& food,
+	DirtyChunks<float>& foodChunks, uint32_t turn)
+{
+	if (mCounts.empty())
+		return;
+
+	// Agents live (min + max) / 2 turns on average and split after the split time
+	// and a geometric wait with the split chance
+	TurnConstants constants;
+	constants.turnKey = CounterRandom::Hash(mSeed ^ CounterRandom::Hash(turn));
+	constants.deathChance = 2.0f / max(parameters.minLifeTours + parameters.maxLifeTours, 1u);
+	constants.birthChance = parameters.splitChance <= 0 ? 0.0f :
+		1.0f / (parameters.splitTourTime + 101.0f / parameters.splitChance);
+	constants.moveChance = 8.0f / 9.0f;
+	constants.appetite = max(parameters.hareAppetite, 0.0f);
+
+	updateCells(constants, food, foodChunks, 0, mWidth * mHeight);
+
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		gatherCells(mNextCounts, y, 0, mWidth);
+
+		// Cells without hares stay empty, chunks of the row are marked when some cell changed
+		for (uint32_t i = y * mWidth, last; i < (y + 1) * mWidth; i = last)
+		{
+			last = min<uint32_t>((y + 1) * mWidth, i + ChunkedArray<uint32_t>::chunkSize -
+				i % ChunkedArray<uint32_t>::chunkSize);
+
+			if (!equal(begin(mNextCounts) + i, begin(mNextCounts) + last, begin(mCounts) + i))
+				mDirtyCounts.mark(i);
+		}
+	}
+
+	swap(mCounts, mNextCounts);
+}
+
+uint32_t MeanFieldLayer::getCount(const glm::tvec2<int32_t>& pos) const
+{
+	if (pos.x < 0 || pos.y < 0 || pos.x >= static_cast<int32_t>(mWidth) ||
+		pos.y >= static_cast<int32_t>(mHeight))
+		return 0;
+
+	return mCounts[pos.y * mWidth + pos.x];
+}
+
+void MeanFieldLayer::add(const glm::tvec2<int32_t>& pos, uint32_t count)
+{
+	if (pos.x >= 0 && pos.y >= 0 && pos.x < static_cast<int32_t>(mWidth) &&
+		pos.y < static_cast<int32_t>(mHeight) && mOpen[pos.y * mWidth + pos.x])
+	{
+		mCounts[pos.y * mWidth + pos.x] += count;
+		mDirtyCounts.mark(pos.y * mWidth + pos.x);
+	}
+}
+
+bool MeanFieldLayer::take(const glm::tvec2<int32_t>& pos)
+{
+	if (getCount(pos) == 0)
+		return false;
+
+	mCounts[pos.y * mWidth + pos.x]--;
+	mDirtyCounts.mark(pos.y * mWidth + pos.x);
+
+	return true;
+}
+
+uint32_t MeanFieldLayer::takeAll(uint32_t cell)
+{
+	uint32_t count = mCounts[cell];
+	mCounts[cell] = 0;
+	mDirtyCounts.mark(cell);
+
+	return count;
+}
+
+uint64_t MeanFieldLayer::getTotal() const
+{
+	return accumulate(begin(mCounts), end(mCounts), uint64_t{ 0 });
+}
+
+const vector<uint32_t>& MeanFieldLayer::getCounts() const
+{
+	return mCounts;
+}
+
+bool MeanFieldLayer::setCounts(const vector<uint32_t>& counts)
+{
+	if (counts.size() != mCounts.size())
+		return false;
+
+	mCounts = counts;
+	mDirtyCounts.markAll();
+
+	return true;
+}
+
+uint32_t MeanFieldLayer::getRegion(const glm::tvec2<int32_t>& pos) const
+{
+	return pos.y / mRegionSize * mRegionsWidth + pos.x / mRegionSize;
+}
+
+uint32_t MeanFieldLayer::getRegionsCount() const
+{
+	return mRegionCounted.size();
+}
+
+uint32_t MeanFieldLayer::getRegionCells(uint32_t region) const
+{
+	glm::tvec2<uint32_t> first, last;
+	getRegionBounds(region, first, last);
+
+	return (last.x - first.x) * (last.y - first.y);
+}
+
+bool MeanFieldLayer::isRegionCounted(uint32_t region) const
+{
+	return mRegionCounted[region] != 0;
+}
+
+void MeanFieldLayer::setRegionCounted(uint32_t region, bool counted)
+{
+	if (isRegionCounted(region) != counted)
+		mDirtyRegions.mark(region);
+
+	mRegionCounted[region] = counted ? 1 : 0;
+}
+
+vector<uint64_t> MeanFieldLayer::getRegionTotals() const
+{
+	vector<uint64_t> totals(mRegionCounted.size(), 0);
+
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		for (uint32_t x = 0; x < mWidth; x++)
+			totals[y / mRegionSize * mRegionsWidth + x / mRegionSize] += mCounts[y * mWidth + x];
+	}
+
+	return totals;
+}
+
+const vector<uint8_t>& MeanFieldLayer::getCountedRegions() const
+{
+	return mRegionCounted;
+}
+
+const DirtyChunks<uint8_t>& MeanFieldLayer::getDirtyRegions() const
+{
+	return mDirtyRegions;
+}
+
+const DirtyChunks<uint32_t>& MeanFieldLayer::getDirtyCounts() const
+{
+	return mDirtyCounts;
+}
+
+void MeanFieldLayer::clearDirtyChunks()
+{
+	mDirtyCounts.clear();
+	mDirtyRegions.clear();
+}
+
+void MeanFieldLayer::getRegionBounds(uint32_t region, glm::tvec2<uint32_t>& first,
+	glm::tvec2<uint32_t>& last) const
+{
+	first = { region % mRegionsWidth * mRegionSize, region / mRegionsWidth * mRegionSize };
+	last = { min(first.x + mRegionSize, mWidth), min(first.y + mRegionSize, mHeight) };
+}
+
+void MeanFieldLayer::setSimdEnabled(bool enabled)
+{
+	mSimdEnabled = enabled && IsAvx2Supported();
+}
+
+bool MeanFieldLayer::isSimdEnabled() const
+{
+	return mSimdEnabled;
+}
+
+#ifdef MEAN_FIELD_AVX2
+// Returns false without writing anything when some lane needs exact sampling
+AVX2_FUNCTION static bool UpdateBlockAvx2(uint32_t first, const uint32_t* counts, float* food,
+	const uint32_t* validMoves, uint32_t* stay, uint32_t* shares, uint32_t* extraMoves,
+	uint32_t turnKey, float deathChance, float birthChance, float moveChance, float appetite)
+{
+	__m256i count = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(counts));
+
+	if (_mm256_testz_si256(count, count))
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(stay), count);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(shares), count);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(extraMoves), count);
+		return true;
+	}
+
+	if (NeedsExactAvx2(count))
+		return false;
+
+	__m256i fed = count;
+	__m256 foodLeft = _mm256_loadu_ps(food);
+
+	if (appetite > 0.0f)
+	{
+		__m256 appetiteVec = _mm256_set1_ps(appetite);
+		__m256 fedF = _mm256_min_ps(_mm256_floor_ps(_mm256_div_ps(foodLeft, appetiteVec)),
+			_mm256_cvtepi32_ps(count));
+
+		fed = _mm256_cvttps_epi32(fedF);
+		foodLeft = _mm256_sub_ps(foodLeft, _mm256_mul_ps(fedF, appetiteVec));
+	}
+
+	if (NeedsExactAvx2(fed))
+		return false;
+
+	__m256i cell = _mm256_add_epi32(_mm256_set1_epi32(first),
+		_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	__m256i cellKey = HashAvx2(_mm256_xor_si256(cell, _mm256_set1_epi32(turnKey)));
+
+	__m256i deaths = BinomialAvx2(count, deathChance, cellKey, 0);
+	__m256i births = BinomialAvx2(fed, birthChance, cellKey, 1);
+	__m256i alive = _mm256_add_epi32(_mm256_sub_epi32(count, deaths), births);
+
+	if (NeedsExactAvx2(alive))
+		return false;
+
+	__m256i movers = BinomialAvx2(alive, moveChance, cellKey, 2);
+	__m256i share = _mm256_srli_epi32(movers, 3);
+	__m256i remainder = _mm256_and_si256(movers, _mm256_set1_epi32(7));
+	__m256i offset = _mm256_and_si256(HashAvx2(_mm256_add_epi32(cellKey,
+		_mm256_set1_epi32(offsetCounter))), _mm256_set1_epi32(7));
+
+	// Remainder goes to consecutive directions starting at a random one
+	__m256i mask = _mm256_sub_epi32(_mm256_sllv_epi32(_mm256_set1_epi32(1), remainder),
+		_mm256_set1_epi32(1));
+	__m256i extra = _mm256_and_si256(_mm256_or_si256(_mm256_sllv_epi32(mask, offset),
+		_mm256_srlv_epi32(mask, _mm256_sub_epi32(_mm256_set1_epi32(8), offset))),
+		_mm256_set1_epi32(0xFF));
+
+	// Hares moving into blocked cells or off the board stay
+	__m256i valid = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(validMoves));
+	__m256i reflected = _mm256_add_epi32(
+		_mm256_mullo_epi32(share, _mm256_sub_epi32(_mm256_set1_epi32(8), PopCount8Avx2(valid))),
+		PopCount8Avx2(_mm256_andnot_si256(valid, extra)));
+
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(stay),
+		_mm256_add_epi32(_mm256_sub_epi32(alive, movers), reflected));
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(shares), share);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(extraMoves), _mm256_and_si256(extra, valid));
+	_mm256_storeu_ps(food, foodLeft);
+
+	return true;
+}
+
+AVX2_FUNCTION static void GatherRowAvx2(const uint32_t* stay, const uint32_t* shares,
+	const uint32_t* extraMoves, const uint32_t* open, uint32_t* next, int32_t width,
+	uint32_t first, uint32_t last)
+{
+	for (uint32_t x = first; x + 8 <= last; x += 8)
+	{
+		__m256i sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(stay + x));
+
+		for (uint32_t d = 0; d < directions.size(); d++)
+		{
+			// Neighbour sending in direction d lands here
+			int32_t source = static_cast<int32_t>(x) - directions[d].y * width - directions[d].x;
+			__m256i share = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shares + source));
+			__m256i extra = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(extraMoves + source));
+
+			sum = _mm256_add_epi32(sum, share);
+			sum = _mm256_add_epi32(sum, _mm256_and_si256(
+				_mm256_srlv_epi32(extra, _mm256_set1_epi32(d)), _mm256_set1_epi32(1)));
+		}
+
+		sum = _mm256_and_si256(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(open + x)));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(next + x), sum);
+	}
+}
+#endif
+
+void MeanFieldLayer::updateCells(const TurnConstants& constants, vector<float>& food,
+	DirtyChunks<float>& foodChunks, uint32_t first, uint32_t last)
+{
+	uint32_t i = first;
+
+#ifdef MEAN_FIELD_AVX2
+	if (mSimdEnabled)
+	{
+		for (; i + 8 <= last; i += 8)
+		{
+			if (UpdateBlockAvx2(i, &mCounts[i], &food[i], &mValidMoves[i], &mStay[i], &mShares[i],
+				&mExtraMoves[i], constants.turnKey, constants.deathChance, constants.birthChance,
+				constants.moveChance, constants.appetite))
+			{
+				// Blocks without hares don't write food
+				if (constants.appetite > 0.0f && any_of(&mCounts[i], &mCounts[i] + 8,
+					[](uint32_t count) { return count > 0; }))
+					foodChunks.mark(i, i + 8);
+
+				continue;
+			}
+
+			for (uint32_t j = i; j < i + 8; j++)
+				updateCell(constants, food, foodChunks, j);
+		}
+	}
+#endif
+
+	for (; i < last; i++)
+		updateCell(constants, food, foodChunks, i);
+}
+
+void MeanFieldLayer::updateCell(const TurnConstants& constants, vector<float>& food,
+	DirtyChunks<float>& foodChunks, uint32_t i)
+{
+	uint32_t count = mCounts[i];
+
+	if (count == 0)
+	{
+		mStay[i] = mShares[i] = mExtraMoves[i] = 0;
+		return;
+	}
+
+	uint32_t fed = count;
+
+	if (constants.appetite > 0.0f)
+	{
+		float fedF = min(floor(food[i] / constants.appetite), static_cast<float>(count));
+		fed = static_cast<uint32_t>(fedF);
+		food[i] = food[i] - fedF * constants.appetite;
+		foodChunks.mark(i);
+	}
+
+	uint32_t cellKey = CounterRandom::Hash(i ^ constants.turnKey);
+	uint32_t deaths = Binomial(count, constants.deathChance, cellKey, 0);
+	uint32_t births = Binomial(fed, constants.birthChance, cellKey, 1);
+	uint32_t alive = count - deaths + births;
+	uint32_t movers = Binomial(alive, constants.moveChance, cellKey, 2);
+
+	uint32_t share = movers >> 3;
+	uint32_t mask = (1u << (movers & 7)) - 1;
+	uint32_t offset = CounterRandom::Hash(cellKey + offsetCounter) & 7;
+	uint32_t extra = ((mask << offset) | (mask >> (8 - offset))) & 0xFFu;
+	uint32_t valid = mValidMoves[i];
+
+	mStay[i] = alive - movers + share * (8 - PopCount8(valid)) + PopCount8(extra & ~valid);
+	mShares[i] = share;
+	mExtraMoves[i] = extra & valid;
+}
+
+void MeanFieldLayer::gatherCells(vector<uint32_t>& next, uint32_t y, uint32_t first,
+	uint32_t last) const
+{
+	uint32_t row = y * mWidth;
+	bool innerRow = y > 0 && y + 1 < mHeight;
+
+	for (uint32_t x = first; x < last; x++)
+	{
+		// Inner cells of inner rows are left for the vector loop
+#ifdef MEAN_FIELD_AVX2
+		if (mSimdEnabled && innerRow && x > 0 && x + 1 < mWidth && mWidth >= 10)
+		{
+			uint32_t end = min(last, mWidth - 1);
+			uint32_t vectorEnd = x + (end - x) / 8 * 8;
+
+			GatherRowAvx2(mStay.data() + row, mShares.data() + row, mExtraMoves.data() + row,
+				mOpen.data() + row, next.data() + row, mWidth, x, vectorEnd);
+
+			if (vectorEnd > x)
+			{
+				x = vectorEnd - 1;
+				continue;
+			}
+		}
+#endif
+
+		uint32_t sum = mStay[row + x];
+
+		for (uint32_t d = 0; d < directions.size(); d++)
+		{
+			int32_t sx = static_cast<int32_t>(x) - directions[d].x;
+			int32_t sy = static_cast<int32_t>(y) - directions[d].y;
+
+			if (sx < 0 || sy < 0 || sx >= static_cast<int32_t>(mWidth) ||
+				sy >= static_cast<int32_t>(mHeight))
+				continue;
+
+			uint32_t source = sy * mWidth + sx;
+			sum += mShares[source] + ((mExtraMoves[source] >> d) & 1);
+		}
+
+		next[row + x] = sum & mOpen[row + x];
+	}
+}
+
+uint32_t MeanFieldLayer::Binomial(uint32_t trials, float chance, uint32_t cellKey,
+	uint32_t stage)
+{
+	if (trials == 0)
+		return 0;
+
+	if (trials < exactLimit)
+	{
+		uint32_t successes{ 0 };
+
+		for (uint32_t k = 0; k < trials; k++)
+		{
+			if (Uniform(cellKey, exactCounter + stage * exactLimit + k) < chance)
+				successes++;
+		}
+
+		return successes;
+	}
+
+	// Same operations as the vector kernel
+	float trialsF = static_cast<float>(trials);
+	float mean = trialsF * chance;
+	float deviation = sqrt(mean * (1.0f - chance));
+
+	float sum = (Uniform(cellKey, stage * 4) + Uniform(cellKey, stage * 4 + 1)) +
+		(Uniform(cellKey, stage * 4 + 2) + Uniform(cellKey, stage * 4 + 3));
+	float z = (sum - 2.0f) * sqrt3;
+	float value = floor((mean + deviation * z) + 0.5f);
+
+	return static_cast<uint32_t>(min(max(value, 0.0f), trialsF));
+}
+
@@ -0,0 +1,133 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "SimulationParameters.hpp"
+#include "ChunkedArray.hpp"
+#include <glm/vec2.hpp>
+
+
+// Decides when regions of the board keep hares as per cell counts instead of agents
+struct MeanFieldOptions
+{
+	MeanFieldOptions();
+
+	bool enabled;
+
+	// Side of square regions switching representation together
+	std::uint32_t regionSize;
+
+	// Hares per cell turning an agent region into counts, and a counted region back to agents.
+	// Gap between them avoids switching every turn.
+	float countDensity;
+	float agentDensity;
+};
+
+// Hares of dense regions stored as counts in every cell. Each turn counts are updated with
+// binomial deaths, births of fed hares and moves to the 8 neighbours, like agents do.
+// Large counts use the normal approximation, small ones are sampled exactly.
+// Random numbers come from hashing the cell, turn and draw number, so the AVX2 and scalar
+// kernels give identical counts.
+class MeanFieldLayer
+{
+public:
+	MeanFieldLayer();
+
+	MeanFieldLayer(std::uint32_t width, std::uint32_t height, std::uint32_t regionSize,
+		std::uint32_t seed);
+	void create(std::uint32_t width, std::uint32_t height, std::uint32_t regionSize,
+		std::uint32_t seed);
+
+	~MeanFieldLayer();
+
+	void setBlocked(const std::vector<glm::tvec2<std::int32_t>>& cells);
+
+	// Births, deaths and moves of counted hares for one turn, fed hares eat from food and
+	// mark the cells they ate from
+	void update(const SimulationParameters& parameters, std::vector<float>& food,
+		DirtyChunks<float>& foodChunks, std::uint32_t turn);
+
+	std::uint32_t getCount(const glm::tvec2<std::int32_t>& pos) const;
+	void add(const glm::tvec2<std::int32_t>& pos, std::uint32_t count);
+
+	// Removes one hare from the cell, returns false when the cell is empty
+	bool take(const glm::tvec2<std::int32_t>& pos);
+
+	// Removes all hares from the cell and returns their number
+	std::uint32_t takeAll(std::uint32_t cell);
+
+	std::uint64_t getTotal() const;
+	const std::vector<std::uint32_t>& getCounts() const;
+
+	// Counts of all cells, returns false when their number doesn't match the layer
+	bool setCounts(const std::vector<std::uint32_t>& counts);
+
+	// Counts written since the chunks were cleared
+	const DirtyChunks<std::uint32_t>& getDirtyCounts() const;
+
+	// Regions
+	std::uint32_t getRegion(const glm::tvec2<std::int32_t>& pos) const;
+	std::uint32_t getRegionsCount() const;
+	std::uint32_t getRegionCells(std::uint32_t region) const;
+	bool isRegionCounted(std::uint32_t region) const;
+	void setRegionCounted(std::uint32_t region, bool counted);
+	std::vector<std::uint64_t> getRegionTotals() const;
+
+	// 1 for counted regions, 0 for agent ones, and regions switched since they were cleared
+	const std::vector<std::uint8_t>& getCountedRegions() const;
+	const DirtyChunks<std::uint8_t>& getDirtyRegions() const;
+
+	void clearDirtyChunks();
+
+	// Cell indices of a region, row by row
+	void getRegionBounds(std::uint32_t region, glm::tvec2<std::uint32_t>& first,
+		glm::tvec2<std::uint32_t>& last) const;
+
+	// Forces the scalar kernels, used to compare both paths
+	void setSimdEnabled(bool enabled);
+	bool isSimdEnabled() const;
+
+private:
+	// Per turn constants shared by kernels
+	struct TurnConstants
+	{
+		std::uint32_t turnKey;
+		float deathChance;
+		float birthChance;
+		float moveChance;
+		float appetite;
+	};
+
+	std::uint32_t mWidth;
+	std::uint32_t mHeight;
+	std::uint32_t mRegionSize;
+	std::uint32_t mRegionsWidth;
+	std::uint32_t mRegionsHeight;
+	std::uint32_t mSeed;
+	bool mSimdEnabled;
+
+	std::vector<std::uint32_t> mCounts;
+	std::vector<std::uint32_t> mNextCounts;
+	std::vector<std::uint8_t> mRegionCounted;
+	DirtyChunks<std::uint32_t> mDirtyCounts;
+	DirtyChunks<std::uint8_t> mDirtyRegions;
+
+	// Cell state for kernels, 0xFFFFFFFF for open cells and 0 for blocked ones
+	std::vector<std::uint32_t> mOpen;
+
+	// Directions leading to open cells inside the board, one bit per direction
+	std::vector<std::uint32_t> mValidMoves;
+
+	// Results of the local step, consumed by the gather step
+	std::vector<std::uint32_t> mStay;
+	std::vector<std::uint32_t> mShares;
+	std::vector<std::uint32_t> mExtraMoves;
+
+	void updateCells(const TurnConstants& constants, std::vector<float>& food,
+		DirtyChunks<float>& foodChunks, std::uint32_t first, std::uint32_t last);
+	void updateCell(const TurnConstants& constants, std::vector<float>& food,
+		DirtyChunks<float>& foodChunks, std::uint32_t i);
+	void gatherCells(std::vector<std::uint32_t>& next, std::uint32_t y, std::uint32_t first,
+		std::uint32_t last) const;
+	static std::uint32_t Binomial(std::uint32_t trials, float chance, std::uint32_t cellKey,
+		std::uint32_t stage);
+};
+
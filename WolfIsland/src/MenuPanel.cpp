@@ -51,8 +51,7 @@ MenuPanel::~MenuPanel()
 
 void MenuPanel::draw(Renderer& renderer) const
 {
-	renderer.prepareDrawSprite();
-	renderer.drawSprite(*mGuiSpriteSheet->getSprite(panelIndex).lock(),
+	renderer.submitSprite(RenderLayer::GUI, *mGuiSpriteSheet->getSprite(panelIndex).lock(),
 		glm::translate(glm::vec3{ mPos.x, mPos.y, 0.0f }));
 
 	mHeightSlider->draw(renderer);
@@ -0,0 +1,109 @@
+#include "Neighbourhood.hpp"
+using namespace std;
+
+// Set bits of every mask in ascending order
+struct Candidates
+{
+	uint8_t count;
+	array<uint8_t, Neighbourhood::cellsCount> cells;
+};
+
+// Cells with x or y offset towards an edge, the position lacks them when it touches the edge
+static const uint32_t leftCells{ 0x007 };
+static const uint32_t rightCells{ 0x1c0 };
+static const uint32_t lowerCells{ 0x049 };
+static const uint32_t upperCells{ 0x124 };
+
+static array<Candidates, 1 << Neighbourhood::cellsCount> BuildCandidates()
+{
+	array<Candidates, 1 << Neighbourhood::cellsCount> candidates;
+
+	for (uint32_t mask = 0; mask < candidates.size(); mask++)
+	{
+		candidates[mask].count = 0;
+		candidates[mask].cells.fill(0);
+
+		for (uint32_t cell = 0; cell < Neighbourhood::cellsCount; cell++)
+		{
+			if (mask & (1 << cell))
+				candidates[mask].cells[candidates[mask].count++] = cell;
+		}
+	}
+
+	return candidates;
+}
+
+// Indexed by touched edges: left, right, lower and upper from the lowest bit
+static array<uint32_t, 16> BuildInsideMasks()
+{
+	array<uint32_t, 16> masks;
+
+	for (uint32_t edges = 0; edges < masks.size(); edges++)
+	{
+		masks[edges] = Neighbourhood::allCells;
+
+		if (edges & 1)
+			masks[edges] &= ~leftCells;
+
+		if (edges & 2)
+			masks[edges] &= ~rightCells;
+
+		if (edges & 4)
+			masks[edges] &= ~lowerCells;
+
+		if (edges & 8)
+			masks[edges] &= ~upperCells;
+	}
+
+	return masks;
+}
+
+static const array<Candidates, 1 << Neighbourhood::cellsCount> candidates{ BuildCandidates() };
+static const array<uint32_t, 16> insideMasks{ BuildInsideMasks() };
+
+
+Neighbourhood::Neighbourhood()
+	: inside{ 0 }, boulders{ 0 }, bushes{ 0 }, hares{ 0 }, females{ 0 }
+{
+}
+
+uint32_t Neighbourhood::GetCell(const glm::tvec2<int32_t>& offset)
+{
+	return (offset.x + 1) * 3 + offset.y + 1;
+}
+
+glm::tvec2<int32_t> Neighbourhood::GetOffset(uint32_t cell)
+{
+	return { static_cast<int32_t>(cell / 3) - 1, static_cast<int32_t>(cell % 3) - 1 };
+}
+
+uint32_t Neighbourhood::GetInsideMask(const glm::tvec2<int32_t>& pos, uint32_t width,
+	uint32_t height)
+{
+	uint32_t edges = (pos.x <= 0 ? 1 : 0) | (pos.x + 1 >= static_cast<int32_t>(width) ? 2 : 0) |
+		(pos.y <= 0 ? 4 : 0) | (pos.y + 1 >= static_cast<int32_t>(height) ? 8 : 0);
+
+	return insideMasks[edges];
+}
+
+uint32_t Neighbourhood::GetCount(uint32_t mask)
+{
+	return candidates[mask & allCells].count;
+}
+
+uint32_t Neighbourhood::Select(uint32_t mask, uint32_t n)
+{
+	return candidates[mask & allCells].cells[n];
+}
+
+int32_t Neighbourhood::GetLast(uint32_t mask)
+{
+	auto& c = candidates[mask & allCells];
+	return c.count == 0 ? -1 : c.cells[c.count - 1];
+}
+
+uint32_t Neighbourhood::GetCellsAfter(int32_t cell)
+{
+	return cell < 0 ? allCells : allCells & ~((2u << cell) - 1);
+}
+
@@ -0,0 +1,50 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "EntityStore.hpp"
+#include <glm/vec2.hpp>
+
+
+// Objects saved in the 3x3 cells around a position as bit masks. Cell bits follow the order
+// animals scan their surroundings, x offset first and y offset second, the centre is bit 4.
+// Objects standing in the centre are left out. Moves are drawn from precomputed tables of
+// set bits, so every query is a single lookup.
+struct Neighbourhood
+{
+	Neighbourhood();
+
+	// Cells inside the board
+	std::uint32_t inside;
+	std::uint32_t boulders;
+	std::uint32_t bushes;
+
+	// Cells with hare objects or counted hares
+	std::uint32_t hares;
+
+	// Cells with wolf females which can have pups
+	std::uint32_t females;
+
+	// Last hare object saved in every cell, null for cells with only counted hares
+	std::array<EntityHandle, 9> hareHandles;
+
+	static const std::uint32_t cellsCount{ 9 };
+	static const std::uint32_t allCells{ (1u << cellsCount) - 1 };
+
+	static std::uint32_t GetCell(const glm::tvec2<std::int32_t>& offset);
+	static glm::tvec2<std::int32_t> GetOffset(std::uint32_t cell);
+
+	// Cells of a position which are inside the board, looked up by the edges it touches
+	static std::uint32_t GetInsideMask(const glm::tvec2<std::int32_t>& pos,
+		std::uint32_t width, std::uint32_t height);
+
+	static std::uint32_t GetCount(std::uint32_t mask);
+
+	// Cell of the n-th set bit, n has to be less than the count
+	static std::uint32_t Select(std::uint32_t mask, std::uint32_t n);
+
+	// Highest cell of the mask, -1 when it's empty
+	static std::int32_t GetLast(std::uint32_t mask);
+
+	// Cells scanned after the cell, all of them for -1
+	static std::uint32_t GetCellsAfter(std::int32_t cell);
+};
+
@@ -0,0 +1,258 @@
+#include "ParameterSweep.hpp"
+using namespace std;
+
+static const chrono::seconds progressInterval{ 1 };
+
+
+ParameterSweep::ParameterSweep()
+	: mReplicates{ 0 }, mThreads{ 0 }, mCompletedSimulations{ 0 }
+{
+}
+
+ParameterSweep::ParameterSweep(const EnsembleRun& base, const vector<SweepDimension>& dimensions,
+	SweepSampling sampling, uint32_t samples, uint32_t replicates, uint32_t threads)
+	: mReplicates{ 0 }, mThreads{ 0 }, mCompletedSimulations{ 0 }
+{
+	create(base, dimensions, sampling, samples, replicates, threads);
+}
+
+void ParameterSweep::create(const EnsembleRun& base, const vector<SweepDimension>& dimensions,
+	SweepSampling sampling, uint32_t samples, uint32_t replicates, uint32_t threads)
+{
+	auto& names = SimulationParameters::GetNames();
+
+	for (auto& d : dimensions)
+	{
+		if (find(begin(names), end(names), d.name) == end(names))
+			throw SweepParameterException();
+	}
+
+	mBase = base;
+	mDimensions = dimensions;
+	mReplicates = max(replicates, 1u);
+	mThreads = threads != 0 ? threads : max(thread::hardware_concurrency(), 1u);
+	mJobs.create(mThreads);
+
+	mPoints.clear();
+	mSimulations.clear();
+	mResults.clear();
+	mRunSimulations.clear();
+	mSimulationIndices.clear();
+	mCompletedSimulations = 0;
+
+	if (sampling == SweepSampling::GRID)
+		generateGrid();
+	else
+		generateLatinHypercube(samples);
+}
+
+ParameterSweep::~ParameterSweep()
+{
+}
+
+void ParameterSweep::run(ostream& progress)
+{
+	mResults.assign(mSimulations.size(), EnsembleResult{});
+	mCompletedSimulations = 0;
+
+	vector<JobHandle> jobs;
+
+	for (uint32_t i = 0; i < mSimulations.size(); i++)
+		jobs.push_back(mJobs.add([this, i]() { simulate(i); }));
+
+	auto start = chrono::steady_clock::now();
+
+	{
+		unique_lock<mutex> lock{ mMutex };
+
+		while (true)
+		{
+			chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+			ostringstream rate;
+			rate << fixed << setprecision(1) << mCompletedSimulations / max(elapsed.count(), 1e-3);
+
+			progress << "Completed " << mCompletedSimulations << "/" << mSimulations.size()
+				<< " simulations for " << mRunSimulations.size() << " runs (" << rate.str()
+				<< " simulations/s)" << endl;
+
+			if (mCompletedSimulations == mSimulations.size())
+				break;
+
+			mProgressCondition.wait_for(lock, progressInterval,
+				[this]() { return mCompletedSimulations == mSimulations.size(); });
+		}
+	}
+
+	mJobs.wait(jobs);
+}
+
+void ParameterSweep::writeResults(ostream& output)
+{
+	lock_guard<mutex> lock{ mMutex };
+
+	output << "point,replicate,seed";
+
+	for (auto& d : mDimensions)
+		output << "," << d.name;
+
+	output << ",simulation,turns,stop_reason,wolves,hares,mean_wolves,mean_hares,"
+		"wolf_extinction_turn,hare_extinction_turn,suppressed_births" << endl;
+
+	for (uint32_t run = 0; run < mRunSimulations.size(); run++)
+	{
+		uint32_t point = run / mReplicates;
+		uint32_t simulation = mRunSimulations[run];
+		auto& result = mResults[simulation];
+
+		output << point << "," << run % mReplicates << "," << mSimulations[simulation].seed;
+
+		for (auto& d : mDimensions)
+			output << "," << mPoints[point].get(d.name);
+
+		double meanWolves{ 0.0 };
+		double meanHares{ 0.0 };
+
+		for (uint32_t i = 0; i < result.wolfCounts.size(); i++)
+		{
+			meanWolves += result.wolfCounts[i];
+			meanHares += result.hareCounts[i];
+		}
+
+		if (!result.wolfCounts.empty())
+		{
+			meanWolves /= result.wolfCounts.size();
+			meanHares /= result.hareCounts.size();
+		}
+
+		output << "," << simulation << ","
+			<< (result.wolfCounts.empty() ? 0 : result.wolfCounts.size() - 1) << ","
+			<< PopulationMonitor::GetReasonName(result.stopReason) << ","
+			<< (result.wolfCounts.empty() ? 0 : result.wolfCounts.back()) << ","
+			<< (result.hareCounts.empty() ? 0 : result.hareCounts.back()) << ","
+			<< meanWolves << "," << meanHares << ","
+			<< result.wolfExtinctionTurn << "," << result.hareExtinctionTurn << ","
+			<< result.governor.suppressedByEntities + result.governor.suppressedByRegion << endl;
+	}
+}
+
+uint32_t ParameterSweep::getPointsCount() const
+{
+	return mPoints.size();
+}
+
+uint32_t ParameterSweep::getSimulationsCount() const
+{
+	return mSimulations.size();
+}
+
+void ParameterSweep::generateGrid()
+{
+	vector<uint32_t> steps(mDimensions.size(), 0);
+	vector<double> values(mDimensions.size());
+
+	while (true)
+	{
+		for (uint32_t d = 0; d < mDimensions.size(); d++)
+		{
+			auto& dim = mDimensions[d];
+			values[d] = dim.steps > 1 ?
+				dim.min + (dim.max - dim.min) * steps[d] / (dim.steps - 1) : dim.min;
+		}
+
+		addPoint(values);
+
+		// Advances the grid counter, first dimension changes fastest
+		uint32_t d = 0;
+
+		while (d < mDimensions.size() && ++steps[d] >= max(mDimensions[d].steps, 1u))
+			steps[d++] = 0;
+
+		if (d == mDimensions.size())
+			break;
+	}
+}
+
+void ParameterSweep::generateLatinHypercube(uint32_t samples)
+{
+	if (samples == 0)
+		return;
+
+	// Every dimension is split into equal strata and each stratum is used exactly once
+	mt19937 engine{ mBase.seed };
+	uniform_real_distribution<double> offsetDist{ 0.0, 1.0 };
+	vector<vector<uint32_t>> strata(mDimensions.size());
+
+	for (auto& s : strata)
+	{
+		s.resize(samples);
+		iota(begin(s), end(s), 0);
+		shuffle(begin(s), end(s), engine);
+	}
+
+	vector<double> values(mDimensions.size());
+
+	for (uint32_t i = 0; i < samples; i++)
+	{
+		for (uint32_t d = 0; d < mDimensions.size(); d++)
+		{
+			auto& dim = mDimensions[d];
+			values[d] = dim.min + (dim.max - dim.min) *
+				(strata[d][i] + offsetDist(engine)) / samples;
+		}
+
+		addPoint(values);
+	}
+}
+
+void ParameterSweep::addPoint(const vector<double>& values)
+{
+	SimulationParameters parameters{ mBase.parameters };
+
+	for (uint32_t d = 0; d < mDimensions.size(); d++)
+		parameters.set(mDimensions[d].name, values[d]);
+
+	mPoints.push_back(parameters);
+
+	for (uint32_t r = 0; r < mReplicates; r++)
+	{
+		EnsembleRun run{ mBase };
+		run.seed = mBase.seed + r;
+		run.parameters = parameters;
+
+		// Integer parameters collapse neighbouring samples and animation only parameters
+		// don't change the simulation, so such runs are computed once
+		uint32_t simulation = mSimulations.size();
+		size_t key = parameters.hashSimulation() ^ std::hash<uint32_t>{}(run.seed) * 0x9e3779b9;
+		auto range = mSimulationIndices.equal_range(key);
+
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (mSimulations[it->second].seed == run.seed &&
+				mSimulations[it->second].parameters.isSimulationEqual(parameters))
+			{
+				simulation = it->second;
+				break;
+			}
+		}
+
+		if (simulation == mSimulations.size())
+		{
+			mSimulations.push_back(run);
+			mSimulationIndices.emplace(key, simulation);
+		}
+
+		mRunSimulations.push_back(simulation);
+	}
+}
+
+void ParameterSweep::simulate(uint32_t simulation)
+{
+	auto result = EnsembleRunner::Simulate(mSimulations[simulation]);
+	result.index = simulation;
+
+	lock_guard<mutex> lock{ mMutex };
+	mResults[simulation] = move(result);
+	mCompletedSimulations++;
+	mProgressCondition.notify_all();
+}
+
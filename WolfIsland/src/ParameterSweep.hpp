@@ -0,0 +1,81 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "EnsembleRunner.hpp"
+
+
+class SweepParameterException : public std::exception
+{
+	virtual const char* what() const noexcept
+	{
+		return "Unknown parameter in the sweep.";
+	}
+};
+
+// Range of one swept parameter, grids take steps evenly spaced values including both ends
+struct SweepDimension
+{
+	std::string name;
+	double min;
+	double max;
+	std::uint32_t steps;
+};
+
+enum class SweepSampling
+{
+	GRID,
+	LATIN_HYPERCUBE
+};
+
+// Runs headless islands for every sampled point of the parameter space on all cores and
+// writes a single results table. Every point is repeated with the same seeds, identical
+// simulations are run only once and their results are shared.
+class ParameterSweep
+{
+public:
+	ParameterSweep();
+
+	ParameterSweep(const EnsembleRun& base, const std::vector<SweepDimension>& dimensions,
+		SweepSampling sampling, std::uint32_t samples, std::uint32_t replicates,
+		std::uint32_t threads = 0);
+	void create(const EnsembleRun& base, const std::vector<SweepDimension>& dimensions,
+		SweepSampling sampling, std::uint32_t samples, std::uint32_t replicates,
+		std::uint32_t threads = 0);
+
+	~ParameterSweep();
+
+	// Runs all simulations and blocks until they are done
+	void run(std::ostream& progress);
+
+	// One row for every point and replicate
+	void writeResults(std::ostream& output);
+
+	std::uint32_t getPointsCount() const;
+	std::uint32_t getSimulationsCount() const;
+
+private:
+	EnsembleRun mBase;
+	std::vector<SweepDimension> mDimensions;
+	std::uint32_t mReplicates;
+	std::uint32_t mThreads;
+
+	std::vector<SimulationParameters> mPoints;
+	std::vector<EnsembleRun> mSimulations;
+	std::vector<EnsembleResult> mResults;
+
+	// Index of the simulation used by every point and replicate
+	std::vector<std::uint32_t> mRunSimulations;
+
+	// Simulations by the hash of their seed and parameters
+	std::unordered_multimap<std::size_t, std::uint32_t> mSimulationIndices;
+
+	JobSystem mJobs;
+	std::mutex mMutex;
+	std::condition_variable mProgressCondition;
+	std::uint32_t mCompletedSimulations;
+
+	void generateGrid();
+	void generateLatinHypercube(std::uint32_t samples);
+	void addPoint(const std::vector<double>& values);
+	void simulate(std::uint32_t simulation);
+};
+
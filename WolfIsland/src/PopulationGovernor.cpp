@@ -0,0 +1,147 @@
+#include "PopulationGovernor.hpp"
+using namespace std;
+
+
+GovernorOptions::GovernorOptions()
+	: maxEntities{ 0 }, memoryBudget{ 0 }, regionCapacity{ 0.0f }
+{
+}
+
+bool GovernorOptions::isEnabled() const
+{
+	return maxEntities > 0 || memoryBudget > 0 || regionCapacity > 0.0f;
+}
+
+
+GovernorTelemetry::GovernorTelemetry()
+	: births{ 0 }, suppressedByEntities{ 0 }, suppressedByRegion{ 0 }, interventionTurns{ 0 },
+	turns{ 0 }
+{
+}
+
+void GovernorTelemetry::clear()
+{
+	births = 0;
+	suppressedByEntities = 0;
+	suppressedByRegion = 0;
+	interventionTurns = 0;
+	turns = 0;
+}
+
+void GovernorTelemetry::add(const GovernorTelemetry& other)
+{
+	births += other.births;
+	suppressedByEntities += other.suppressedByEntities;
+	suppressedByRegion += other.suppressedByRegion;
+	interventionTurns += other.interventionTurns;
+	turns += other.turns;
+}
+
+
+PopulationGovernor::PopulationGovernor()
+	: mEntityLimit{ numeric_limits<uint32_t>::max() }, mPendingBirths{ 0 }, mIntervened{ false }
+{
+}
+
+PopulationGovernor::PopulationGovernor(const GovernorOptions& options, uint32_t entityBytes,
+	uint32_t bucketsCount)
+	: mEntityLimit{ numeric_limits<uint32_t>::max() }, mPendingBirths{ 0 }, mIntervened{ false }
+{
+	create(options, entityBytes, bucketsCount);
+}
+
+void PopulationGovernor::create(const GovernorOptions& options, uint32_t entityBytes,
+	uint32_t bucketsCount)
+{
+	mOptions = options;
+	mEntityLimit = numeric_limits<uint32_t>::max();
+
+	if (options.maxEntities > 0)
+		mEntityLimit = options.maxEntities;
+
+	if (options.memoryBudget > 0)
+	{
+		uint64_t budgetEntities = (static_cast<uint64_t>(options.memoryBudget) << 20) /
+			max(entityBytes, 1u);
+		mEntityLimit = static_cast<uint32_t>(min<uint64_t>(mEntityLimit, budgetEntities));
+	}
+
+	mPendingBirths = 0;
+	mPendingBucketBirths.assign(options.regionCapacity > 0.0f ? bucketsCount : 0, 0);
+	mPendingBuckets.clear();
+	mIntervened = false;
+	mTelemetry.clear();
+}
+
+PopulationGovernor::~PopulationGovernor()
+{
+}
+
+bool PopulationGovernor::isEnabled() const
+{
+	return mOptions.isEnabled();
+}
+
+const GovernorOptions& PopulationGovernor::getOptions() const
+{
+	return mOptions;
+}
+
+uint32_t PopulationGovernor::getEntityLimit() const
+{
+	return mEntityLimit;
+}
+
+void PopulationGovernor::beginTurn()
+{
+	mPendingBirths = 0;
+
+	for (auto bucket : mPendingBuckets)
+		mPendingBucketBirths[bucket] = 0;
+
+	mPendingBuckets.clear();
+	mIntervened = false;
+	mTelemetry.turns++;
+}
+
+bool PopulationGovernor::allowBirth(uint32_t entities, uint32_t bucket, uint32_t bucketEntities,
+	uint32_t bucketCells)
+{
+	if (static_cast<uint64_t>(entities) + mPendingBirths >= mEntityLimit)
+	{
+		mTelemetry.suppressedByEntities++;
+		suppress();
+		return false;
+	}
+
+	if (mOptions.regionCapacity > 0.0f)
+	{
+		if (bucketEntities + mPendingBucketBirths[bucket] >= mOptions.regionCapacity * bucketCells)
+		{
+			mTelemetry.suppressedByRegion++;
+			suppress();
+			return false;
+		}
+
+		if (mPendingBucketBirths[bucket]++ == 0)
+			mPendingBuckets.push_back(bucket);
+	}
+
+	mPendingBirths++;
+	mTelemetry.births++;
+	return true;
+}
+
+const GovernorTelemetry& PopulationGovernor::getTelemetry() const
+{
+	return mTelemetry;
+}
+
+void PopulationGovernor::suppress()
+{
+	if (!mIntervened)
+		mTelemetry.interventionTurns++;
+
+	mIntervened = true;
+}
+
@@ -0,0 +1,78 @@
+#pragma once
+#include "Prerequisites.hpp"
+
+
+// Limits of agent births, 0 disables a limit
+struct GovernorOptions
+{
+	GovernorOptions();
+
+	std::uint32_t maxEntities;
+
+	// Megabytes of board objects, turned into an entity limit by the estimated object size
+	std::uint32_t memoryBudget;
+
+	// Entities per cell of a spatial index bucket
+	float regionCapacity;
+
+	bool isEnabled() const;
+};
+
+// How often the governor suppressed births
+struct GovernorTelemetry
+{
+	GovernorTelemetry();
+
+	std::uint64_t births;
+	std::uint64_t suppressedByEntities;
+	std::uint64_t suppressedByRegion;
+
+	// Turns with at least one suppressed birth
+	std::uint32_t interventionTurns;
+	std::uint32_t turns;
+
+	void clear();
+	void add(const GovernorTelemetry& other);
+};
+
+// Decides births of agents, so growing populations can't exhaust memory. Births queued
+// for the next turn count against the limits like existing entities.
+class PopulationGovernor
+{
+public:
+	PopulationGovernor();
+
+	PopulationGovernor(const GovernorOptions& options, std::uint32_t entityBytes,
+		std::uint32_t bucketsCount);
+	void create(const GovernorOptions& options, std::uint32_t entityBytes,
+		std::uint32_t bucketsCount);
+
+	~PopulationGovernor();
+
+	bool isEnabled() const;
+	const GovernorOptions& getOptions() const;
+
+	// Entity limit from both the count and the memory budget
+	std::uint32_t getEntityLimit() const;
+
+	// Starts the turn, queued births were spawned
+	void beginTurn();
+
+	// Births of a turn in a bucket of the spatial index, O(1) for every call
+	bool allowBirth(std::uint32_t entities, std::uint32_t bucket, std::uint32_t bucketEntities,
+		std::uint32_t bucketCells);
+
+	const GovernorTelemetry& getTelemetry() const;
+
+private:
+	GovernorOptions mOptions;
+	std::uint32_t mEntityLimit;
+	std::uint32_t mPendingBirths;
+	std::vector<std::uint32_t> mPendingBucketBirths;
+	std::vector<std::uint32_t> mPendingBuckets;
+	bool mIntervened;
+	GovernorTelemetry mTelemetry;
+
+	void suppress();
+};
+
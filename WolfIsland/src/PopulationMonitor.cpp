@@ -0,0 +1,231 @@
+#include "PopulationMonitor.hpp"
+using namespace std;
+
+static const uint32_t minPeriod{ 2 };
+
+
+TerminationPolicy::TerminationPolicy()
+	: wolfExtinction{ false }, hareExtinction{ false }, boomCap{ 0 }, window{ 50 },
+	steadyState{ false }, periodicOrbit{ false }, steadyTolerance{ 0.05 }, orbitTolerance{ 0.3 }
+{
+}
+
+PopulationMonitor::PopulationMonitor()
+	: mHareCapacity{ numeric_limits<uint32_t>::max() }, mStopReason{ StopReason::NONE },
+	mPeriod{ 0 }, mPreviousHares{ 0 }, mSums{ 0.0, 0.0 }, mSquareSums{ 0.0, 0.0 }
+{
+}
+
+PopulationMonitor::PopulationMonitor(const TerminationPolicy& policy, uint32_t hareCapacity)
+	: mHareCapacity{ numeric_limits<uint32_t>::max() }, mStopReason{ StopReason::NONE },
+	mPeriod{ 0 }, mPreviousHares{ 0 }, mSums{ 0.0, 0.0 }, mSquareSums{ 0.0, 0.0 }
+{
+	create(policy, hareCapacity);
+}
+
+void PopulationMonitor::create(const TerminationPolicy& policy, uint32_t hareCapacity)
+{
+	mPolicy = policy;
+	mHareCapacity = hareCapacity;
+	mStopReason = StopReason::NONE;
+	mPeriod = 0;
+	mPreviousHares = 0;
+	mWolves.clear();
+	mHares.clear();
+	mSums[0] = mSums[1] = 0.0;
+	mSquareSums[0] = mSquareSums[1] = 0.0;
+}
+
+PopulationMonitor::~PopulationMonitor()
+{
+}
+
+StopReason PopulationMonitor::update(uint32_t wolves, uint32_t hares)
+{
+	if (mStopReason != StopReason::NONE)
+		return mStopReason;
+
+	// Hares without wolves only change until they fill the board
+	bool haresDiedLast = hares == 0 && mPreviousHares > 0;
+	mPreviousHares = hares;
+
+	if (wolves == 0 && hares == 0 && (mPolicy.wolfExtinction || mPolicy.hareExtinction))
+	{
+		return mStopReason = haresDiedLast ? StopReason::HARE_EXTINCTION :
+			StopReason::WOLF_EXTINCTION;
+	}
+
+	if (mPolicy.wolfExtinction && wolves == 0 && hares >= mHareCapacity)
+		return mStopReason = StopReason::WOLF_EXTINCTION;
+
+	if (mPolicy.boomCap != 0 && wolves + hares > mPolicy.boomCap)
+		return mStopReason = StopReason::BOOM;
+
+	uint32_t window = mPolicy.window;
+
+	if (window == 0 || (!mPolicy.steadyState && !mPolicy.periodicOrbit))
+		return StopReason::NONE;
+
+	// Keeps sums of the last window updated in constant time
+	array<deque<uint32_t>*, 2> histories{ &mWolves, &mHares };
+	array<uint32_t, 2> counts{ wolves, hares };
+
+	for (uint32_t s = 0; s < 2; s++)
+	{
+		auto& history = *histories[s];
+		history.push_back(counts[s]);
+		mSums[s] += counts[s];
+		mSquareSums[s] += static_cast<double>(counts[s]) * counts[s];
+
+		if (history.size() > window)
+		{
+			double leaving = history[history.size() - 1 - window];
+			mSums[s] -= leaving;
+			mSquareSums[s] -= leaving * leaving;
+		}
+
+		if (history.size() > 2 * window)
+			history.pop_front();
+	}
+
+	if (mWolves.size() < 2 * window)
+		return StopReason::NONE;
+
+	if (mPolicy.steadyState && isSteady())
+		return mStopReason = StopReason::STEADY_STATE;
+
+	if (mPolicy.periodicOrbit && isPeriodic())
+		return mStopReason = StopReason::PERIODIC_ORBIT;
+
+	return StopReason::NONE;
+}
+
+StopReason PopulationMonitor::getStopReason() const
+{
+	return mStopReason;
+}
+
+uint32_t PopulationMonitor::getPeriod() const
+{
+	return mPeriod;
+}
+
+const char* PopulationMonitor::GetReasonName(StopReason reason)
+{
+	switch (reason)
+	{
+	case StopReason::WOLF_EXTINCTION:
+		return "wolf_extinction";
+	case StopReason::HARE_EXTINCTION:
+		return "hare_extinction";
+	case StopReason::BOOM:
+		return "boom";
+	case StopReason::STEADY_STATE:
+		return "steady_state";
+	case StopReason::PERIODIC_ORBIT:
+		return "periodic_orbit";
+	default:
+		return "none";
+	}
+}
+
+bool PopulationMonitor::IsCensoring(StopReason reason)
+{
+	return reason == StopReason::BOOM || reason == StopReason::STEADY_STATE ||
+		reason == StopReason::PERIODIC_ORBIT;
+}
+
+bool PopulationMonitor::isSteady() const
+{
+	uint32_t window = mPolicy.window;
+
+	for (uint32_t s = 0; s < 2; s++)
+	{
+		auto& history = s == 0 ? mWolves : mHares;
+		double mean = mSums[s] / window;
+		double deviation = sqrt(max(mSquareSums[s] / window - mean * mean, 0.0));
+
+		if (deviation > mPolicy.steadyTolerance * mean)
+			return false;
+
+		// Slow growth or decay shows up as a shift of the mean larger than the noise
+		double previous = accumulate(begin(history), begin(history) + window, 0.0) / window;
+
+		if (abs(mean - previous) > deviation)
+			return false;
+	}
+
+	return true;
+}
+
+bool PopulationMonitor::isPeriodic()
+{
+	uint32_t window = mPolicy.window;
+	array<double, 2> deviations;
+
+	for (uint32_t s = 0; s < 2; s++)
+	{
+		double mean = mSums[s] / window;
+		deviations[s] = sqrt(max(mSquareSums[s] / window - mean * mean, 0.0));
+	}
+
+	// Flat populations are left for the steady state detector
+	if (deviations[0] <= mPolicy.steadyTolerance * mSums[0] / window &&
+		deviations[1] <= mPolicy.steadyTolerance * mSums[1] / window)
+		return false;
+
+	// Both species oscillate with the same period, errors are relative to the amplitude
+	double bestError{ numeric_limits<double>::max() };
+	uint32_t bestPeriod{ 0 };
+
+	for (uint32_t period = minPeriod; period <= window / 2; period++)
+	{
+		double error{ 0.0 };
+
+		for (uint32_t s = 0; s < 2; s++)
+		{
+			if (deviations[s] > 0.0)
+			{
+				error = max(error, OrbitError(s == 0 ? mWolves : mHares, window, period) /
+					deviations[s]);
+			}
+		}
+
+		if (error < bestError)
+		{
+			bestError = error;
+			bestPeriod = period;
+		}
+	}
+
+	if (bestPeriod == 0 || bestError > mPolicy.orbitTolerance)
+		return false;
+
+	// Window shifted by whole periods has the same mean unless the orbit drifts
+	uint32_t shift = window / bestPeriod * bestPeriod;
+
+	for (uint32_t s = 0; s < 2; s++)
+	{
+		auto& history = s == 0 ? mWolves : mHares;
+		auto shifted = end(history) - shift;
+		double drift = abs(mSums[s] - accumulate(shifted - window, shifted, 0.0)) / window;
+
+		if (drift > mPolicy.orbitTolerance * deviations[s])
+			return false;
+	}
+
+	mPeriod = bestPeriod;
+	return true;
+}
+
+double PopulationMonitor::OrbitError(const deque<uint32_t>& history, uint32_t window,
+	uint32_t period)
+{
+	double difference{ 0.0 };
+
+	for (size_t t = history.size() - window; t < history.size(); t++)
+		difference += abs(static_cast<double>(history[t]) - history[t - period]);
+
+	return difference / window;
+}
+
@@ -0,0 +1,89 @@
+#pragma once
+#include "Prerequisites.hpp"
+
+
+enum class StopReason
+{
+	NONE,
+	WOLF_EXTINCTION,
+	HARE_EXTINCTION,
+	BOOM,
+	STEADY_STATE,
+	PERIODIC_ORBIT
+};
+
+// Decides which detectors can stop a headless run before its last turn
+struct TerminationPolicy
+{
+	TerminationPolicy();
+
+	// Extinctions stop a run only in states neither species leaves: both species extinct, or
+	// wolves extinct with hares at the capacity of the board. Surviving species are simulated
+	// until then.
+	bool wolfExtinction;
+	bool hareExtinction;
+
+	// Maximum of wolves and hares together, 0 disables the cap
+	std::uint32_t boomCap;
+
+	// Equilibrium detectors look at the last window turns and never stop before 2 windows
+	std::uint32_t window;
+	bool steadyState;
+	bool periodicOrbit;
+
+	// Largest coefficient of variation in the window still considered steady
+	double steadyTolerance;
+
+	// Largest mean difference of a period shifted window, relative to the standard deviation
+	double orbitTolerance;
+};
+
+// Online detectors working on per turn population counters
+class PopulationMonitor
+{
+public:
+	PopulationMonitor();
+
+	// Hares can't outgrow the capacity, the maximum means there's no such limit
+	PopulationMonitor(const TerminationPolicy& policy,
+		std::uint32_t hareCapacity = std::numeric_limits<std::uint32_t>::max());
+	void create(const TerminationPolicy& policy,
+		std::uint32_t hareCapacity = std::numeric_limits<std::uint32_t>::max());
+
+	~PopulationMonitor();
+
+	// Feeds counters of the next turn, returns the reason to stop or NONE
+	StopReason update(std::uint32_t wolves, std::uint32_t hares);
+
+	StopReason getStopReason() const;
+	std::uint32_t getPeriod() const;
+
+	static const char* GetReasonName(StopReason reason);
+
+	// Runs stopped for the reason could still change, their later turns are unknown rather
+	// than equal to the last one
+	static bool IsCensoring(StopReason reason);
+
+private:
+	TerminationPolicy mPolicy;
+	std::uint32_t mHareCapacity;
+	StopReason mStopReason;
+	std::uint32_t mPeriod;
+
+	// Hares of the previous turn, tells which species died out last
+	std::uint32_t mPreviousHares;
+
+	// History of the last 2 windows, index 0 is the oldest turn
+	std::deque<std::uint32_t> mWolves;
+	std::deque<std::uint32_t> mHares;
+
+	// Running sums over the last window
+	double mSums[2];
+	double mSquareSums[2];
+
+	bool isSteady() const;
+	bool isPeriodic();
+	static double OrbitError(const std::deque<std::uint32_t>& history, std::uint32_t window,
+		std::uint32_t period);
+};
+
@@ -0,0 +1,44 @@
+#include "Prerequisites.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PREREQUISITES_CPUID
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+
+bool IsAvx2Supported()
+{
+#ifdef PREREQUISITES_CPUID
+	static const bool supported = []()
+	{
+		// Processor has to support AVX2 and the system has to save AVX registers
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+
+		if (info[0] < 7)
+			return false;
+
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+
+		if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}();
+
+	return supported;
+#else
+	return false;
+#endif
+}
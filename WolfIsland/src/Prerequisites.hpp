@@ -6,6 +6,9 @@
 #include <cstdint>
 #include <cstddef>
 #include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <limits>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -21,4 +24,13 @@
 #include <tuple>
 #include <typeinfo>
 #include <stack>
-#include <queue>
\ No newline at end of file
+#include <queue>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+// Processor and system support AVX2, checked once. Kernels with AVX2 paths fall back to
+// scalar code without it.
+bool IsAvx2Supported();
@@ -0,0 +1,54 @@
+#include "RenderQueue.hpp"
+#include "Renderer.hpp"
+using namespace std;
+
+RenderQueue::RenderQueue()
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+}
+
+uint64_t RenderQueue::MakeKey(uint8_t layer, uint8_t program, uint16_t texture, float depth)
+{
+	// Flipping bits of floats orders their bits as the floats, negative ones included
+	uint32_t depthBits;
+	copy_n(reinterpret_cast<const uint8_t*>(&depth), sizeof(depth),
+		reinterpret_cast<uint8_t*>(&depthBits));
+	depthBits ^= (depthBits & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+
+	return static_cast<uint64_t>(layer) << 56 | static_cast<uint64_t>(program) << 48 |
+		static_cast<uint64_t>(texture) << 32 | depthBits;
+}
+
+void RenderQueue::submit(uint64_t key, const glm::mat4& orthoMatrix,
+	function<void(Renderer&)> draw)
+{
+	mCommands.push_back(Command{ key, orthoMatrix, move(draw) });
+}
+
+void RenderQueue::flush(Renderer& renderer)
+{
+	mOrder.resize(mCommands.size());
+	iota(begin(mOrder), end(mOrder), 0);
+
+	stable_sort(begin(mOrder), end(mOrder), [this](uint32_t a, uint32_t b)
+		{
+			return mCommands[a].key < mCommands[b].key;
+		});
+
+	for (auto i : mOrder)
+	{
+		renderer.bindOrthoMatrix(mCommands[i].orthoMatrix);
+		mCommands[i].draw(renderer);
+	}
+
+	mCommands.clear();
+}
+
+uint32_t RenderQueue::getSize() const
+{
+	return mCommands.size();
+}
+
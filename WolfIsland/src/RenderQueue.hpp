@@ -0,0 +1,41 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include <functional>
+#include <glm/mat4x4.hpp>
+
+// Draws of a frame, run sorted by their keys when the queue is flushed. From the highest bits
+// keys hold the layer, program, texture and depth, so draws of a layer are grouped by
+// the state they need and sorted by depth last. Draws with equal keys run in the order they
+// were submitted.
+class RenderQueue
+{
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	static std::uint64_t MakeKey(std::uint8_t layer, std::uint8_t program, std::uint16_t texture,
+		float depth);
+
+	// The draw runs with the ortho matrix bound when it was submitted
+	void submit(std::uint64_t key, const glm::mat4& orthoMatrix,
+		std::function<void(class Renderer&)> draw);
+
+	// Runs and removes submitted draws
+	void flush(class Renderer& renderer);
+
+	std::uint32_t getSize() const;
+
+private:
+	struct Command
+	{
+		std::uint64_t key;
+		glm::mat4 orthoMatrix;
+		std::function<void(class Renderer&)> draw;
+	};
+
+	std::vector<Command> mCommands;
+
+	// Commands are sorted by index, so they aren't moved around
+	std::vector<std::uint32_t> mOrder;
+};
+
@@ -5,10 +5,25 @@
 #include "VertexBuffer.hpp"
 #include "Sprite.hpp"
 #include "Text.hpp"
+#include "Framebuffer.hpp"
+#include <glm/vec4.hpp>
 using namespace std;
 
+RendererCounters::RendererCounters()
+	: drawCalls{ 0 }, programBinds{ 0 }, vertexArrayBinds{ 0 }, textureBinds{ 0 },
+	samplerBinds{ 0 }, capabilityChanges{ 0 }, avoidedStateChanges{ 0 }, bufferOrphans{ 0 }
+{
+}
+
+void RendererCounters::clear()
+{
+	*this = RendererCounters{};
+}
+
 Renderer::Renderer() 
-	: mInitialized{ false }
+	: mInitialized{ false }, mValidation{ false }, mBoundProgram{ 0 }, mBoundVertexArray{ 0 },
+	mActiveTextureSlot{ 0 }, mBoundTextures{}, mBoundSamplers{}, mBlending{ false },
+	mDepthTest{ false }, mViewport{ 0, 0 }, mMaxVertexUniformVectors{ 0 }
 {
 }
 
@@ -72,8 +87,39 @@ void Renderer::init()
 		istreambuf_iterator<char>());
 
 	mSpriteInstancedShader.create(vertexShaderData, fragmentShaderData);
-	mOrthographicMatrixLocationSprite = mSpriteInstancedShader.getLocation("orthographicMatrix");
-	mSamplerLocationSprite = mSpriteInstancedShader.getLocation("sampler");
+	mOrthographicMatrixLocationSpriteInstanced =
+		mSpriteInstancedShader.getLocation("orthographicMatrix");
+	mSamplerLocationSpriteInstanced = mSpriteInstancedShader.getLocation("sampler");
+
+	// Load ground shader, it shares fragments with instanced sprites
+	vertexShaderFile.close();
+	vertexShaderFile.open("GroundVertexShader.glsl");
+	vertexShaderData.assign(istreambuf_iterator<char>(vertexShaderFile),
+		istreambuf_iterator<char>());
+
+	mGroundShader.create(vertexShaderData, fragmentShaderData);
+	mOrthographicMatrixLocationGround = mGroundShader.getLocation("orthographicMatrix");
+	mSamplerLocationGround = mGroundShader.getLocation("sampler");
+	mFirstCellLocationGround = mGroundShader.getLocation("firstCell");
+	mColumnsLocationGround = mGroundShader.getLocation("columns");
+	mBoardSizeLocationGround = mGroundShader.getLocation("boardSize");
+	mCellSizeLocationGround = mGroundShader.getLocation("cellSize");
+	mTileUvsLocationGround = mGroundShader.getLocation("tileUvs");
+	mTileSizesLocationGround = mGroundShader.getLocation("tileSizes");
+
+	// Load animated sprite shader, it shares fragments with instanced sprites as well
+	vertexShaderFile.close();
+	vertexShaderFile.open("TexturedAnimatedVertexShader.glsl");
+	vertexShaderData.assign(istreambuf_iterator<char>(vertexShaderFile),
+		istreambuf_iterator<char>());
+
+	// Sizes of its tables are given by the animated layer, it's compiled when they're known
+	mSpriteAnimatedVertexSource = vertexShaderData;
+	mSpriteAnimatedFragmentSource = fragmentShaderData;
+
+	GLint uniformComponents{ 0 };
+	gl::GetIntegerv(gl::MAX_VERTEX_UNIFORM_COMPONENTS, &uniformComponents);
+	mMaxVertexUniformVectors = static_cast<uint32_t>(uniformComponents) / 4;
 
 	// Load water shader
 	vertexShaderFile.close();
@@ -89,11 +135,44 @@ void Renderer::init()
 	mOrthographicMatrixLocationWater = mWaterShader.getLocation("orthographicMatrix");
 	mDisplacementLocationWater = mWaterShader.getLocation("displacement");
 	mSamplerLocationWater = mWaterShader.getLocation("sampler");
+
+	// Samplers of every program read slot 0, they are set once
+	for (auto sampler : { make_pair(&mTextShader, mSamplerLocationText),
+		make_pair(&mSpriteShader, mSamplerLocationSprite),
+		make_pair(&mSpriteInstancedShader, mSamplerLocationSpriteInstanced),
+		make_pair(&mGroundShader, mSamplerLocationGround),
+		make_pair(&mWaterShader, mSamplerLocationWater) })
+	{
+		bindShader(*sampler.first);
+		gl::Uniform1i(sampler.second, 0);
+	}
+
+	// Alpha is kept right for sprites blended into framebuffer textures, which are blended again
+	gl::BlendFuncSeparate(gl::SRC_ALPHA, gl::ONE_MINUS_SRC_ALPHA, gl::ONE, gl::ONE_MINUS_SRC_ALPHA);
 }
 
 void Renderer::bindShader(Shader& shader)
 {
+	bool bound = mBoundProgram == shader.getID();
+
+	if (mValidation)
+	{
+		GLint current;
+		gl::GetIntegerv(gl::CURRENT_PROGRAM, &current);
+
+		if (bound != (static_cast<GLuint>(current) == shader.getID()))
+			throw RendererValidationException();
+	}
+
+	if (bound)
+	{
+		mCounters.avoidedStateChanges++;
+		return;
+	}
+
 	gl::UseProgram(shader.getID());
+	mBoundProgram = shader.getID();
+	mCounters.programBinds++;
 }
 
 void Renderer::bindTexture(Texture& tex, int32_t slot)
@@ -113,13 +192,71 @@ void Renderer::bindTexture(Texture& tex, int32_t slot)
 		break;
 	}
 
-	gl::ActiveTexture(gl::TEXTURE0 + slot);
+	auto& bound = mBoundTextures[slot][target == gl::TEXTURE_2D_ARRAY ? 1 : 0];
+
+	if (bound == tex.getID())
+	{
+		mCounters.avoidedStateChanges++;
+		return;
+	}
+
+	if (mActiveTextureSlot != slot)
+	{
+		gl::ActiveTexture(gl::TEXTURE0 + slot);
+		mActiveTextureSlot = slot;
+	}
+
 	gl::BindTexture(target, tex.getID());
+	bound = tex.getID();
+	mCounters.textureBinds++;
+}
+
+void Renderer::bindSampler(GLuint sampler, int32_t slot)
+{
+	if (mBoundSamplers[slot] == sampler)
+	{
+		mCounters.avoidedStateChanges++;
+		return;
+	}
+
+	gl::BindSampler(slot, sampler);
+	mBoundSamplers[slot] = sampler;
+	mCounters.samplerBinds++;
 }
 
 void Renderer::bindVertexArray(VertexArray &arr)
 {
+	bool bound = mBoundVertexArray == arr.getID();
+
+	if (mValidation)
+	{
+		GLint current;
+		gl::GetIntegerv(gl::VERTEX_ARRAY_BINDING, &current);
+
+		if (bound != (static_cast<GLuint>(current) == arr.getID()))
+			throw RendererValidationException();
+	}
+
+	if (bound)
+	{
+		mCounters.avoidedStateChanges++;
+		return;
+	}
+
 	gl::BindVertexArray(arr.getID());
+	mBoundVertexArray = arr.getID();
+	mCounters.vertexArrayBinds++;
+}
+
+void Renderer::resetVertexArrayBinding()
+{
+	mBoundVertexArray = 0;
+}
+
+void Renderer::resetTextureBindings()
+{
+	for (auto& slot : mBoundTextures)
+		slot.fill(0);
 }
 
 void Renderer::bindBuffer(GpuBuffer &buf)
@@ -153,6 +290,12 @@ void Renderer::bindBuffer(GpuBuffer &buf, GpuBufferType &type)
 	gl::BindBuffer(target, buf.getID());
 }
 
+void Renderer::orphanBuffer(uint32_t size)
+{
+	gl::BufferData(gl::ARRAY_BUFFER, size, nullptr, gl::STREAM_DRAW);
+	mCounters.bufferOrphans++;
+}
+
 void Renderer::bindOrthoMatrix(const glm::mat4& orthoMatrix)
 {
 	mOrthoMatrix = orthoMatrix;
@@ -160,62 +303,163 @@ void Renderer::bindOrthoMatrix(const glm::mat4& orthoMatrix)
 
 void Renderer::setDepthTest(bool state)
 {
+	if (mDepthTest == state)
+	{
+		mCounters.avoidedStateChanges++;
+		return;
+	}
+
 	if (state)
 		gl::Enable(gl::DEPTH_TEST);
 	else
 		gl::Disable(gl::DEPTH_TEST);
+
+	mDepthTest = state;
+	mCounters.capabilityChanges++;
+}
+
+void Renderer::setBlending(bool state)
+{
+	if (mBlending == state)
+	{
+		mCounters.avoidedStateChanges++;
+		return;
+	}
+
+	if (state)
+		gl::Enable(gl::BLEND);
+	else
+		gl::Disable(gl::BLEND);
+
+	mBlending = state;
+	mCounters.capabilityChanges++;
 }
 
 void Renderer::setViewport(const glm::tvec2<int32_t>& dimensions)
 {
 	gl::Viewport(0, 0, dimensions.x, dimensions.y);
+	mViewport = dimensions;
 }
 
-void Renderer::prepareDrawSprite()
+void Renderer::bindFramebuffer(Framebuffer& framebuffer)
 {
-	if (mSetup == Setup::SPRITE)
-		return;
+	gl::BindFramebuffer(gl::FRAMEBUFFER, framebuffer.getID());
+	gl::Viewport(0, 0, framebuffer.getDimensions().x, framebuffer.getDimensions().y);
+}
 
-	bindShader(mSpriteShader);
-	
+void Renderer::bindDefaultFramebuffer()
+{
+	gl::BindFramebuffer(gl::FRAMEBUFFER, 0);
+	gl::Viewport(0, 0, mViewport.x, mViewport.y);
+}
 
-	mSetup = Setup::SPRITE;
+void Renderer::prepareDrawSprite()
+{
+	bindShader(mSpriteShader);
 }
 
 void Renderer::prepareDrawText()
 {
-	if (mSetup == Setup::TEXT)
-		return;
-
 	bindShader(mTextShader);
-	mSetup = Setup::TEXT;
 }
 
 void Renderer::prepareDrawSpriteInstanced()
 {
-	if (mSetup == Setup::SPRITE_INSTANCED)
-		return;
-
 	bindShader(mSpriteInstancedShader);
-	mSetup = Setup::SPRITE_INSTANCED;
+}
+
+void Renderer::prepareDrawGround()
+{
+	bindShader(mGroundShader);
+}
+
+void Renderer::prepareDrawSpriteAnimated()
+{
+	bindShader(mSpriteAnimatedShader);
+}
+
+void Renderer::createAnimatedProgram(uint32_t frames, uint32_t clipVectors)
+{
+	// Sizes are defined right after the version line
+	auto source = mSpriteAnimatedVertexSource;
+	source.insert(source.find('\n') + 1, "#define FRAMES " + to_string(max(frames, 1u)) +
+		"\n#define CLIP_VECTORS " + to_string(max(clipVectors, 1u)) + "\n");
+
+	// The former program is deleted, the new one is bound before its name could be reused
+	mSpriteAnimatedShader = Shader{ source, mSpriteAnimatedFragmentSource };
+	mOrthographicMatrixLocationSpriteAnimated =
+		mSpriteAnimatedShader.getLocation("orthographicMatrix");
+	mSamplerLocationSpriteAnimated = mSpriteAnimatedShader.getLocation("sampler");
+	mTimeLocationSpriteAnimated = mSpriteAnimatedShader.getLocation("time");
+	mClipsLocationSpriteAnimated = mSpriteAnimatedShader.getLocation("clips");
+	mFrameUvsLocationSpriteAnimated = mSpriteAnimatedShader.getLocation("frameUvs");
+	mFrameSizesLocationSpriteAnimated = mSpriteAnimatedShader.getLocation("frameSizes");
+
+	bindShader(mSpriteAnimatedShader);
+	gl::Uniform1i(mSamplerLocationSpriteAnimated, 0);
+}
+
+uint32_t Renderer::getAnimatedTableVectors() const
+{
+	return mMaxVertexUniformVectors > animatedReservedVectors ?
+		mMaxVertexUniformVectors - animatedReservedVectors : 0;
+}
+
+uint64_t Renderer::getQueueKey(RenderLayer layer, Program program, const Texture& texture,
+	float depth) const
+{
+	return RenderQueue::MakeKey(static_cast<uint8_t>(layer), static_cast<uint8_t>(program),
+		static_cast<uint16_t>(texture.getID()), depth);
+}
+
+void Renderer::submit(uint64_t key, function<void(Renderer&)> draw)
+{
+	mQueue.submit(key, mOrthoMatrix, move(draw));
+}
+
+void Renderer::submitSprite(RenderLayer layer, const Sprite& sprite,
+	const glm::mat4& transformMatrix)
+{
+	auto depth = transformMatrix[3][2] + (sprite.mBuffer.empty() ? 0.0f : sprite.mBuffer[0].z);
+
+	submit(getQueueKey(layer, Program::SPRITE, *sprite.mTexture, depth),
+		[&sprite, transformMatrix](Renderer& renderer)
+		{
+			renderer.prepareDrawSprite();
+			renderer.drawSprite(sprite, transformMatrix);
+		});
+}
+
+void Renderer::submitText(RenderLayer layer, const Text& text, const glm::mat4& transformMatrix)
+{
+	submit(getQueueKey(layer, Program::TEXT, *text.mTexture, transformMatrix[3][2]),
+		[&text, transformMatrix](Renderer& renderer)
+		{
+			renderer.prepareDrawText();
+			renderer.drawText(text, transformMatrix);
+		});
+}
+
+void Renderer::flushQueue()
+{
+	mQueue.flush(*this);
 }
 
 void Renderer::drawSprite(const Sprite& sprite, const glm::mat4& transformMatrix)
 {
-	gl::Uniform1i(mSamplerLocationSprite, 0); // Slot 0 for base images
-	gl::BindSampler(0, sprite.mTexture->hasMipmap() ? mSamplerMipmapLinear : mSamplerLinear);
+	bindSampler(sprite.mTexture->hasMipmap() ? mSamplerMipmapLinear : mSamplerLinear, 0);
 	gl::UniformMatrix4fv(mOrthographicMatrixLocationSprite, 1, gl::FALSE_,
 		&(mOrthoMatrix * transformMatrix)[0][0]);
 	bindTexture(*sprite.mTexture, 0); // Slot 0 for base images
 	bindVertexArray(*sprite.mVao);
 	gl::DrawArrays(gl::TRIANGLES, sprite.mVboPosition / sprite.mVao->getVertexSize(),
 		sprite.mBuffer.size());
+	mCounters.drawCalls++;
 }
 
 void Renderer::drawText(const Text& text, const glm::mat4& transformMatrix)
 {
-	gl::Uniform1i(mSamplerLocationSprite, 0); // Slot 0 for base images
-	gl::BindSampler(0, text.mTexture->hasMipmap() ? mSamplerMipmapLinear : mSamplerLinear);
+	bindSampler(text.mTexture->hasMipmap() ? mSamplerMipmapLinear : mSamplerLinear, 0);
 	gl::UniformMatrix4fv(mOrthographicMatrixLocationText, 1, gl::FALSE_,
 		&(mOrthoMatrix * transformMatrix)[0][0]);
 	gl::Uniform4fv(mTextColorLocationText, 1, &text.getColor()[0]);
@@ -223,19 +467,87 @@ void Renderer::drawText(const Text& text, const glm::mat4& transformMatrix)
 	bindVertexArray(*text.mVao);
 	gl::DrawArrays(gl::TRIANGLES, text.mVboPosition / text.mVao->getVertexSize(),
 		text.mBuffer.size());
+	mCounters.drawCalls++;
 }
 
-void Renderer::drawSpriteInstanced(const Sprite& sprite, const glm::mat4& transformMatrix, 
-	uint32_t instances)
+void Renderer::drawSpriteBatch(VertexArray& vao, Texture& texture, uint32_t instances)
 {
-	gl::Uniform1i(mSamplerLocationSprite, 0); // Slot 0 for base images
-	gl::BindSampler(0, sprite.mTexture->hasMipmap() ? mSamplerMipmapLinear : mSamplerLinear);
+	bindSampler(texture.hasMipmap() ? mSamplerMipmapLinear : mSamplerLinear, 0);
 	gl::UniformMatrix4fv(mOrthographicMatrixLocationSpriteInstanced, 1, gl::FALSE_,
+		&mOrthoMatrix[0][0]);
+	bindTexture(texture, 0); // Slot 0 for base images
+	bindVertexArray(vao);
+
+	// Every instance is a quad of two triangles
+	gl::DrawArraysInstanced(gl::TRIANGLES, 0, 6, instances);
+	mCounters.drawCalls++;
+}
+
+void Renderer::drawTexture(VertexArray& quad, Texture& texture, const glm::mat4& transformMatrix)
+{
+	bindSampler(texture.hasMipmap() ? mSamplerMipmapLinear : mSamplerLinear, 0);
+	gl::UniformMatrix4fv(mOrthographicMatrixLocationSprite, 1, gl::FALSE_,
 		&(mOrthoMatrix * transformMatrix)[0][0]);
-	bindTexture(*sprite.mTexture, 0); // Slot 0 for base images
-	bindVertexArray(*sprite.mVao);
-	gl::DrawArraysInstanced(gl::TRIANGLES, sprite.mVboPosition / sprite.mVao->getVertexSize(),
-		sprite.mBuffer.size(), instances);
+	bindTexture(texture, 0); // Slot 0 for base images
+	bindVertexArray(quad);
+	gl::DrawArrays(gl::TRIANGLES, 0, 6);
+	mCounters.drawCalls++;
+}
+
+void Renderer::drawGround(VertexArray& quad, Texture& texture,
+	const array<SpriteInstanceVertexLayout::Data, 9>& tiles, const glm::tvec2<int32_t>& first,
+	const glm::tvec2<int32_t>& last, const glm::tvec2<int32_t>& boardSize, float cellSize)
+{
+	if (last.x < first.x || last.y < first.y)
+		return;
+
+	array<glm::vec4, 9> uvs;
+	array<glm::vec4, 9> sizes;
+
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		uvs[i] = glm::vec4{ tiles[i].u0, tiles[i].v0, tiles[i].u1, tiles[i].v1 };
+		sizes[i] = glm::vec4{ tiles[i].width, tiles[i].height, tiles[i].z, tiles[i].layer };
+	}
+
+	auto cells = last - first + 1;
+
+	bindSampler(texture.hasMipmap() ? mSamplerMipmapLinear : mSamplerLinear, 0);
+	gl::UniformMatrix4fv(mOrthographicMatrixLocationGround, 1, gl::FALSE_, &mOrthoMatrix[0][0]);
+	gl::Uniform2i(mFirstCellLocationGround, first.x, first.y);
+	gl::Uniform1i(mColumnsLocationGround, cells.x);
+	gl::Uniform2i(mBoardSizeLocationGround, boardSize.x, boardSize.y);
+	gl::Uniform1f(mCellSizeLocationGround, cellSize);
+	gl::Uniform4fv(mTileUvsLocationGround, uvs.size(), &uvs[0][0]);
+	gl::Uniform4fv(mTileSizesLocationGround, sizes.size(), &sizes[0][0]);
+	bindTexture(texture, 0); // Slot 0 for base images
+	bindVertexArray(quad);
+
+	// Every cell is an instance of the quad
+	gl::DrawArraysInstanced(gl::TRIANGLES, 0, 6, cells.x * cells.y);
+	mCounters.drawCalls++;
+}
+
+void Renderer::drawAnimatedSprites(VertexArray& vao, Texture& texture, uint32_t instances,
+	float time, const vector<glm::vec4>& clips, const vector<glm::vec4>& frameUvs,
+	const vector<glm::vec4>& frameSizes)
+{
+	if (instances == 0 || clips.empty() || frameUvs.empty())
+		return;
+
+	bindSampler(texture.hasMipmap() ? mSamplerMipmapLinear : mSamplerLinear, 0);
+	gl::UniformMatrix4fv(mOrthographicMatrixLocationSpriteAnimated, 1, gl::FALSE_,
+		&mOrthoMatrix[0][0]);
+	gl::Uniform1f(mTimeLocationSpriteAnimated, time);
+	gl::Uniform4fv(mClipsLocationSpriteAnimated, clips.size(), &clips[0][0]);
+	gl::Uniform4fv(mFrameUvsLocationSpriteAnimated, frameUvs.size(), &frameUvs[0][0]);
+	gl::Uniform4fv(mFrameSizesLocationSpriteAnimated, frameSizes.size(), &frameSizes[0][0]);
+	bindTexture(texture, 0); // Slot 0 for base images
+	bindVertexArray(vao);
+
+	// Every instance is a quad of two triangles
+	gl::DrawArraysInstanced(gl::TRIANGLES, 0, 6, instances);
+	mCounters.drawCalls++;
 }
 
 bool Renderer::isInitialized() const
@@ -243,3 +555,23 @@ bool Renderer::isInitialized() const
 	return mInitialized;
 }
 
+void Renderer::setValidation(bool validation)
+{
+	mValidation = validation;
+}
+
+bool Renderer::isValidation() const
+{
+	return mValidation;
+}
+
+const RendererCounters& Renderer::getCounters() const
+{
+	return mCounters;
+}
+
+void Renderer::clearCounters()
+{
+	mCounters.clear();
+}
+
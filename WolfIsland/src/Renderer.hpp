@@ -1,10 +1,52 @@
 #pragma once
 #include "Prerequisites.hpp"
 #include "gl_core_3_3.hpp"
+#include "VertexLayout.hpp"
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
 #include "Shader.hpp"
+#include "RenderQueue.hpp"
 
+class RendererValidationException : public std::exception
+{
+	virtual const char* what() const noexcept
+	{
+		return "Renderer state doesn't match the OpenGL state.";
+	}
+};
+
+// Calls made by the renderer since counters were cleared
+struct RendererCounters
+{
+	RendererCounters();
+
+	std::uint32_t drawCalls;
+	std::uint32_t programBinds;
+	std::uint32_t vertexArrayBinds;
+	std::uint32_t textureBinds;
+	std::uint32_t samplerBinds;
+
+	// Blending and depth test switches
+	std::uint32_t capabilityChanges;
+
+	// Binds and switches of the state already set, no call was made
+	std::uint32_t avoidedStateChanges;
+
+	// Stream buffers given new storage because the GPU still read the region to be written
+	std::uint32_t bufferOrphans;
+
+	void clear();
+};
+
+// Layers of queued draws, drawn from the first one
+enum class RenderLayer : std::uint8_t
+{
+	GROUND,
+	OBJECTS,
+	GUI,
+	GUI_TEXT
+};
 
 class Renderer
 {
@@ -16,43 +58,138 @@ public:
 
 	// Consider using const references while not drunk
 
+	// Programs, textures, samplers, arrays and capabilities are cached, calls setting what is
+	// already set are skipped
 	void bindShader(class Shader& shader);
 	void bindTexture(class Texture& texture, std::int32_t slot);
+	void bindSampler(GLuint sampler, std::int32_t slot);
 	void bindVertexArray(class VertexArray &arr);
+
+	// Forget bound arrays or textures, names of deleted ones are reused by new ones
+	void resetVertexArrayBinding();
+	void resetTextureBindings();
+
 	void bindBuffer(class GpuBuffer &buf);
 	void bindBuffer(class GpuBuffer &buf, enum class GpuBufferType &type);
+
+	// Gives the bound vertex buffer new storage of the size, draws in flight keep reading
+	// the old one
+	void orphanBuffer(std::uint32_t size);
 	void bindOrthoMatrix(const glm::mat4& orthoMatrix);
 	void setDepthTest(bool state);
+	void setBlending(bool state);
 	void setViewport(const glm::tvec2<std::int32_t>& dimensions);
 
+	// Draws go to the framebuffer with a viewport of its size, until the default framebuffer
+	// is bound again with the last set viewport
+	void bindFramebuffer(class Framebuffer& framebuffer);
+	void bindDefaultFramebuffer();
+
+	// Programs in the order of their bits in queue keys
+	enum class Program : std::uint8_t
+	{
+		SPRITE,
+		TEXT,
+		SPRITE_INSTANCED,
+		GROUND,
+		SPRITE_ANIMATED
+	};
+
 	void prepareDrawSprite();
 	void prepareDrawText();
 	void prepareDrawSpriteInstanced();
+	void prepareDrawGround();
+	void prepareDrawSpriteAnimated();
+
+	// Compiles the animated sprite program with tables of the sizes in vectors, frames take
+	// one vector of uvs and one of sizes. Draws queued with the former program have to be
+	// flushed before.
+	void createAnimatedProgram(std::uint32_t frames, std::uint32_t clipVectors);
+
+	// Uniform vectors of the vertex stage the tables of the animated sprite program can take
+	std::uint32_t getAnimatedTableVectors() const;
+
+	// Key of a draw of the queue, with the texture it binds
+	std::uint64_t getQueueKey(RenderLayer layer, Program program, const class Texture& texture,
+		float depth) const;
+
+	// Queues the draw with the bound ortho matrix, draws run sorted by keys when the queue is
+	// flushed. Everything the draw refers to has to live until then.
+	void submit(std::uint64_t key, std::function<void(Renderer&)> draw);
+	void submitSprite(RenderLayer layer, const class Sprite& sprite,
+		const glm::mat4& transformMatrix);
+	void submitText(RenderLayer layer, const class Text& text, const glm::mat4& transformMatrix);
+	void flushQueue();
 
 	void drawSprite(const class Sprite& sprite, const glm::mat4& transformMatrix);
 	void drawText(const class Text& text, const glm::mat4& transformMatrix);
-	void drawSpriteInstanced(const class Sprite& sprite, const glm::mat4& transformMatrix, 
-		std::uint32_t instances);
+
+	// Instances of a sprite batch, the texture is the texture array of their sprites
+	void drawSpriteBatch(class VertexArray& vao, class Texture& texture, std::uint32_t instances);
+
+	// Whole texture on the unit quad of sprite batches, scaled and moved by the transform
+	void drawTexture(class VertexArray& quad, class Texture& texture,
+		const glm::mat4& transformMatrix);
+
+	// Quads of cells inside the rectangle, corners included, generated by the shader. Tiles are
+	// sprites of the 3x3 groups of the board and its border at the origin.
+	void drawGround(class VertexArray& quad, class Texture& texture,
+		const std::array<SpriteInstanceVertexLayout::Data, 9>& tiles,
+		const glm::tvec2<std::int32_t>& first, const glm::tvec2<std::int32_t>& last,
+		const glm::tvec2<std::int32_t>& boardSize, float cellSize);
+
+	// Instances of an animated layer at the time since their moves started. Clips and frames
+	// are the shader's tables, clips hold their frames count, duration and frames packed in
+	// vectors, frames hold uvs and sizes of sprites in the texture array.
+	void drawAnimatedSprites(class VertexArray& vao, class Texture& texture,
+		std::uint32_t instances, float time, const std::vector<glm::vec4>& clips,
+		const std::vector<glm::vec4>& frameUvs, const std::vector<glm::vec4>& frameSizes);
 
 	bool isInitialized() const;
+
+	// Validation compares the state the renderer keeps with the OpenGL state on every bind,
+	// and throws RendererValidationException for binds which were redundant or skipped
+	// wrongly. It stalls the pipeline, so it's meant for debug builds.
+	void setValidation(bool validation);
+	bool isValidation() const;
+
+	const RendererCounters& getCounters() const;
+	void clearCounters();
 	
 private:
-	bool mInitialized;
+	static const std::int32_t textureSlots{ 4 };
 
-	enum class Setup
-	{
-		SPRITE,
-		TEXT,
-		SPRITE_INSTANCED
-	} mSetup;
+	// Uniform vectors of the animated sprite program other than its tables, the matrix and time
+	static const std::uint32_t animatedReservedVectors{ 5 };
+
+	bool mInitialized;
+	bool mValidation;
+	RendererCounters mCounters;
+	RenderQueue mQueue;
+
+	// Cached state, textures are kept for 2d and 2d array targets of every slot
+	GLuint mBoundProgram;
+	GLuint mBoundVertexArray;
+	std::int32_t mActiveTextureSlot;
+	std::array<std::array<GLuint, 2>, textureSlots> mBoundTextures;
+	std::array<GLuint, textureSlots> mBoundSamplers;
+	bool mBlending;
+	bool mDepthTest;
+	glm::tvec2<std::int32_t> mViewport;
 
 	glm::mat4 mOrthoMatrix;
 
 	Shader mTextShader;
 	Shader mSpriteShader;
 	Shader mSpriteInstancedShader;
+	Shader mGroundShader;
+	Shader mSpriteAnimatedShader;
 	Shader mWaterShader;
 
+	std::string mSpriteAnimatedVertexSource;
+	std::string mSpriteAnimatedFragmentSource;
+	std::uint32_t mMaxVertexUniformVectors;
+
 	GLuint mSamplerMipmapLinear;
 	GLuint mSamplerLinear;
 
@@ -66,6 +203,22 @@ private:
 	GLint mOrthographicMatrixLocationSpriteInstanced;
 	GLint mSamplerLocationSpriteInstanced;
 
+	GLint mOrthographicMatrixLocationGround;
+	GLint mSamplerLocationGround;
+	GLint mFirstCellLocationGround;
+	GLint mColumnsLocationGround;
+	GLint mBoardSizeLocationGround;
+	GLint mCellSizeLocationGround;
+	GLint mTileUvsLocationGround;
+	GLint mTileSizesLocationGround;
+
+	GLint mOrthographicMatrixLocationSpriteAnimated;
+	GLint mSamplerLocationSpriteAnimated;
+	GLint mTimeLocationSpriteAnimated;
+	GLint mClipsLocationSpriteAnimated;
+	GLint mFrameUvsLocationSpriteAnimated;
+	GLint mFrameSizesLocationSpriteAnimated;
+
 	GLint mOrthographicMatrixLocationWater;
 	GLint mSamplerLocationWater;
 	GLint mDisplacementLocationWater;
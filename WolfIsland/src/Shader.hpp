@@ -12,7 +12,7 @@ public:
 	// Copy/Move constructors and assignments
 	Shader(const Shader &lhs) = delete;
 	Shader(Shader &&rhs);
-	Shader& operator=(Shader cas) = delete;
+	Shader& operator=(const Shader& lhs) = delete;
 	Shader& operator=(Shader &&rhs);
 
 	Shader(std::string vertexShader, std::string fragmentShader);
@@ -0,0 +1,148 @@
+#include "SimulationParameters.hpp"
+using namespace std;
+
+static const vector<string> parameterNames{
+	"splitChance", "splitTourTime", "minLifeTours", "maxLifeTours", "hareTransitionTime",
+	"hareAppetite", "vegetationGrowth", "vegetationDiffusion",
+	"fatLoss", "mateTourTime", "pupTourTime", "wolfTransitionTime",
+	"pursuitRange"
+};
+
+static const float maxVegetationDiffusion{ 0.25f };
+
+
+SimulationParameters::SimulationParameters()
+	: splitChance{ 10 }, splitTourTime{ 5 }, minLifeTours{ 15 }, maxLifeTours{ 20 },
+	hareTransitionTime{ 0.5f }, hareAppetite{ 0.25f }, vegetationGrowth{ 0.05f },
+	vegetationDiffusion{ 0.1f }, fatLoss{ 0.05f }, mateTourTime{ 5 }, pupTourTime{ 5 },
+	wolfTransitionTime{ 1.0f }, pursuitRange{ 6 }
+{
+}
+
+bool SimulationParameters::set(const string& name, double value)
+{
+	auto toCount = [value]() { return static_cast<uint32_t>(max(llround(value), 0ll)); };
+
+	if (name == "splitChance")
+		splitChance = static_cast<int32_t>(llround(value));
+	else if (name == "splitTourTime")
+		splitTourTime = toCount();
+	else if (name == "minLifeTours")
+		minLifeTours = toCount();
+	else if (name == "maxLifeTours")
+		maxLifeTours = toCount();
+	else if (name == "hareTransitionTime")
+		hareTransitionTime = static_cast<float>(value);
+	else if (name == "hareAppetite")
+		hareAppetite = static_cast<float>(value);
+	else if (name == "vegetationGrowth")
+		vegetationGrowth = static_cast<float>(value);
+	else if (name == "vegetationDiffusion")
+		vegetationDiffusion = static_cast<float>(value);
+	else if (name == "fatLoss")
+		fatLoss = static_cast<float>(value);
+	else if (name == "mateTourTime")
+		mateTourTime = toCount();
+	else if (name == "pupTourTime")
+		pupTourTime = toCount();
+	else if (name == "wolfTransitionTime")
+		wolfTransitionTime = static_cast<float>(value);
+	else if (name == "pursuitRange")
+		pursuitRange = toCount();
+	else
+		return false;
+
+	// Life span distribution needs an ordered range
+	if (minLifeTours == 0)
+		minLifeTours = 1;
+
+	if (maxLifeTours < minLifeTours)
+		maxLifeTours = minLifeTours;
+
+	// Explicit diffusion oscillates above a quarter of a cell's food per neighbour
+	vegetationDiffusion = min(max(vegetationDiffusion, 0.0f), maxVegetationDiffusion);
+
+	return true;
+}
+
+double SimulationParameters::get(const string& name) const
+{
+	if (name == "splitChance")
+		return splitChance;
+	else if (name == "splitTourTime")
+		return splitTourTime;
+	else if (name == "minLifeTours")
+		return minLifeTours;
+	else if (name == "maxLifeTours")
+		return maxLifeTours;
+	else if (name == "hareTransitionTime")
+		return hareTransitionTime;
+	else if (name == "hareAppetite")
+		return hareAppetite;
+	else if (name == "vegetationGrowth")
+		return vegetationGrowth;
+	else if (name == "vegetationDiffusion")
+		return vegetationDiffusion;
+	else if (name == "fatLoss")
+		return fatLoss;
+	else if (name == "mateTourTime")
+		return mateTourTime;
+	else if (name == "pupTourTime")
+		return pupTourTime;
+	else if (name == "wolfTransitionTime")
+		return wolfTransitionTime;
+	else if (name == "pursuitRange")
+		return pursuitRange;
+
+	return 0.0;
+}
+
+bool SimulationParameters::isSimulationEqual(const SimulationParameters& other) const
+{
+	return splitChance == other.splitChance && splitTourTime == other.splitTourTime &&
+		minLifeTours == other.minLifeTours && maxLifeTours == other.maxLifeTours &&
+		hareAppetite == other.hareAppetite && vegetationGrowth == other.vegetationGrowth &&
+		vegetationDiffusion == other.vegetationDiffusion &&
+		fatLoss == other.fatLoss && mateTourTime == other.mateTourTime &&
+		pupTourTime == other.pupTourTime && pursuitRange == other.pursuitRange;
+}
+
+size_t SimulationParameters::hashSimulation() const
+{
+	size_t hash{ 0 };
+
+	auto combine = [&hash](size_t value)
+	{
+		hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+	};
+
+	combine(std::hash<int32_t>{}(splitChance));
+	combine(std::hash<uint32_t>{}(splitTourTime));
+	combine(std::hash<uint32_t>{}(minLifeTours));
+	combine(std::hash<uint32_t>{}(maxLifeTours));
+	combine(std::hash<float>{}(hareAppetite));
+	combine(std::hash<float>{}(vegetationGrowth));
+	combine(std::hash<float>{}(vegetationDiffusion));
+	combine(std::hash<float>{}(fatLoss));
+	combine(std::hash<uint32_t>{}(mateTourTime));
+	combine(std::hash<uint32_t>{}(pupTourTime));
+	combine(std::hash<uint32_t>{}(pursuitRange));
+
+	return hash;
+}
+
+const vector<string>& SimulationParameters::GetNames()
+{
+	return parameterNames;
+}
+
+SimulationParameters SimulationParameters::GetReference()
+{
+	// Hares eat nothing and wolves see only their neighbours
+	SimulationParameters parameters;
+	parameters.hareAppetite = 0.0f;
+	parameters.pursuitRange = 0;
+
+	return parameters;
+}
+
@@ -0,0 +1,52 @@
+#pragma once
+#include "Prerequisites.hpp"
+
+
+// Behaviour constants of all species, owned by the board so batch runs can vary them
+struct SimulationParameters
+{
+	// Defaults feed hares on vegetation and let wolves pursue them, which changes the model of
+	// earlier versions for the game and batch runs alike. Runs compared with earlier results
+	// start from GetReference().
+	SimulationParameters();
+
+	// Hare
+	std::int32_t splitChance;
+	std::uint32_t splitTourTime;
+	std::uint32_t minLifeTours;
+	std::uint32_t maxLifeTours;
+	float hareTransitionTime;
+
+	// Food eaten every turn, hares split only after a full meal, 0 disables vegetation
+	float hareAppetite;
+
+	// Vegetation, diffusion is kept in [0, 0.25] where the explicit stencil is stable
+	float vegetationGrowth;
+	float vegetationDiffusion;
+
+	// Wolves
+	float fatLoss;
+	std::uint32_t mateTourTime;
+	std::uint32_t pupTourTime;
+	float wolfTransitionTime;
+
+	// Wolves follow the hare flow field from this distance, 0 limits them to neighbours
+	std::uint32_t pursuitRange;
+
+	// Access by name, used by command line and parameter sweeps
+	bool set(const std::string& name, double value);
+	double get(const std::string& name) const;
+
+	// Transition times only drive animations, so they never change a headless run
+	bool isSimulationEqual(const SimulationParameters& other) const;
+
+	// Equal for parameters with equal simulations
+	std::size_t hashSimulation() const;
+
+	static const std::vector<std::string>& GetNames();
+
+	// Constants of the island before food and pursuit were added, runs with them reproduce
+	// results of earlier versions. Selected by preset=reference on the command line.
+	static SimulationParameters GetReference();
+};
+
@@ -1,6 +1,7 @@
 #pragma once
 #include "Prerequisites.hpp"
 #include "GuiObject.hpp"
+#include "Renderer.hpp"
 #include <GLFW/glfw3.h>
 #include <glm/vec2.hpp>
 
@@ -82,17 +83,16 @@ inline Slider<T>::~Slider()
 template<typename T>
 inline void Slider<T>::draw(Renderer& renderer) const
 {
-	renderer.prepareDrawSprite();
-	renderer.drawSprite(*mGuiSpriteSheet->getSprite(sliderIndex()).lock(), 
+	renderer.submitSprite(RenderLayer::GUI, *mGuiSpriteSheet->getSprite(sliderIndex()).lock(),
 		glm::translate(glm::vec3{ mPos.x, mPos.y, 0.0f }));
 
 	auto pos = mPos + mButtonPos;
-	renderer.drawSprite(*mGuiSpriteSheet->getSprite(buttonIndex()).lock(), 
+	renderer.submitSprite(RenderLayer::GUI, *mGuiSpriteSheet->getSprite(buttonIndex()).lock(),
 		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
 
-	renderer.prepareDrawText();
 	pos = mPos + mTextPos;
-	renderer.drawText(*mText, glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	renderer.submitText(RenderLayer::GUI_TEXT, *mText,
+		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
 }
 
 template<typename T>
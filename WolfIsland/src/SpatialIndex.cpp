@@ -0,0 +1,100 @@
+#include "SpatialIndex.hpp"
+using namespace std;
+
+
+SpatialIndex::SpatialIndex()
+	: mWidth{ 0 }, mHeight{ 0 }, mBucketSize{ 1 }, mBucketsWidth{ 0 }, mBucketsHeight{ 0 }
+{
+}
+
+SpatialIndex::SpatialIndex(uint32_t width, uint32_t height, uint32_t bucketSize)
+	: mWidth{ 0 }, mHeight{ 0 }, mBucketSize{ 1 }, mBucketsWidth{ 0 }, mBucketsHeight{ 0 }
+{
+	create(width, height, bucketSize);
+}
+
+void SpatialIndex::create(uint32_t width, uint32_t height, uint32_t bucketSize)
+{
+	mWidth = width;
+	mHeight = height;
+	mBucketSize = max(bucketSize, 1u);
+	mBucketsWidth = max((width + mBucketSize - 1) / mBucketSize, 1u);
+	mBucketsHeight = max((height + mBucketSize - 1) / mBucketSize, 1u);
+
+	mBuckets.clear();
+	mBuckets.resize(mBucketsWidth * mBucketsHeight);
+}
+
+SpatialIndex::~SpatialIndex()
+{
+}
+
+void SpatialIndex::clear()
+{
+	// Buckets keep their memory for the next rebuild
+	for (auto& bucket : mBuckets)
+		bucket.clear();
+}
+
+void SpatialIndex::insert(EntityHandle handle, const glm::tvec2<int32_t>& pos)
+{
+	mBuckets[getBucket(pos)].push_back({ handle, pos });
+}
+
+void SpatialIndex::query(const glm::tvec2<int32_t>& first, const glm::tvec2<int32_t>& last,
+	vector<EntityHandle>& handles) const
+{
+	auto firstBucket = getBucketPos(first);
+	auto lastBucket = getBucketPos(last);
+
+	for (int32_t y = firstBucket.y; y <= lastBucket.y; y++)
+	{
+		for (int32_t x = firstBucket.x; x <= lastBucket.x; x++)
+		{
+			for (auto& entry : mBuckets[y * mBucketsWidth + x])
+			{
+				if (entry.pos.x >= first.x && entry.pos.y >= first.y && entry.pos.x <= last.x &&
+					entry.pos.y <= last.y)
+					handles.push_back(entry.handle);
+			}
+		}
+	}
+}
+
+uint32_t SpatialIndex::getBucketSize() const
+{
+	return mBucketSize;
+}
+
+uint32_t SpatialIndex::getBucket(const glm::tvec2<int32_t>& pos) const
+{
+	auto bucketPos = getBucketPos(pos);
+	return bucketPos.y * mBucketsWidth + bucketPos.x;
+}
+
+uint32_t SpatialIndex::getBucketsCount() const
+{
+	return mBuckets.size();
+}
+
+uint32_t SpatialIndex::getBucketCount(uint32_t bucket) const
+{
+	return mBuckets[bucket].size();
+}
+
+uint32_t SpatialIndex::getBucketCells(uint32_t bucket) const
+{
+	uint32_t x = bucket % mBucketsWidth * mBucketSize;
+	uint32_t y = bucket / mBucketsWidth * mBucketSize;
+
+	return (min(x + mBucketSize, mWidth) - x) * (min(y + mBucketSize, mHeight) - y);
+}
+
+glm::tvec2<int32_t> SpatialIndex::getBucketPos(const glm::tvec2<int32_t>& pos) const
+{
+	return { min(max(pos.x, 0) / static_cast<int32_t>(mBucketSize),
+		static_cast<int32_t>(mBucketsWidth) - 1),
+		min(max(pos.y, 0) / static_cast<int32_t>(mBucketSize),
+		static_cast<int32_t>(mBucketsHeight) - 1) };
+}
+
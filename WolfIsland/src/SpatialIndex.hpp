@@ -0,0 +1,52 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "EntityStore.hpp"
+#include <glm/vec2.hpp>
+
+
+// Entities bucketed by cell position in square blocks of cells. Entities of a bucket keep
+// the order they were inserted in. Positions outside the board go to the nearest bucket.
+class SpatialIndex
+{
+public:
+	SpatialIndex();
+
+	SpatialIndex(std::uint32_t width, std::uint32_t height, std::uint32_t bucketSize = 8);
+	void create(std::uint32_t width, std::uint32_t height, std::uint32_t bucketSize = 8);
+
+	~SpatialIndex();
+
+	void clear();
+	void insert(EntityHandle handle, const glm::tvec2<std::int32_t>& pos);
+
+	// Appends entities with positions inside the rectangle, corners included
+	void query(const glm::tvec2<std::int32_t>& first, const glm::tvec2<std::int32_t>& last,
+		std::vector<EntityHandle>& handles) const;
+
+	std::uint32_t getBucketSize() const;
+	std::uint32_t getBucket(const glm::tvec2<std::int32_t>& pos) const;
+	std::uint32_t getBucketsCount() const;
+
+	// Entities of the bucket, inactive ones included
+	std::uint32_t getBucketCount(std::uint32_t bucket) const;
+
+	// Cells of the board in the bucket, less than the full size at the board edges
+	std::uint32_t getBucketCells(std::uint32_t bucket) const;
+
+private:
+	struct Entry
+	{
+		EntityHandle handle;
+		glm::tvec2<std::int32_t> pos;
+	};
+
+	std::uint32_t mWidth;
+	std::uint32_t mHeight;
+	std::uint32_t mBucketSize;
+	std::uint32_t mBucketsWidth;
+	std::uint32_t mBucketsHeight;
+	std::vector<std::vector<Entry>> mBuckets;
+
+	glm::tvec2<std::int32_t> getBucketPos(const glm::tvec2<std::int32_t>& pos) const;
+};
+
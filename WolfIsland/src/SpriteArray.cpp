@@ -0,0 +1,137 @@
+#include "SpriteArray.hpp"
+#include "SpriteSheet.hpp"
+#include "Sprite.hpp"
+#include "Texture.hpp"
+#include "Renderer.hpp"
+using namespace std;
+
+
+SpriteArray::SpriteArray()
+{
+}
+
+SpriteArray::~SpriteArray()
+{
+}
+
+void SpriteArray::add(const SpriteSheet& sheet, const Image& image)
+{
+	auto& instances = mSheets[&sheet];
+	instances.clear();
+
+	for (uint32_t i = 0; i < sheet.getSpritesCount(); i++)
+		instances.push_back(GetInstance(*sheet.getSprite(i).lock(), mImages.size()));
+
+	mImages.push_back(image);
+}
+
+void SpriteArray::add(const Sprite& sprite, const Image& image)
+{
+	mSprites[&sprite] = GetInstance(sprite, mImages.size());
+	mImages.push_back(image);
+}
+
+void SpriteArray::build(Renderer& renderer)
+{
+	if (mImages.empty())
+		return;
+
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+
+	for (auto& image : mImages)
+	{
+		width = max(width, image.getWidth());
+		height = max(height, image.getHeight());
+	}
+
+	// Images are put in the corner of their layers, the rest stays transparent
+	vector<Image> layers;
+	vector<glm::vec2> scales;
+
+	for (auto& image : mImages)
+	{
+		layers.emplace_back(width, height, Image::Format::RGBA8);
+		layers.back().copy(image, 0, 0);
+		scales.push_back(glm::vec2{ static_cast<float>(image.getWidth()) / width,
+			static_cast<float>(image.getHeight()) / height });
+	}
+
+	auto scale = [&scales](SpriteInstanceVertexLayout::Data& instance)
+	{
+		auto& s = scales[static_cast<uint32_t>(instance.layer)];
+		instance.u0 *= s.x;
+		instance.v0 *= s.y;
+		instance.u1 *= s.x;
+		instance.v1 *= s.y;
+	};
+
+	for (auto& sheet : mSheets)
+	{
+		for (auto& instance : sheet.second)
+			scale(instance);
+	}
+
+	for (auto& sprite : mSprites)
+		scale(sprite.second);
+
+	mTexture = make_shared<Texture>(layers, renderer);
+	mTexture->generateMipmaps(renderer);
+	mImages.clear();
+}
+
+bool SpriteArray::getInstance(const SpriteSheet& sheet, uint32_t sprite, const glm::vec2& pos,
+	SpriteInstanceVertexLayout::Data& instance) const
+{
+	auto it = mSheets.find(&sheet);
+
+	if (it == end(mSheets) || sprite >= it->second.size())
+		return false;
+
+	instance = it->second[sprite];
+	instance.x += pos.x;
+	instance.y += pos.y;
+
+	return true;
+}
+
+bool SpriteArray::getInstance(const Sprite& sprite, const glm::vec2& pos,
+	SpriteInstanceVertexLayout::Data& instance) const
+{
+	auto it = mSprites.find(&sprite);
+
+	if (it == end(mSprites))
+		return false;
+
+	instance = it->second;
+	instance.x += pos.x;
+	instance.y += pos.y;
+
+	return true;
+}
+
+weak_ptr<Texture> SpriteArray::getTexture() const
+{
+	return mTexture;
+}
+
+uint32_t SpriteArray::getSheetSpritesCount() const
+{
+	uint32_t count{ 0 };
+
+	for (auto& sheet : mSheets)
+		count += sheet.second.size();
+
+	return count;
+}
+
+SpriteInstanceVertexLayout::Data SpriteArray::GetInstance(const Sprite& sprite, uint32_t layer)
+{
+	// First vertex is the lower left corner and fifth one the upper right
+	auto& buffer = sprite.getBuffer();
+	auto& bounds = sprite.getBounds();
+
+	return SpriteInstanceVertexLayout::Data{ 0.0f, 0.0f, buffer[0].z, bounds.x, bounds.y,
+		buffer[0].u, buffer[0].v, buffer[4].u, buffer[4].v, static_cast<float>(layer) };
+}
+
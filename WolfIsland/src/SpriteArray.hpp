@@ -0,0 +1,47 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "Image.hpp"
+#include "VertexLayout.hpp"
+#include <glm/vec2.hpp>
+
+// Images of sprite sheets packed as layers of one texture array, so sprites of all sheets
+// can be drawn without switching textures. Images smaller than the largest one are padded,
+// uvs of their sprites are scaled to the part of the layer they fill.
+// Sheets and sprites have to outlive the array.
+class SpriteArray
+{
+public:
+	SpriteArray();
+	~SpriteArray();
+
+	// Image of the sheet becomes the next layer, the array is created by build
+	void add(const class SpriteSheet& sheet, const Image& image);
+	void add(const class Sprite& sprite, const Image& image);
+
+	// Creates the texture array with mipmaps and releases added images. Throws
+	// ImageFormatException for images which aren't rgb or rgba.
+	void build(class Renderer& renderer);
+
+	// Instance of the sprite at the position, returns false when its sheet isn't in the array
+	bool getInstance(const class SpriteSheet& sheet, std::uint32_t sprite, const glm::vec2& pos,
+		SpriteInstanceVertexLayout::Data& instance) const;
+	bool getInstance(const class Sprite& sprite, const glm::vec2& pos,
+		SpriteInstanceVertexLayout::Data& instance) const;
+
+	std::weak_ptr<class Texture> getTexture() const;
+
+	// Sprites of all sheets in the array
+	std::uint32_t getSheetSpritesCount() const;
+
+private:
+	std::vector<Image> mImages;
+	std::unordered_map<const class SpriteSheet*, std::vector<SpriteInstanceVertexLayout::Data>>
+		mSheets;
+	std::unordered_map<const class Sprite*, SpriteInstanceVertexLayout::Data> mSprites;
+	std::shared_ptr<class Texture> mTexture;
+
+	// Instance at the origin with uvs of the sprite within its image
+	static SpriteInstanceVertexLayout::Data GetInstance(const class Sprite& sprite,
+		std::uint32_t layer);
+};
+
@@ -0,0 +1,131 @@
+#include "SpriteBatch.hpp"
+#include "SpriteArray.hpp"
+#include "Texture.hpp"
+#include "VertexArray.hpp"
+#include "VertexBuffer.hpp"
+#include "Renderer.hpp"
+using namespace std;
+
+// Instances a new buffer has room for at least
+static const uint32_t minBufferInstances{ 256 };
+
+
+SpriteBatch::SpriteBatch()
+	: mInstancesCount{ 0 }, mRegion{ 0 }
+{
+}
+
+SpriteBatch::SpriteBatch(shared_ptr<const SpriteArray> sprites, Renderer& renderer)
+	: mInstancesCount{ 0 }, mRegion{ 0 }
+{
+	create(sprites, renderer);
+}
+
+void SpriteBatch::create(shared_ptr<const SpriteArray> sprites, Renderer& renderer)
+{
+	mSprites = sprites;
+	mInstanceBuffer.reset();
+	mInstances.clear();
+	mInstancesCount = 0;
+	mQuad = CreateQuad(renderer);
+	mRegionVaos.clear();
+}
+
+SpriteBatch::~SpriteBatch()
+{
+}
+
+void SpriteBatch::add(const SpriteSheet& sheet, uint32_t sprite, const glm::vec2& pos)
+{
+	SpriteInstanceVertexLayout::Data instance;
+
+	if (mSprites->getInstance(sheet, sprite, pos, instance))
+		mInstances.push_back(instance);
+}
+
+void SpriteBatch::add(const Sprite& sprite, const glm::vec2& pos)
+{
+	SpriteInstanceVertexLayout::Data instance;
+
+	if (mSprites->getInstance(sprite, pos, instance))
+		mInstances.push_back(instance);
+}
+
+void SpriteBatch::add(const vector<SpriteInstanceVertexLayout::Data>& instances)
+{
+	mInstances.insert(end(mInstances), begin(instances), end(instances));
+}
+
+void SpriteBatch::upload(Renderer& renderer)
+{
+	mInstancesCount = mInstances.size();
+
+	if (mInstances.empty())
+		return;
+
+	if (!mInstanceBuffer || mInstanceBuffer->getElementsCount() < mInstancesCount)
+	{
+		uint32_t size = max(mInstancesCount, minBufferInstances);
+
+		if (mInstanceBuffer)
+			size = max(size, 2 * mInstanceBuffer->getElementsCount());
+
+		mInstanceBuffer = make_shared<VertexBuffer<SpriteInstanceVertexLayout>>(size, renderer,
+			VertexBufferUsage::STREAM);
+		mRegionVaos.clear();
+
+		for (uint32_t i = 0; i < mInstanceBuffer->streamRegions; i++)
+			mRegionVaos.push_back(make_shared<VertexArray>(mQuad, mInstanceBuffer, renderer,
+				mInstanceBuffer->getRegionPosition(i)));
+	}
+
+	mRegion = mInstanceBuffer->stream(mInstances, renderer);
+	mInstances.clear();
+}
+
+void SpriteBatch::draw(Renderer& renderer)
+{
+	if (mInstancesCount == 0)
+		return;
+
+	auto texture = mSprites->getTexture().lock();
+	auto vao = mRegionVaos[mRegion];
+	auto buffer = mInstanceBuffer;
+	auto count = mInstancesCount;
+
+	renderer.submit(renderer.getQueueKey(RenderLayer::OBJECTS,
+		Renderer::Program::SPRITE_INSTANCED, *texture, 0.0f),
+		[texture, vao, buffer, count](Renderer& renderer)
+		{
+			renderer.prepareDrawSpriteInstanced();
+			renderer.drawSpriteBatch(*vao, *texture, count);
+
+			// Region isn't written again until the gpu has read it
+			buffer->fence();
+		});
+}
+
+void SpriteBatch::flush(Renderer& renderer)
+{
+	upload(renderer);
+	draw(renderer);
+}
+
+uint32_t SpriteBatch::getInstancesCount() const
+{
+	return mInstancesCount;
+}
+
+shared_ptr<VertexBuffer<TextureVertexLayout>> SpriteBatch::CreateQuad(Renderer& renderer)
+{
+	typedef TextureVertexLayout::Data Vertex;
+
+	auto quad = make_shared<VertexBuffer<TextureVertexLayout>>(6, renderer);
+	quad->add(vector<Vertex>{ Vertex{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+		Vertex{ 0.0f, 1.0f, 0.0f, 0.0f, 1.0f }, Vertex{ 1.0f, 0.0f, 0.0f, 1.0f, 0.0f },
+		Vertex{ 0.0f, 1.0f, 0.0f, 0.0f, 1.0f }, Vertex{ 1.0f, 1.0f, 0.0f, 1.0f, 1.0f },
+		Vertex{ 1.0f, 0.0f, 0.0f, 1.0f, 0.0f } }, renderer);
+
+	return quad;
+}
+
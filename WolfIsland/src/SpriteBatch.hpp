@@ -0,0 +1,50 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "VertexLayout.hpp"
+#include <glm/vec2.hpp>
+
+template <typename T>
+class VertexBuffer;
+
+// Sprites of a sprite array drawn with one instanced draw. Added sprites are streamed to
+// the next region of an instance buffer, which grows to the most sprites uploaded, and
+// uploaded sprites are drawn until the next upload. Every region has its own vertex array,
+// growing the buffer builds new ones.
+class SpriteBatch
+{
+public:
+	SpriteBatch();
+
+	SpriteBatch(std::shared_ptr<const class SpriteArray> sprites, class Renderer& renderer);
+	void create(std::shared_ptr<const class SpriteArray> sprites, class Renderer& renderer);
+
+	~SpriteBatch();
+
+	// Sprites outside of the array aren't drawn
+	void add(const class SpriteSheet& sheet, std::uint32_t sprite, const glm::vec2& pos);
+	void add(const class Sprite& sprite, const glm::vec2& pos);
+	void add(const std::vector<SpriteInstanceVertexLayout::Data>& instances);
+
+	void upload(class Renderer& renderer);
+	void draw(class Renderer& renderer);
+
+	// Uploads added sprites and draws them
+	void flush(class Renderer& renderer);
+
+	// Sprites of the last upload
+	std::uint32_t getInstancesCount() const;
+
+	// Unit quad sprites are scaled from, its uvs run across the sprite uv rect
+	static std::shared_ptr<VertexBuffer<TextureVertexLayout>> CreateQuad(class Renderer& renderer);
+
+private:
+	std::shared_ptr<const class SpriteArray> mSprites;
+	std::shared_ptr<VertexBuffer<TextureVertexLayout>> mQuad;
+
+	std::shared_ptr<VertexBuffer<SpriteInstanceVertexLayout>> mInstanceBuffer;
+	std::vector<std::shared_ptr<class VertexArray>> mRegionVaos;
+	std::uint32_t mRegion;
+	std::vector<SpriteInstanceVertexLayout::Data> mInstances;
+	std::uint32_t mInstancesCount;
+};
+
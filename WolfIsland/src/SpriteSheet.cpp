@@ -52,6 +52,11 @@ std::weak_ptr<const class Sprite> SpriteSheet::getSprite(std::uint32_t index) co
 	return mSprites.at(index);
 }
 
+uint32_t SpriteSheet::getSpritesCount() const
+{
+	return mSprites.size();
+}
+
 weak_ptr<const VertexArray> SpriteSheet::getVao() const
 {
 	if (mSprites.empty())
@@ -18,6 +18,7 @@ public:
 
 	std::weak_ptr<const class Texture> getTexture() const;
 	std::weak_ptr<const class Sprite> getSprite(std::uint32_t index) const;
+	std::uint32_t getSpritesCount() const;
 	std::weak_ptr<const class VertexArray> getVao() const;
 	std::weak_ptr<class VertexArray> getVao();
 	const glm::vec2& getBounds();
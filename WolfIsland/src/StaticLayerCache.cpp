@@ -0,0 +1,135 @@
+#include "StaticLayerCache.hpp"
+#include "Framebuffer.hpp"
+#include "Texture.hpp"
+#include "VertexArray.hpp"
+#include "VertexBuffer.hpp"
+#include "Renderer.hpp"
+#include "Board.hpp"
+#include "GameObject.hpp"
+#include "Application.hpp"
+#include <glm/gtx/transform.hpp>
+using namespace std;
+
+// Cells cached around the camera rectangle, scrolling within them doesn't render the cache
+static const glm::tvec2<int32_t> cachedMarginCells{ 4, 4 };
+
+// Sprites overlap neighbouring cells, static objects around the cache may reach into it
+static const glm::tvec2<int32_t> objectMarginCells{ 2, 2 };
+
+
+StaticLayerCache::StaticLayerCache()
+	: mMaxDimension{ 0 }, mValid{ false }, mFirst{ 0, 0 }, mLast{ -1, -1 }, mZoom{ 0.0f },
+	mStaticVersion{ 0 }, mCachedSprites{ 0 }
+{
+}
+
+StaticLayerCache::StaticLayerCache(shared_ptr<const SpriteArray> sprites, Renderer& renderer)
+	: mMaxDimension{ 0 }, mValid{ false }, mFirst{ 0, 0 }, mLast{ -1, -1 }, mZoom{ 0.0f },
+	mStaticVersion{ 0 }, mCachedSprites{ 0 }
+{
+	create(sprites, renderer);
+}
+
+void StaticLayerCache::create(shared_ptr<const SpriteArray> sprites, Renderer& renderer)
+{
+	mFramebuffer.reset();
+	mQuad = make_shared<VertexArray>(SpriteBatch::CreateQuad(renderer), renderer);
+	mBatch.create(sprites, renderer);
+	gl::GetIntegerv(gl::MAX_TEXTURE_SIZE, &mMaxDimension);
+	invalidate();
+}
+
+StaticLayerCache::~StaticLayerCache()
+{
+}
+
+bool StaticLayerCache::update(Board& board, const glm::tvec2<int32_t>& first,
+	const glm::tvec2<int32_t>& last, float zoom, Renderer& renderer)
+{
+	// Nothing is drawn outside of the board and its border
+	auto size = glm::tvec2<int32_t>{ board.getWidth(), board.getHeight() };
+	auto visibleFirst = glm::max(first, glm::tvec2<int32_t>{ -1, -1 });
+	auto visibleLast = glm::min(last, size);
+
+	if (mValid && zoom == mZoom && board.getStaticVersion() == mStaticVersion &&
+		visibleFirst.x >= mFirst.x && visibleFirst.y >= mFirst.y &&
+		visibleLast.x <= mLast.x && visibleLast.y <= mLast.y)
+		return false;
+
+	mFirst = glm::max(first - cachedMarginCells, glm::tvec2<int32_t>{ -1, -1 });
+	mLast = glm::min(last + cachedMarginCells, size);
+	mZoom = zoom;
+	mStaticVersion = board.getStaticVersion();
+	mValid = true;
+	mCachedSprites = 0;
+
+	auto cells = mLast - mFirst + 1;
+
+	if (cells.x <= 0 || cells.y <= 0)
+		return true;
+
+	// Texels match pixels of the screen, unless the driver can't make the texture that large
+	auto origin = glm::vec2{ mFirst } * Application::spriteSize;
+	auto end = glm::vec2{ mLast + 1 } * Application::spriteSize;
+	auto dimensions = glm::min(glm::tvec2<int32_t>{ glm::ceil((end - origin) * zoom) },
+		glm::tvec2<int32_t>{ mMaxDimension, mMaxDimension });
+
+	if (!mFramebuffer || mFramebuffer->getDimensions() != dimensions)
+		mFramebuffer = make_shared<Framebuffer>(dimensions, renderer);
+
+	static const GLfloat transparent[]{ 0.0f, 0.0f, 0.0f, 0.0f };
+
+	renderer.bindFramebuffer(*mFramebuffer);
+	gl::ClearBufferfv(gl::COLOR, 0, transparent);
+	renderer.bindOrthoMatrix(glm::ortho(origin.x, end.x, origin.y, end.y));
+
+	board.draw(renderer, mFirst, mLast);
+	mCachedSprites = board.getDrawnTiles();
+
+	mObjects.clear();
+	board.getObjects(mFirst - objectMarginCells, mLast + objectMarginCells, mObjects);
+
+	for (auto obj : mObjects)
+	{
+		if (obj->isStatic())
+			obj->draw(mBatch);
+	}
+
+	mBatch.flush(renderer);
+	mCachedSprites += mBatch.getInstancesCount();
+
+	renderer.flushQueue();
+	renderer.bindDefaultFramebuffer();
+	return true;
+}
+
+void StaticLayerCache::draw(Renderer& renderer)
+{
+	if (mCachedSprites == 0)
+		return;
+
+	auto origin = glm::vec2{ mFirst } * Application::spriteSize;
+	auto end = glm::vec2{ mLast + 1 } * Application::spriteSize;
+	auto transform = glm::translate(glm::vec3{ origin, 0.0f }) *
+		glm::scale(glm::vec3{ end - origin, 1.0f });
+	auto quad = mQuad;
+	auto texture = mFramebuffer->getTexture().lock();
+
+	renderer.submit(renderer.getQueueKey(RenderLayer::GROUND, Renderer::Program::SPRITE,
+		*texture, 0.0f), [quad, texture, transform](Renderer& renderer)
+		{
+			renderer.prepareDrawSprite();
+			renderer.drawTexture(*quad, *texture, transform);
+		});
+}
+
+void StaticLayerCache::invalidate()
+{
+	mValid = false;
+}
+
+uint32_t StaticLayerCache::getCachedSprites() const
+{
+	return mCachedSprites;
+}
+
@@ -0,0 +1,50 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "SpriteBatch.hpp"
+#include <glm/vec2.hpp>
+
+// Ground and static objects around the camera rendered into a framebuffer texture at
+// the camera zoom, and drawn as one quad every frame. The texture covers a margin of cells
+// around the camera rectangle. It's rendered again when the camera leaves it, the zoom
+// changes or the board adds or removes static objects.
+class StaticLayerCache
+{
+public:
+	StaticLayerCache();
+
+	StaticLayerCache(std::shared_ptr<const class SpriteArray> sprites, class Renderer& renderer);
+	void create(std::shared_ptr<const class SpriteArray> sprites, class Renderer& renderer);
+
+	~StaticLayerCache();
+
+	// Renders the cache when it doesn't cover cells inside the rectangle, corners included,
+	// and returns true if it did. Draws queued before are flushed with the cache, the ortho
+	// matrix has to be bound again afterwards.
+	bool update(class Board& board, const glm::tvec2<std::int32_t>& first,
+		const glm::tvec2<std::int32_t>& last, float zoom, class Renderer& renderer);
+
+	// Queues the cached texture on the ground layer
+	void draw(class Renderer& renderer);
+
+	// The next update renders the cache
+	void invalidate();
+
+	// Tiles and static objects in the cache
+	std::uint32_t getCachedSprites() const;
+
+private:
+	std::shared_ptr<class Framebuffer> mFramebuffer;
+	std::shared_ptr<class VertexArray> mQuad;
+	SpriteBatch mBatch;
+	std::vector<class GameObject*> mObjects;
+	std::int32_t mMaxDimension;
+
+	// Cells of the cache and what it was rendered for
+	bool mValid;
+	glm::tvec2<std::int32_t> mFirst;
+	glm::tvec2<std::int32_t> mLast;
+	float mZoom;
+	std::uint32_t mStaticVersion;
+	std::uint32_t mCachedSprites;
+};
+
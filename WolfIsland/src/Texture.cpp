@@ -36,6 +36,12 @@ Texture::Texture(std::vector<Image>& imgs, Renderer& renderer)
 	create(imgs, renderer);
 }
 
+Texture::Texture(uint32_t width, uint32_t height, Image::Format format, Renderer& renderer)
+	: mHasMipmap{ false }
+{
+	create(width, height, format, renderer);
+}
+
 void Texture::create(const Image& img, Renderer& renderer)
 {
 	GLint format;
@@ -57,6 +63,9 @@ void Texture::create(const Image& img, Renderer& renderer)
 	if (mID != 0) 
 		clear();
 	gl::GenTextures(1, &mID);
+
+	// Name of a deleted texture may be reused, the renderer could still see it as bound
+	renderer.resetTextureBindings();
 	mFormat = img.getFormat();
 	mSize = img.mBytes.size();
 
@@ -80,6 +89,32 @@ void Texture::create(const Image& img, Renderer& renderer)
 	}
 }
 
+void Texture::create(uint32_t width, uint32_t height, Image::Format format, Renderer& renderer)
+{
+	GLint imageFormat;
+	GLint internalFormat;
+	GLenum dataType;
+	GLenum compInternalFormat;
+
+	ParseFormat(format, imageFormat, internalFormat, dataType, compInternalFormat);
+
+	// Compressed formats can't be rendered to
+	if (internalFormat == 0 || compInternalFormat != 0)
+		return;
+
+	if (mID != 0)
+		clear();
+	gl::GenTextures(1, &mID);
+
+	renderer.resetTextureBindings();
+	mFormat = format;
+	mSize = width * height * Image::CalculateBytesPerPixel(format);
+	mType = Type::UNCOMPRESSED_2D;
+	renderer.bindTexture(*this, 0);
+	gl::TexImage2D(gl::TEXTURE_2D, 0, internalFormat, width, height, 0, imageFormat, dataType,
+		nullptr);
+}
+
 void Texture::create(std::vector<Image>& imgs, Renderer& renderer)
 {
 	if (imgs.empty())
@@ -108,6 +143,9 @@ void Texture::create(std::vector<Image>& imgs, Renderer& renderer)
 	if (mID != 0)
 		clear();
 	gl::GenTextures(1, &mID);
+
+	renderer.resetTextureBindings();
+	mFormat = imageFormat;
 	mSize = imgs[0].mBytes.size() * imgs.size();
 	bool isCompressed{ compInternalFormat != 0 };
 	mType = isCompressed ? Type::COMPRESSED_2D_ARRAY : Type::UNCOMPRESSED_2D_ARRAY;
@@ -144,10 +182,29 @@ void Texture::clear()
 	gl::DeleteTextures(1, &mID);
 }
 
+void Texture::update(uint32_t x, uint32_t y, uint32_t width, uint32_t height,
+	const uint8_t* bytes, Renderer& renderer)
+{
+	GLint format;
+	GLint internalFormat;
+	GLenum dataType;
+	GLenum compInternalFormat;
+
+	ParseFormat(mFormat, format, internalFormat, dataType, compInternalFormat);
+
+	if (mType != Type::UNCOMPRESSED_2D || format == 0)
+		return;
+
+	renderer.bindTexture(*this, 0);
+	gl::TexSubImage2D(gl::TEXTURE_2D, 0, x, y, width, height, format, dataType, bytes);
+}
+
 void Texture::generateMipmaps(Renderer & renderer)
 {
+	bool isArray = mType == Type::UNCOMPRESSED_2D_ARRAY || mType == Type::COMPRESSED_2D_ARRAY;
+
 	renderer.bindTexture(*this, 0);
-	gl::GenerateMipmap(gl::TEXTURE_2D);
+	gl::GenerateMipmap(isArray ? gl::TEXTURE_2D_ARRAY : gl::TEXTURE_2D);
 	mHasMipmap = true;
 }
 
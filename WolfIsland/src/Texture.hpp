@@ -26,6 +26,11 @@ public:
 	Texture(const Image& img, Renderer& renderer);
 	void create(const Image& img, Renderer& renderer);
 
+	// Create empty texture, used as a target of framebuffers
+	Texture(std::uint32_t width, std::uint32_t height, Image::Format format, Renderer& renderer);
+	void create(std::uint32_t width, std::uint32_t height, Image::Format format,
+		Renderer& renderer);
+
 	// Create texture array
 	// This functions needs to be reimlemented differently
 	Texture(std::vector<Image>& imgs, Renderer& renderer);
@@ -34,6 +39,10 @@ public:
 	~Texture();
 	void clear() override;
 
+	// Replaces texels of the rectangle of an uncompressed 2d texture, bytes hold its rows in order
+	void update(std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height,
+		const std::uint8_t* bytes, class Renderer& renderer);
+
 	void generateMipmaps(class Renderer& renderer);
 	Image::Format getFormat() const;
 	bool hasMipmap() const;
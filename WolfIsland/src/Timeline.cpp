@@ -0,0 +1,309 @@
+#include "Timeline.hpp"
+#include "Board.hpp"
+using namespace std;
+
+// Equal bytes ending a literal, shorter runs cost more than they save
+static const size_t minEqualRun{ 8 };
+
+// Captures queued while the job encodes older ones
+static const size_t maxPendingCaptures{ 4 };
+
+
+static void WriteSize(vector<uint8_t>& data, size_t size)
+{
+	auto value = static_cast<uint32_t>(size);
+	auto bytes = reinterpret_cast<const uint8_t*>(&value);
+	data.insert(end(data), bytes, bytes + sizeof(value));
+}
+
+static size_t ReadSize(const vector<uint8_t>& data, size_t& pos)
+{
+	uint32_t value;
+	copy_n(data.data() + pos, sizeof(value), reinterpret_cast<uint8_t*>(&value));
+	pos += sizeof(value);
+
+	return value;
+}
+
+
+TimelineOptions::TimelineOptions()
+	: keyframeInterval{ 16 }, memoryBudget{ 256 }
+{
+}
+
+
+Timeline::Timeline()
+	: mJobs{ nullptr }, mEncoding{ false }, mMemoryUsage{ 0 }, mPreviousTurn{ 0 }
+{
+}
+
+Timeline::Timeline(const TimelineOptions& options, JobSystem* jobs)
+	: mJobs{ nullptr }, mEncoding{ false }, mMemoryUsage{ 0 }, mPreviousTurn{ 0 }
+{
+	create(options, jobs);
+}
+
+void Timeline::create(const TimelineOptions& options, JobSystem* jobs)
+{
+	clear();
+	mOptions = options;
+	mOptions.keyframeInterval = max(mOptions.keyframeInterval, 1u);
+	mJobs = jobs;
+}
+
+Timeline::~Timeline()
+{
+	try
+	{
+		wait();
+	}
+	catch (...)
+	{
+	}
+}
+
+void Timeline::capture(shared_ptr<const WorldSnapshot> snapshot)
+{
+	// Without workers a queued job would run only when the timeline is read
+	if (!mJobs || mJobs->getWorkersCount() == 0)
+	{
+		snapshot->saveState(mState);
+		encode(snapshot->getTurn());
+		return;
+	}
+
+	lock_guard<mutex> lock{ mPendingMutex };
+
+	if (mPending.size() >= maxPendingCaptures)
+		mPending.pop_back();
+
+	mPending.push_back(move(snapshot));
+
+	// Turns are encoded in order, against the previous one, by a single job
+	if (!mEncoding)
+	{
+		mEncoding = true;
+		mEncodeJob = mJobs->add([this]() { encodePending(); });
+	}
+}
+
+bool Timeline::restore(uint32_t turn, Board& board)
+{
+	wait();
+	auto index = find(turn);
+
+	if (index == mEntries.size())
+		return false;
+
+	auto first = index;
+
+	while (!mEntries[first].keyframe)
+		first--;
+
+	vector<uint8_t> state;
+
+	for (auto i = first; i <= index; i++)
+		ApplyDelta(mEntries[i].data, state);
+
+	WorldSnapshot snapshot;
+	snapshot.loadState(state);
+	board.loadSnapshot(snapshot);
+	mPreviousState = move(state);
+	mPreviousTurn = turn;
+
+	return true;
+}
+
+bool Timeline::isEmpty() const
+{
+	wait();
+	return mEntries.empty();
+}
+
+uint32_t Timeline::getFirstTurn() const
+{
+	wait();
+	return mEntries.empty() ? 0 : mEntries.front().turn;
+}
+
+uint32_t Timeline::getLastTurn() const
+{
+	wait();
+	return mEntries.empty() ? 0 : mEntries.back().turn;
+}
+
+size_t Timeline::getMemoryUsage() const
+{
+	wait();
+	return mMemoryUsage;
+}
+
+void Timeline::clear()
+{
+	wait();
+	mEntries.clear();
+	mMemoryUsage = 0;
+	mPreviousState.clear();
+	mPreviousTurn = 0;
+}
+
+void Timeline::wait() const
+{
+	if (!mEncodeJob)
+		return;
+
+	auto job = mEncodeJob;
+	mEncodeJob.reset();
+	mJobs->wait(job);
+}
+
+void Timeline::encodePending()
+{
+	while (true)
+	{
+		shared_ptr<const WorldSnapshot> snapshot;
+
+		{
+			lock_guard<mutex> lock{ mPendingMutex };
+
+			if (mPending.empty())
+			{
+				mEncoding = false;
+				return;
+			}
+
+			snapshot = move(mPending.front());
+			mPending.pop_front();
+		}
+
+		snapshot->saveState(mState);
+		encode(snapshot->getTurn());
+	}
+}
+
+void Timeline::encode(uint32_t turn)
+{
+	Entry entry{ turn, false, {} };
+
+	// Turns from this one on were left by a board restored to an earlier turn
+	while (!mEntries.empty() && mEntries.back().turn >= turn)
+	{
+		mMemoryUsage -= mEntries.back().data.size();
+		mEntries.pop_back();
+	}
+
+	// Deltas need the previous turn to be the state they're made against
+	entry.keyframe = mEntries.empty() || mEntries.back().turn + 1 != turn ||
+		mPreviousState.empty() || mPreviousTurn + 1 != turn;
+
+	for (auto it = mEntries.rbegin(); !entry.keyframe; it++)
+	{
+		if (it->keyframe)
+		{
+			entry.keyframe = turn - it->turn >= mOptions.keyframeInterval;
+			break;
+		}
+	}
+
+	EncodeDelta(mState, entry.keyframe ? vector<uint8_t>{} : mPreviousState, entry.data);
+	swap(mPreviousState, mState);
+	mPreviousTurn = turn;
+
+	mMemoryUsage += entry.data.size();
+	mEntries.push_back(move(entry));
+
+	while (mMemoryUsage > (static_cast<size_t>(mOptions.memoryBudget) << 20))
+	{
+		// The newest keyframe and its deltas are always kept
+		if (none_of(begin(mEntries) + 1, end(mEntries), [](const Entry& e) { return e.keyframe; }))
+			break;
+
+		dropOldest();
+	}
+}
+
+void Timeline::dropOldest()
+{
+	do
+	{
+		mMemoryUsage -= mEntries.front().data.size();
+		mEntries.pop_front();
+	} while (!mEntries.empty() && !mEntries.front().keyframe);
+}
+
+size_t Timeline::find(uint32_t turn) const
+{
+	auto it = lower_bound(begin(mEntries), end(mEntries), turn,
+		[](const Entry& entry, uint32_t turn) { return entry.turn < turn; });
+
+	return it != end(mEntries) && it->turn == turn ? it - begin(mEntries) : mEntries.size();
+}
+
+void Timeline::EncodeDelta(const vector<uint8_t>& state, const vector<uint8_t>& previous,
+	vector<uint8_t>& delta)
+{
+	auto size = state.size();
+	auto common = min(size, previous.size());
+	auto differs = [&state, &previous](size_t i)
+	{
+		return state[i] != (i < previous.size() ? previous[i] : 0);
+	};
+
+	// First byte from the position which differs
+	auto findDifference = [&state, &previous, size, common](size_t i)
+	{
+		if (i < common)
+			i = mismatch(begin(state) + i, begin(state) + common, begin(previous) + i).first -
+				begin(state);
+
+		if (i >= common)
+			i = find_if(begin(state) + i, end(state), [](uint8_t b) { return b != 0; }) -
+				begin(state);
+
+		return i;
+	};
+
+	delta.clear();
+	WriteSize(delta, size);
+
+	for (size_t i = findDifference(0), equalStart = 0; i < size; i = findDifference(i))
+	{
+		// Literal ends before a long enough run of equal bytes
+		size_t literalEnd = i;
+
+		for (size_t j = i; j < size && j - literalEnd < minEqualRun; j++)
+		{
+			if (differs(j))
+				literalEnd = j + 1;
+		}
+
+		WriteSize(delta, i - equalStart);
+		WriteSize(delta, literalEnd - i);
+
+		for (; i < literalEnd; i++)
+			delta.push_back(state[i] ^ (i < previous.size() ? previous[i] : 0));
+
+		equalStart = literalEnd;
+	}
+}
+
+void Timeline::ApplyDelta(const vector<uint8_t>& delta, vector<uint8_t>& state)
+{
+	size_t pos = 0;
+
+	// Bytes past the end of the previous state start from 0, like they were encoded
+	state.resize(ReadSize(delta, pos));
+
+	for (size_t i = 0; pos < delta.size();)
+	{
+		i += ReadSize(delta, pos);
+		auto literal = ReadSize(delta, pos);
+
+		for (size_t k = 0; k < literal; k++)
+			state[i + k] ^= delta[pos + k];
+
+		i += literal;
+		pos += literal;
+	}
+}
+
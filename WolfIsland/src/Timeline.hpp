@@ -0,0 +1,91 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "JobSystem.hpp"
+#include "WorldSnapshot.hpp"
+
+
+// How much of the past a timeline keeps
+struct TimelineOptions
+{
+	TimelineOptions();
+
+	// Turns from one full snapshot to the next, turns between them are deltas
+	std::uint32_t keyframeInterval;
+
+	// Megabytes of encoded turns, groups of the oldest turns are dropped beyond it
+	std::uint32_t memoryBudget;
+};
+
+// Recent turns of a board, which can be restored in any order. Saved board states are
+// encoded as runs of bytes differing from the previous turn, with a full snapshot every
+// few turns. Saving and encoding of published snapshots run as a job while the board goes
+// on. Captures never wait for it, they're queued and the job encodes them in order. Other
+// calls wait until the queue is encoded.
+// Jobs have to outlive the timeline.
+class Timeline
+{
+public:
+	Timeline();
+
+	Timeline(const TimelineOptions& options, JobSystem* jobs = nullptr);
+	void create(const TimelineOptions& options, JobSystem* jobs = nullptr);
+
+	~Timeline();
+
+	// Keeps the board state after a turn. Kept turns from this one on are replaced, they were
+	// left by a board restored to an earlier turn. When encoding falls behind by a few turns,
+	// the newest queued turn is dropped for this one.
+	void capture(std::shared_ptr<const WorldSnapshot> snapshot);
+
+	// Puts the board back to the turn, returns false when the turn isn't kept
+	bool restore(std::uint32_t turn, class Board& board);
+
+	bool isEmpty() const;
+	std::uint32_t getFirstTurn() const;
+	std::uint32_t getLastTurn() const;
+
+	// Bytes of encoded turns
+	std::size_t getMemoryUsage() const;
+
+	void clear();
+
+private:
+	struct Entry
+	{
+		std::uint32_t turn;
+		bool keyframe;
+		std::vector<std::uint8_t> data;
+	};
+
+	TimelineOptions mOptions;
+	JobSystem* mJobs;
+	mutable JobHandle mEncodeJob;
+
+	// Snapshots waiting for the job, which runs while there are any
+	std::mutex mPendingMutex;
+	std::deque<std::shared_ptr<const WorldSnapshot>> mPending;
+	bool mEncoding;
+
+	std::deque<Entry> mEntries;
+	std::size_t mMemoryUsage;
+
+	// Captured state being encoded and the state deltas are made against, which is the last
+	// captured or restored turn
+	std::vector<std::uint8_t> mState;
+	std::vector<std::uint8_t> mPreviousState;
+	std::uint32_t mPreviousTurn;
+
+	void wait() const;
+	void encodePending();
+	void encode(std::uint32_t turn);
+	void dropOldest();
+	std::size_t find(std::uint32_t turn) const;
+
+	// Delta of a state from the previous one, bytes past the end of the previous one are
+	// compared with 0. Keyframes are deltas from an empty state.
+	static void EncodeDelta(const std::vector<std::uint8_t>& state,
+		const std::vector<std::uint8_t>& previous, std::vector<std::uint8_t>& delta);
+	static void ApplyDelta(const std::vector<std::uint8_t>& delta,
+		std::vector<std::uint8_t>& state);
+};
+
@@ -0,0 +1,43 @@
+#include "TurnProfile.hpp"
+using namespace std;
+
+static const array<const char*, TurnProfile::phasesCount> phaseNames{ {
+	"cleanup", "spawn", "flow_field", "move", "action", "mean_field",
+	"hare_automaton", "vegetation" } };
+
+
+TurnProfile::TurnProfile()
+	: turns{ 0 }
+{
+	seconds.fill(0.0);
+}
+
+void TurnProfile::clear()
+{
+	seconds.fill(0.0);
+	turns = 0;
+}
+
+void TurnProfile::add(TurnPhase phase, double phaseSeconds)
+{
+	seconds[static_cast<uint32_t>(phase)] += phaseSeconds;
+}
+
+void TurnProfile::add(const TurnProfile& other)
+{
+	for (uint32_t i = 0; i < phasesCount; i++)
+		seconds[i] += other.seconds[i];
+
+	turns += other.turns;
+}
+
+double TurnProfile::get(TurnPhase phase) const
+{
+	return seconds[static_cast<uint32_t>(phase)];
+}
+
+const char* TurnProfile::GetPhaseName(TurnPhase phase)
+{
+	return phaseNames[static_cast<uint32_t>(phase)];
+}
+
@@ -0,0 +1,34 @@
+#pragma once
+#include "Prerequisites.hpp"
+
+
+enum class TurnPhase
+{
+	CLEANUP,
+	SPAWN,
+	FLOW_FIELD,
+	MOVE,
+	ACTION,
+	MEAN_FIELD,
+	HARE_AUTOMATON,
+	VEGETATION
+};
+
+// Time spent in every phase of board turns
+struct TurnProfile
+{
+	TurnProfile();
+
+	static const std::uint32_t phasesCount{ 8 };
+
+	std::array<double, phasesCount> seconds;
+	std::uint32_t turns;
+
+	void clear();
+	void add(TurnPhase phase, double phaseSeconds);
+	void add(const TurnProfile& other);
+	double get(TurnPhase phase) const;
+
+	static const char* GetPhaseName(TurnPhase phase);
+};
+
@@ -0,0 +1,221 @@
+#include "VegetationField.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VEGETATION_AVX2
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace std;
+
+const float VegetationField::capacity{ 1.0f };
+
+
+// Both kernels evaluate the same operations in the same order, so they round the same way
+static inline float UpdateCell(float left, float right, float up, float down, float value,
+	float growth, float diffusion)
+{
+	float laplacian = ((left + right) + (up + down)) - value * 4.0f;
+	float next = value + diffusion * laplacian + growth * (VegetationField::capacity - value);
+
+	return min(max(next, 0.0f), VegetationField::capacity);
+}
+
+static void UpdateRowScalar(const float* up, const float* row, const float* down, float* out,
+	uint32_t first, uint32_t last, float growth, float diffusion)
+{
+	for (uint32_t x = first; x < last; x++)
+		out[x] = UpdateCell(row[x - 1], row[x + 1], up[x], down[x], row[x], growth, diffusion);
+}
+
+#ifdef VEGETATION_AVX2
+// Returns the first cell that wasn't updated
+AVX2_FUNCTION static uint32_t UpdateRowAvx2(const float* up, const float* row,
+	const float* down, float* out, uint32_t first, uint32_t last, float growth, float diffusion)
+{
+	const __m256 four = _mm256_set1_ps(4.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 full = _mm256_set1_ps(VegetationField::capacity);
+	const __m256 growthVec = _mm256_set1_ps(growth);
+	const __m256 diffusionVec = _mm256_set1_ps(diffusion);
+
+	uint32_t x = first;
+
+	for (; x + 8 <= last; x += 8)
+	{
+		__m256 value = _mm256_loadu_ps(row + x);
+		__m256 sides = _mm256_add_ps(_mm256_loadu_ps(row + x - 1), _mm256_loadu_ps(row + x + 1));
+		__m256 vertical = _mm256_add_ps(_mm256_loadu_ps(up + x), _mm256_loadu_ps(down + x));
+		__m256 laplacian = _mm256_sub_ps(_mm256_add_ps(sides, vertical),
+			_mm256_mul_ps(value, four));
+
+		__m256 next = _mm256_add_ps(_mm256_add_ps(value, _mm256_mul_ps(diffusionVec, laplacian)),
+			_mm256_mul_ps(growthVec, _mm256_sub_ps(full, value)));
+
+		_mm256_storeu_ps(out + x, _mm256_min_ps(_mm256_max_ps(next, zero), full));
+	}
+
+	return x;
+}
+#endif
+
+
+VegetationField::VegetationField()
+	: mWidth{ 0 }, mHeight{ 0 }, mSimdEnabled{ IsAvx2Supported() }
+{
+}
+
+VegetationField::VegetationField(uint32_t width, uint32_t height)
+	: mWidth{ 0 }, mHeight{ 0 }, mSimdEnabled{ IsAvx2Supported() }
+{
+	create(width, height);
+}
+
+void VegetationField::create(uint32_t width, uint32_t height)
+{
+	mWidth = width;
+	mHeight = height;
+	mValues.assign(width * height, capacity);
+	mNextValues.assign(width * height, capacity);
+	mDirtyChunks.markAll();
+}
+
+VegetationField::~VegetationField()
+{
+}
+
+void VegetationField::update(float growth, float diffusion)
+{
+	if (mWidth == 0 || mHeight == 0)
+		return;
+
+	for (uint32_t y = 0; y < mHeight; y++)
+	{
+		// Missing neighbours beyond borders are replaced by the cell itself
+		const float* row = mValues.data() + y * mWidth;
+		const float* up = y > 0 ? row - mWidth : row;
+		const float* down = y + 1 < mHeight ? row + mWidth : row;
+		float* out = mNextValues.data() + y * mWidth;
+
+		if (mWidth == 1)
+		{
+			out[0] = UpdateCell(row[0], row[0], up[0], down[0], row[0], growth, diffusion);
+
+			if (out[0] != row[0])
+				mDirtyChunks.mark(y);
+
+			continue;
+		}
+
+		out[0] = UpdateCell(row[0], row[1], up[0], down[0], row[0], growth, diffusion);
+		out[mWidth - 1] = UpdateCell(row[mWidth - 2], row[mWidth - 1], up[mWidth - 1],
+			down[mWidth - 1], row[mWidth - 1], growth, diffusion);
+
+		uint32_t x = 1;
+
+#ifdef VEGETATION_AVX2
+		if (mSimdEnabled)
+			x = UpdateRowAvx2(up, row, down, out, x, mWidth - 1, growth, diffusion);
+#endif
+
+		UpdateRowScalar(up, row, down, out, x, mWidth - 1, growth, diffusion);
+
+		// Cells left full stay the same, chunks of the row are marked when some cell changed
+		for (uint32_t x = 0, last; x < mWidth; x = last)
+		{
+			uint32_t i = y * mWidth + x;
+			last = min<uint32_t>(mWidth, x + ChunkedArray<float>::chunkSize -
+				i % ChunkedArray<float>::chunkSize);
+
+			if (!equal(out + x, out + last, row + x))
+				mDirtyChunks.mark(i);
+		}
+	}
+
+	swap(mValues, mNextValues);
+}
+
+float VegetationField::consume(const glm::tvec2<int32_t>& pos, float amount)
+{
+	if (pos.x < 0 || pos.y < 0 || pos.x >= static_cast<int32_t>(mWidth) ||
+		pos.y >= static_cast<int32_t>(mHeight))
+		return 0.0f;
+
+	float& value = mValues[pos.y * mWidth + pos.x];
+	float taken = min(value, amount);
+	value -= taken;
+
+	if (taken != 0.0f)
+		mDirtyChunks.mark(pos.y * mWidth + pos.x);
+
+	return taken;
+}
+
+void VegetationField::fill(const glm::tvec2<int32_t>& pos)
+{
+	if (pos.x >= 0 && pos.y >= 0 && pos.x < static_cast<int32_t>(mWidth) &&
+		pos.y < static_cast<int32_t>(mHeight))
+	{
+		mValues[pos.y * mWidth + pos.x] = capacity;
+		mDirtyChunks.mark(pos.y * mWidth + pos.x);
+	}
+}
+
+float VegetationField::get(const glm::tvec2<int32_t>& pos) const
+{
+	if (pos.x < 0 || pos.y < 0 || pos.x >= static_cast<int32_t>(mWidth) ||
+		pos.y >= static_cast<int32_t>(mHeight))
+		return 0.0f;
+
+	return mValues[pos.y * mWidth + pos.x];
+}
+
+vector<float>& VegetationField::getValues()
+{
+	return mValues;
+}
+
+const vector<float>& VegetationField::getValues() const
+{
+	return mValues;
+}
+
+DirtyChunks<float>& VegetationField::getDirtyChunks()
+{
+	return mDirtyChunks;
+}
+
+const DirtyChunks<float>& VegetationField::getDirtyChunks() const
+{
+	return mDirtyChunks;
+}
+
+void VegetationField::clearDirtyChunks()
+{
+	mDirtyChunks.clear();
+}
+
+uint32_t VegetationField::getWidth() const
+{
+	return mWidth;
+}
+
+uint32_t VegetationField::getHeight() const
+{
+	return mHeight;
+}
+
+void VegetationField::setSimdEnabled(bool enabled)
+{
+	mSimdEnabled = enabled && IsAvx2Supported();
+}
+
+bool VegetationField::isSimdEnabled() const
+{
+	return mSimdEnabled;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "ChunkedArray.hpp"
+#include <glm/vec2.hpp>
+
+
+// Amount of food in every cell, from 0 to capacity. Each turn food regrows towards
+// capacity and diffuses to the 4 neighbours, borders don't lose any food.
+// The stencil runs with AVX2 when the processor supports it, results are identical to
+// the scalar kernel.
+class VegetationField
+{
+public:
+	VegetationField();
+
+	VegetationField(std::uint32_t width, std::uint32_t height);
+	void create(std::uint32_t width, std::uint32_t height);
+
+	~VegetationField();
+
+	void update(float growth, float diffusion);
+
+	// Removes up to amount of food from the cell and returns how much was taken
+	float consume(const glm::tvec2<std::int32_t>& pos, float amount);
+	void fill(const glm::tvec2<std::int32_t>& pos);
+	float get(const glm::tvec2<std::int32_t>& pos) const;
+
+	// Row major values, width * height. Writes through the values have to be marked.
+	std::vector<float>& getValues();
+	const std::vector<float>& getValues() const;
+
+	// Values written since the chunks were cleared
+	DirtyChunks<float>& getDirtyChunks();
+	const DirtyChunks<float>& getDirtyChunks() const;
+	void clearDirtyChunks();
+	std::uint32_t getWidth() const;
+	std::uint32_t getHeight() const;
+
+	// Forces the scalar kernel, used to compare both paths
+	void setSimdEnabled(bool enabled);
+	bool isSimdEnabled() const;
+
+	static const float capacity;
+
+private:
+	std::uint32_t mWidth;
+	std::uint32_t mHeight;
+	bool mSimdEnabled;
+
+	std::vector<float> mValues;
+	std::vector<float> mNextValues;
+	DirtyChunks<float> mDirtyChunks;
+};
+
@@ -20,15 +20,24 @@ public:
 	VertexArray& operator=(VertexArray cas) = delete;
 	VertexArray& operator=(VertexArray&& rhs);
 	
+	// Attributes are specified once when the array is created, later the array is only bound.
+	// Instance buffers advance their attributes once per instance, starting at the position
+	// in bytes.
 	template <typename T>
 	VertexArray(std::shared_ptr<VertexBuffer<T>> buffer, Renderer& renderer);
 	template <typename T>
 	void create(std::shared_ptr<VertexBuffer<T>> buffer, Renderer& renderer);
 
-	~VertexArray();
+	template <typename T, typename U>
+	VertexArray(std::shared_ptr<VertexBuffer<T>> buffer,
+		std::shared_ptr<VertexBuffer<U>> instanceBuffer, Renderer& renderer,
+		std::uint32_t instancePosition = 0);
+	template <typename T, typename U>
+	void create(std::shared_ptr<VertexBuffer<T>> buffer,
+		std::shared_ptr<VertexBuffer<U>> instanceBuffer, Renderer& renderer,
+		std::uint32_t instancePosition = 0);
 
-	template <typename T>
-	void addInstanceBuffer(std::shared_ptr<VertexBuffer<T>> buffer, Renderer& renderer);
+	~VertexArray();
 
 	std::weak_ptr<GpuBuffer> getBuffer();
 	std::weak_ptr<GpuBuffer> getInstanceBuffer();
@@ -43,6 +52,10 @@ private:
 	std::uint32_t mVertexAttribCount;
 	std::uint32_t mInstanceAttribCount;
 
+	// Specifies attributes of the bound array from the first index, returns their count
+	template <typename T>
+	static std::uint32_t SetAttributes(VertexBuffer<T>& buffer, std::uint32_t first,
+		std::uint32_t divisor, std::uint32_t position, Renderer& renderer);
 };
 
 
@@ -57,42 +70,46 @@ template <typename T>
 void VertexArray::create(std::shared_ptr<VertexBuffer<T>> buffer, Renderer& renderer)
 {
 	mBuffer = std::dynamic_pointer_cast<GpuBuffer>(buffer);
+	mInstanceBuffer.reset();
 
 	gl::GenVertexArrays(1, &mID);
-	T layout;
-	renderer.bindVertexArray(*this);
-	renderer.bindBuffer(*buffer);
-	std::uint32_t i = 0;
-
-	for (auto it : layout.getFormats())
-	{
-		if (it.empty)
-			gl::DisableVertexAttribArray(i);
-		else
-		{
-			gl::EnableVertexAttribArray(i);
-			gl::VertexAttribPointer(i, it.size, it.type, it.normalized, it.stride,
-				reinterpret_cast<void*>(it.pointer));
-		}
 
-		i++;
-	}
+	// Name of a deleted array may be reused, the renderer could still see it as bound
+	renderer.resetVertexArrayBinding();
+	renderer.bindVertexArray(*this);
 
-	mVertexAttribCount = i;
+	mVertexAttribCount = SetAttributes(*buffer, 0, 0, 0, renderer);
+	mInstanceAttribCount = 0;
 }
 
-template<typename T>
-inline void VertexArray::addInstanceBuffer(std::shared_ptr<VertexBuffer<T>> buffer, 
-	Renderer& renderer)
+template <typename T, typename U>
+VertexArray::VertexArray(std::shared_ptr<VertexBuffer<T>> buffer,
+	std::shared_ptr<VertexBuffer<U>> instanceBuffer, Renderer& renderer,
+	std::uint32_t instancePosition)
+	: mVertexAttribCount{ 0 }, mInstanceAttribCount{ 0 }
 {
-	mInstanceBuffer = std::dynamic_pointer_cast<GpuBuffer>(buffer);
+	create(buffer, instanceBuffer, renderer, instancePosition);
+}
 
-	T layout;
-	renderer.bindVertexArray(*this);
-	renderer.bindBuffer(*buffer);
+template <typename T, typename U>
+void VertexArray::create(std::shared_ptr<VertexBuffer<T>> buffer,
+	std::shared_ptr<VertexBuffer<U>> instanceBuffer, Renderer& renderer,
+	std::uint32_t instancePosition)
+{
+	create(buffer, renderer);
 
-	std::uint32_t i = mVertexAttribCount;
+	mInstanceBuffer = std::dynamic_pointer_cast<GpuBuffer>(instanceBuffer);
+	mInstanceAttribCount = SetAttributes(*instanceBuffer, mVertexAttribCount, 1,
+		instancePosition, renderer);
+}
 
+template <typename T>
+std::uint32_t VertexArray::SetAttributes(VertexBuffer<T>& buffer, std::uint32_t first,
+	std::uint32_t divisor, std::uint32_t position, Renderer& renderer)
+{
+	T layout;
+	renderer.bindBuffer(buffer);
+	std::uint32_t i = first;
 
 	for (auto it : layout.getFormats())
 	{
@@ -102,12 +119,13 @@ inline void VertexArray::addInstanceBuffer(std::shared_ptr<VertexBuffer<T>> buff
 		{
 			gl::EnableVertexAttribArray(i);
 			gl::VertexAttribPointer(i, it.size, it.type, it.normalized, it.stride,
-				reinterpret_cast<void*>(it.pointer));
-			gl::VertexAttribDivisor(i, 1);
+				reinterpret_cast<void*>(position + it.pointer));
+			gl::VertexAttribDivisor(i, divisor);
 		}
 
 		i++;
 	}
-	mInstanceAttribCount = i - mVertexAttribCount;
+
+	return i - first;
 }
 
@@ -4,6 +4,15 @@
 #include "VertexLayout.hpp"
 #include "Renderer.hpp"
 
+// Static buffers are written once, dynamic ones now and then. Stream buffers are rings of
+// regions written every frame.
+enum class VertexBufferUsage
+{
+	STATIC,
+	DYNAMIC,
+	STREAM
+};
+
 template <typename T>
 class VertexBuffer : public GpuBuffer
 {
@@ -17,8 +26,11 @@ public:
 	VertexBuffer<T>& operator=(VertexBuffer<T> cas) = delete;
 	VertexBuffer<T>& operator=(VertexBuffer<T>&& rhs);
 
-	VertexBuffer(std::uint32_t elements, Renderer &renderer, bool dynamic = false);
-	void create(std::uint32_t elements, Renderer &renderer, bool dynamic = false);
+	// Stream buffers hold the elements in each of their regions
+	VertexBuffer(std::uint32_t elements, Renderer &renderer,
+		VertexBufferUsage usage = VertexBufferUsage::STATIC);
+	void create(std::uint32_t elements, Renderer &renderer,
+		VertexBufferUsage usage = VertexBufferUsage::STATIC);
 
 	~VertexBuffer();
 	void clear() override;
@@ -34,23 +46,54 @@ public:
 	std::uint32_t add(std::vector<typename T::Data>&& rhsData, std::uint32_t position,
 		Renderer& renderer);
 
+	// Regions of stream buffers, a region is written once in a few frames, so the gpu
+	// has finished reading it by then
+	static const std::uint32_t streamRegions{ 3 };
+
+	// Writes elements to the next region without any synchronization and returns its index.
+	// Elements beyond the region aren't written. When the gpu still reads the region,
+	// the buffer is orphaned instead of waiting for it.
+	std::uint32_t stream(const std::vector<typename T::Data>& data, Renderer& renderer);
+
+	// Fences the last streamed region, called after draws reading the region were made
+	void fence();
+
+	// Position of the region in bytes
+	std::uint32_t getRegionPosition(std::uint32_t region) const;
+
+	// Times the stream buffer was orphaned
+	std::uint32_t getOrphansCount() const;
+
 private:
 	std::uint32_t mPosition;
 	std::uint32_t mElements;
+	VertexBufferUsage mUsage;
+	std::uint32_t mRegion;
+	std::array<GLsync, streamRegions> mFences;
+	std::uint32_t mOrphansCount;
+
+	void deleteFences();
 };
 
 template<typename T>
 inline VertexBuffer<T>::VertexBuffer()
-	: GpuBuffer(GpuBufferType::VERTEX_BUFFER), mPosition{ 0 }
+	: GpuBuffer(GpuBufferType::VERTEX_BUFFER), mPosition{ 0 }, mElements{ 0 },
+	mUsage{ VertexBufferUsage::STATIC }, mRegion{ 0 }, mFences{}, mOrphansCount{ 0 }
 {
 	static_assert(std::is_base_of<VertexLayout, T>(), "VertexBuffer must operate on VertexLayout");
 }
 
 template<typename T>
 inline VertexBuffer<T>::VertexBuffer(VertexBuffer<T>&& rhs)
-	: GpuBuffer(move(rhs))
+	: GpuBuffer(move(rhs)), mPosition{ 0 }, mElements{ 0 }, mUsage{ VertexBufferUsage::STATIC },
+	mRegion{ 0 }, mFences{}, mOrphansCount{ 0 }
 {
 	swap(mPosition, rhs.mPosition);
+	swap(mElements, rhs.mElements);
+	swap(mUsage, rhs.mUsage);
+	swap(mRegion, rhs.mRegion);
+	swap(mFences, rhs.mFences);
+	swap(mOrphansCount, rhs.mOrphansCount);
 }
 
 template<typename T>
@@ -58,30 +101,56 @@ inline VertexBuffer<T>& VertexBuffer<T>::operator=(VertexBuffer<T>&& rhs)
 {
 	GpuBuffer::operator=(move(rhs));
 	swap(mPosition, rhs.mPosition);
+	swap(mElements, rhs.mElements);
+	swap(mUsage, rhs.mUsage);
+	swap(mRegion, rhs.mRegion);
+	swap(mFences, rhs.mFences);
+	swap(mOrphansCount, rhs.mOrphansCount);
 	return *this;
 }
 
 template<typename T>
-inline VertexBuffer<T>::VertexBuffer(std::uint32_t elements, Renderer& renderer, bool dynamic)
-	: GpuBuffer(GpuBufferType::VERTEX_BUFFER), mPosition{ 0 }
+inline VertexBuffer<T>::VertexBuffer(std::uint32_t elements, Renderer& renderer,
+	VertexBufferUsage usage)
+	: GpuBuffer(GpuBufferType::VERTEX_BUFFER), mPosition{ 0 }, mElements{ 0 },
+	mUsage{ VertexBufferUsage::STATIC }, mRegion{ 0 }, mFences{}, mOrphansCount{ 0 }
 {
 	static_assert(std::is_base_of<VertexLayout, T>(), "VertexBuffer must operate on VertexLayout");
-	create(elements, renderer, dynamic);
+	create(elements, renderer, usage);
 }
 
 template<typename T>
-inline void VertexBuffer<T>::create(std::uint32_t elements, Renderer& renderer, bool dynamic)
+inline void VertexBuffer<T>::create(std::uint32_t elements, Renderer& renderer,
+	VertexBufferUsage usage)
 {
 	gl::GenBuffers(1, &mID);
 	renderer.bindBuffer(*this);
 	mElements = elements;
-	gl::BufferData(gl::ARRAY_BUFFER, elements * T::Size(), nullptr, 
-		dynamic ? gl::DYNAMIC_DRAW : gl::STATIC_DRAW);
+	mUsage = usage;
+	mRegion = streamRegions - 1;
+	deleteFences();
+
+	switch (usage)
+	{
+	case VertexBufferUsage::STATIC:
+		gl::BufferData(gl::ARRAY_BUFFER, elements * T::Size(), nullptr, gl::STATIC_DRAW);
+		break;
+
+	case VertexBufferUsage::DYNAMIC:
+		gl::BufferData(gl::ARRAY_BUFFER, elements * T::Size(), nullptr, gl::DYNAMIC_DRAW);
+		break;
+
+	case VertexBufferUsage::STREAM:
+		gl::BufferData(gl::ARRAY_BUFFER, streamRegions * elements * T::Size(), nullptr,
+			gl::STREAM_DRAW);
+		break;
+	}
 }
 
 template<typename T>
 inline VertexBuffer<T>::~VertexBuffer()
 {
+	deleteFences();
 	gl::DeleteBuffers(1, &mID);
 }
 
@@ -155,5 +224,73 @@ inline std::uint32_t VertexBuffer<T>::add(std::vector<typename T::Data>&& rhsDat
 	return position;
 }
 
+template<typename T>
+inline std::uint32_t VertexBuffer<T>::stream(const std::vector<typename T::Data>& data,
+	Renderer& renderer)
+{
+	mRegion = (mRegion + 1) % streamRegions;
+	renderer.bindBuffer(*this);
+
+	// Region is normally signaled long ago, polling doesn't wait
+	if (mFences[mRegion] && gl::ClientWaitSync(mFences[mRegion], 0, 0) == gl::TIMEOUT_EXPIRED)
+	{
+		renderer.orphanBuffer(streamRegions * mElements * T::Size());
+		deleteFences();
+		mOrphansCount++;
+	}
+	else if (mFences[mRegion])
+	{
+		gl::DeleteSync(mFences[mRegion]);
+		mFences[mRegion] = nullptr;
+	}
+
+	auto bytes = std::min<std::uint32_t>(data.size(), mElements) * T::Size();
+
+	if (bytes == 0)
+		return mRegion;
+
+	auto target = gl::MapBufferRange(gl::ARRAY_BUFFER, getRegionPosition(mRegion), bytes,
+		gl::MAP_WRITE_BIT | gl::MAP_INVALIDATE_RANGE_BIT | gl::MAP_UNSYNCHRONIZED_BIT);
 
+	if (target)
+	{
+		auto source = reinterpret_cast<const std::uint8_t*>(data.data());
+		std::copy(source, source + bytes, static_cast<std::uint8_t*>(target));
+		gl::UnmapBuffer(gl::ARRAY_BUFFER);
+	}
 
+	return mRegion;
+}
+
+template<typename T>
+inline void VertexBuffer<T>::fence()
+{
+	if (mFences[mRegion])
+		gl::DeleteSync(mFences[mRegion]);
+
+	mFences[mRegion] = gl::FenceSync(gl::SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+template<typename T>
+inline std::uint32_t VertexBuffer<T>::getRegionPosition(std::uint32_t region) const
+{
+	return region * mElements * T::Size();
+}
+
+template<typename T>
+inline std::uint32_t VertexBuffer<T>::getOrphansCount() const
+{
+	return mOrphansCount;
+}
+
+template<typename T>
+inline void VertexBuffer<T>::deleteFences()
+{
+	for (auto& fence : mFences)
+	{
+		if (fence)
+			gl::DeleteSync(fence);
+
+		fence = nullptr;
+	}
+}
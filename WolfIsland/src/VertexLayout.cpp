@@ -129,3 +129,64 @@ std::uint32_t PositionVertexLayout::Size()
 {
 	return sizeof(Data);
 }
+
+SpriteInstanceVertexLayout::Data::Data()
+{
+}
+
+SpriteInstanceVertexLayout::Data::Data(float x, float y, float z, float width, float height,
+	float u0, float v0, float u1, float v1, float layer)
+	: x{ x }, y{ y }, z{ z }, width{ width }, height{ height }, u0{ u0 }, v0{ v0 }, u1{ u1 },
+	v1{ v1 }, layer{ layer }
+{
+}
+
+SpriteInstanceVertexLayout::SpriteInstanceVertexLayout()
+{
+	mFormats = {
+		VertexFormat{ 3, gl::FLOAT, gl::FALSE_, static_cast<GLsizei>(Size()), offsetof(Data, x) },
+		VertexFormat{ 2, gl::FLOAT, gl::FALSE_, static_cast<GLsizei>(Size()),
+			offsetof(Data, width) },
+		VertexFormat{ 4, gl::FLOAT, gl::FALSE_, static_cast<GLsizei>(Size()), offsetof(Data, u0) },
+		VertexFormat{ 1, gl::FLOAT, gl::FALSE_, static_cast<GLsizei>(Size()),
+			offsetof(Data, layer) }
+	};
+}
+
+SpriteInstanceVertexLayout::~SpriteInstanceVertexLayout()
+{
+}
+
+uint32_t SpriteInstanceVertexLayout::Size()
+{
+	return sizeof(Data);
+}
+
+AnimatedInstanceVertexLayout::Data::Data()
+{
+}
+
+AnimatedInstanceVertexLayout::Data::Data(float x0, float y0, float x1, float y1, float duration,
+	float moveClip, float idleClip)
+	: x0{ x0 }, y0{ y0 }, x1{ x1 }, y1{ y1 }, duration{ duration }, moveClip{ moveClip },
+	idleClip{ idleClip }
+{
+}
+
+AnimatedInstanceVertexLayout::AnimatedInstanceVertexLayout()
+{
+	mFormats = {
+		VertexFormat{ 4, gl::FLOAT, gl::FALSE_, static_cast<GLsizei>(Size()), offsetof(Data, x0) },
+		VertexFormat{ 3, gl::FLOAT, gl::FALSE_, static_cast<GLsizei>(Size()),
+			offsetof(Data, duration) }
+	};
+}
+
+AnimatedInstanceVertexLayout::~AnimatedInstanceVertexLayout()
+{
+}
+
+uint32_t AnimatedInstanceVertexLayout::Size()
+{
+	return sizeof(Data);
+}
@@ -99,3 +99,48 @@ public:
 	static std::uint32_t Size();
 };
 
+// Instance of a sprite from a layer of a texture array, drawn as a unit quad scaled to the
+// sprite size
+class SpriteInstanceVertexLayout : public VertexLayout
+{
+public:
+	struct Data
+	{
+		float x, y, z;
+		float width, height;
+		float u0, v0, u1, v1;
+		float layer;
+
+		Data();
+		Data(float x, float y, float z, float width, float height, float u0, float v0,
+			float u1, float v1, float layer);
+	};
+
+	SpriteInstanceVertexLayout();
+	~SpriteInstanceVertexLayout();
+
+	static std::uint32_t Size();
+};
+
+// Instance of a sprite moving between two positions during the transition, the shader picks
+// frames of its move clip and of its idle clip after the transition
+class AnimatedInstanceVertexLayout : public VertexLayout
+{
+public:
+	struct Data
+	{
+		float x0, y0, x1, y1;
+		float duration;
+		float moveClip, idleClip;
+
+		Data();
+		Data(float x0, float y0, float x1, float y1, float duration, float moveClip,
+			float idleClip);
+	};
+
+	AnimatedInstanceVertexLayout();
+	~AnimatedInstanceVertexLayout();
+
+	static std::uint32_t Size();
+};
+
@@ -3,34 +3,32 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/vec3.hpp>
 #include "Renderer.hpp"
+#include "AnimatedObjectLayer.hpp"
 #include "Application.hpp"
 #include "Hare.hpp"
 #include "Board.hpp"
 using namespace std;
 
-static const float transitionTime{ 1.0f };
 static const string objectType{ "wolf_female" };
-static const uint32_t pupTourTime{ 5 };
-static const float fatLoss{ 0.05f };
 static const float corpseTime{ 5.0f };
 
 
 WolfFemale::WolfFemale()
-	: GameObject{}, mTransitionTimer { 1.0f }, mChaseHare{ false }, mFat{ 1.0f }, 
-	mPupTourTimer{ pupTourTime }, mCorpseTimer{ corpseTime }
+	: GameObject{}, mTransitionTime{ 1.0f }, mChaseHare{ false }, mFat{ 1.0f }, 
+	mPupTourTimer{ 0 }, mCorpseTimer{ corpseTime }
 {
 	mType = objectType;
 }
 
-WolfFemale::WolfFemale(shared_ptr<SpriteSheet> spriteSheet)
-	: GameObject{}, mTransitionTimer { 1.0f }, mChaseHare{ false }, mFat{ 1.0f }, 
-	mPupTourTimer{ pupTourTime }, mCorpseTimer{ corpseTime }
+WolfFemale::WolfFemale(shared_ptr<SpriteSheet> spriteSheet, Board& board)
+	: GameObject{}, mTransitionTime{ 1.0f }, mChaseHare{ false }, mFat{ 1.0f }, 
+	mPupTourTimer{ 0 }, mCorpseTimer{ corpseTime }
 {
 	mType = objectType;
-	create(spriteSheet);
+	create(spriteSheet, board);
 }
 
-void WolfFemale::create(shared_ptr<SpriteSheet> spriteSheet)
+void WolfFemale::create(shared_ptr<SpriteSheet> spriteSheet, Board& board)
 {
 	// Move forward
 	mAnimations[0].create(spriteSheet, { 0, 1 }, 0.5);
@@ -65,7 +63,15 @@ void WolfFemale::create(shared_ptr<SpriteSheet> spriteSheet)
 
 	mCurrentAnimation = 4;
 	mCurrentIdle = 4;
-	mAnimations[4].start();
+
+	auto& parameters = board.getParameters();
+	mTransitionTime = parameters.wolfTransitionTime;
+	mPupTourTimer = parameters.pupTourTime;
+
+	// Objects are created during turns, so draws come from the turn's stream
+	float disorder = Application::spriteSize / 4.0f;
+	mRandomDisorder = glm::vec2{ board.getRandom().nextReal() * disorder - disorder,
+		board.getRandom().nextReal() * disorder };
 
 	mActive = true;
 }
@@ -75,120 +81,98 @@ WolfFemale::~WolfFemale()
 }
 
 
-const glm::vec2& WolfFemale::getRealPos()
+void WolfFemale::draw(AnimatedObjectLayer& layer) const
 {
-	return mRealPos;
-}
+	// Objects move from positions saved at the start of the turn, corpses stay where they died
+	auto to = glm::vec2{ mPos } * Application::spriteSize + mRandomDisorder;
+	auto from = mActive ? glm::vec2{ mSavedPos } * Application::spriteSize + mRandomDisorder : to;
+	auto move = from != to ? mCurrentAnimation : mCurrentIdle;
 
-void WolfFemale::draw(Renderer& renderer) const
-{
-	auto pos = mRealPos + mRandomDisorder;
-
-	renderer.prepareDrawSprite();
-	renderer.drawSprite(*(mAnimations[mCurrentAnimation].getCurrentSprite().lock()),
-		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	layer.add(mAnimations[move], mAnimations[mCurrentIdle], from, to, mTransitionTime);
 }
 
 void WolfFemale::updateMove(Board& board)
 {
-	glm::tvec2<int32_t> maxPos{ board.getWidth() - 1, board.getHeight() - 1 };
-	auto surrObjects{ board.getSurroundingObjects(mPos) };
-	vector<glm::tvec2<int32_t>> movePosVec;
-	int harePos = -1;
-	int wolfFemalePos = -1;
+	auto neighbourhood = board.getNeighbourhood(mPos);
+	auto blocked = neighbourhood.boulders | neighbourhood.bushes;
+	auto passable = neighbourhood.inside & ~blocked;
 
-	for (int i = -1; i <= 1; i++)
-	{
-		for (int j = -1; j <= 1; j++)
-		{
-			auto movePos{ mPos + glm::tvec2<int32_t>{i, j} };
+	// Can't move.
+	if (passable == 0)
+		return;
 
+	// Cells are scanned in order, a blocked cell makes the wolf forget what it saw before
+	auto seen = passable & Neighbourhood::GetCellsAfter(Neighbourhood::GetLast(blocked));
+	auto hareCell = Neighbourhood::GetLast(neighbourhood.hares & seen);
 
-			if (movePos.x < 0 || movePos.y < 0 || movePos.x > maxPos.x || movePos.y > maxPos.y)
-				continue;
+	// Hares out of sight are chased along the flow field, neighbours keep the rules above
+	auto pursuitRange = board.getParameters().pursuitRange;
+	auto hareDistance = pursuitRange > 0 && board.isHareFieldCurrent() ?
+		board.getHareField().getDistance(mPos) : FlowField::unreachable;
+	bool pursue = hareDistance > 1 && hareDistance <= pursuitRange;
 
-			bool canMove = true;
+	// Hare which escaped the last chase is followed while it's in pursuit range
+	int32_t targetCell = -1;
+	auto target = board.getObject(mTargetHare);
 
-			for (auto& obj : surrObjects)
-			{
-				if (obj->getSavedPos() == movePos)
-				{
-					if (obj->getObjectType() == "boulder" || obj->getObjectType() == "bush")
-					{
-						canMove = false;
-						harePos = -1;
-						break;
-					}
-					else if (obj->getObjectType() == "hare")
-						harePos = movePosVec.size();
-				}
-			}
+	if (!target || !target->isActive())
+		mTargetHare = EntityHandle{};
+	else if (pursuitRange > 0)
+	{
+		auto offset = target->getSavedPos() - mPos;
 
-			if (canMove)
-				movePosVec.push_back(movePos);
+		if (static_cast<uint32_t>(max(abs(offset.x), abs(offset.y))) <= pursuitRange)
+		{
+			auto cell = Neighbourhood::GetCell({ (offset.x > 0) - (offset.x < 0),
+				(offset.y > 0) - (offset.y < 0) });
+
+			if (passable & (1 << cell))
+				targetCell = cell;
 		}
 	}
 
-	// Can't move.
-	if (movePosVec.size() == 0)
-		return;
-
-	uniform_int_distribution<int32_t> dist{ 0, static_cast<int32_t>(movePosVec.size() - 1) };
-
-
-	mTransitionStartPos = glm::vec2{ mPos.x * Application::spriteSize,
-		mPos.y * Application::spriteSize };
-	mTransitionTimer = 0.0f;
 
 	glm::tvec2<int32_t> newPos;
 
-	if (harePos != -1)
+	if (hareCell != -1)
 	{
-		newPos = movePosVec.at(harePos);
+		newPos = mPos + Neighbourhood::GetOffset(hareCell);
 		mChaseHare = true;
+		mTargetHare = neighbourhood.hareHandles[hareCell];
 	}
+	else if (targetCell != -1)
+		newPos = mPos + Neighbourhood::GetOffset(targetCell);
+	else if (pursue)
+		newPos = mPos + board.getHareField().getStep(mPos);
 	else
-		newPos = movePosVec.at(dist(Application::randomDev));
+		newPos = mPos + Neighbourhood::GetOffset(Neighbourhood::Select(passable,
+			board.getRandom().next(Neighbourhood::GetCount(passable))));
 
 	// Avoid animation change
 	if (newPos == mPos)
 		return;
 
-	mPos = newPos;
-
 	// Animation controling
-	auto direction = glm::vec2{ mPos.x * Application::spriteSize,
-		mPos.y * Application::spriteSize } -mTransitionStartPos;
+	auto direction = newPos - mPos;
+	mPos = newPos;
 
-	if (direction.x < 0.0f)
+	if (direction.x < 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[2].reset();
-		mAnimations[2].start();
 		mCurrentAnimation = 2;
 		mCurrentIdle = 6;
 	}
-	else if (direction.x > 0.0f)
+	else if (direction.x > 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[3].reset();
-		mAnimations[3].start();
 		mCurrentAnimation = 3;
 		mCurrentIdle = 7;
 	}
-	else if (direction.y < 0.0f)
+	else if (direction.y < 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[0].reset();
-		mAnimations[0].start();
 		mCurrentAnimation = 0;
 		mCurrentIdle = 4;
 	}
-	else if (direction.y > 0.0f)
+	else if (direction.y > 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[1].reset();
-		mAnimations[1].start();
 		mCurrentAnimation = 1;
 		mCurrentIdle = 5;
 	}
@@ -196,16 +180,23 @@ void WolfFemale::updateMove(Board& board)
 
 void WolfFemale::updateAction(Board& board)
 {
-	for (auto& obj : board.getObjects(mPos))
+	float fatLoss = board.getParameters().fatLoss;
+	bool hareFound = false;
+
+	for (auto handle : board.getObjects(mPos))
 	{
+		auto obj = board.getObject(handle);
+
 		if (obj->getObjectType() == "hare")
 		{
-			auto hare = dynamic_pointer_cast<Hare>(obj);
+			auto hare = dynamic_cast<Hare*>(obj);
+			hareFound = true;
 			
 			if (!hare->isEaten())
 			{
 				hare->setEaten(true);
 				mChaseHare = false;
+				mTargetHare = EntityHandle{};
 				mFat = 1.0f;
 				mCurrentIdle = 8;
 			}
@@ -214,6 +205,14 @@ void WolfFemale::updateAction(Board& board)
 			mFat -= fatLoss;
 	}
 
+	if (!hareFound && board.eatCountedHare(mPos))
+	{
+		mChaseHare = false;
+		mTargetHare = EntityHandle{};
+		mFat = 1.0f;
+		mCurrentIdle = 8;
+	}
+
 	mFat -= fatLoss;
 
 	if (mFat <= 0.0f)
@@ -231,51 +230,47 @@ void WolfFemale::updateAction(Board& board)
 void WolfFemale::update(float deltaTime)
 {
 	if (mActive)
-	{
-		if (mTransitionTimer < transitionTime)
-		{
-			glm::vec2 transitionEndPos{ mPos.x * Application::spriteSize,
-				mPos.y * Application::spriteSize };
-
-			mRealPos = glm::mix(mTransitionStartPos, transitionEndPos,
-				mTransitionTimer / transitionTime);
-
-			mTransitionTimer += deltaTime;
-
-			if (mTransitionTimer >= transitionTime)
-			{
-				mAnimations[mCurrentAnimation].stop();
-				mAnimations[mCurrentIdle].start();
-				mCurrentAnimation = mCurrentIdle;
-			}
-		}
-	}
-	else
-	{
-		if (mCurrentAnimation != mCurrentIdle)
-		{
-			mAnimations[mCurrentAnimation].stop();
-			mAnimations[mCurrentIdle].start();
-			mCurrentAnimation = mCurrentIdle;
-		}
-
-		if (mCorpseTimer <= 0.0f)
-			mReadyToDelete = true;
+		return;
 
-		mCorpseTimer -= deltaTime;
-	}
+	if (mCorpseTimer <= 0.0f)
+		mReadyToDelete = true;
 
-	mAnimations[mCurrentAnimation].update(deltaTime);
+	mCorpseTimer -= deltaTime;
 }
 
 void WolfFemale::setPos(const glm::tvec2<std::int32_t>& pos)
 {
 	mPos = pos;
-	mRealPos = glm::vec2{ pos.x * Application::spriteSize, pos.y * Application::spriteSize };
 
-	uniform_real_distribution<float> dist{ 0.0f, Application::spriteSize / 4.0f };
-	mRandomDisorder = glm::vec2{ dist(Application::randomDev) - Application::spriteSize / 4.0f,
-		dist(Application::randomDev) };
+	// Placed objects rest until their next move
+	mSavedPos = pos;
+}
+
+void WolfFemale::saveState(ObjectState& state) const
+{
+	GameObject::saveState(state);
+	state.flags |= mChaseHare ? ObjectState::chaseHare : 0;
+	state.disorder = mRandomDisorder;
+	state.idle = mCurrentIdle;
+	state.tourTimer = mPupTourTimer;
+	state.fat = mFat;
+	state.corpseTimer = mCorpseTimer;
+	state.target = mTargetHare;
+}
+
+void WolfFemale::loadState(const ObjectState& state)
+{
+	GameObject::loadState(state);
+	mChaseHare = (state.flags & ObjectState::chaseHare) != 0;
+	mRandomDisorder = state.disorder;
+	mPupTourTimer = state.tourTimer;
+	mFat = state.fat;
+	mCorpseTimer = state.corpseTimer;
+	mTargetHare = state.target;
+
+	// Last move isn't saved, a replayed move plays the idle clip
+	mCurrentIdle = min<uint32_t>(state.idle, mAnimations.size() - 1);
+	mCurrentAnimation = mCurrentIdle;
 }
 
 void WolfFemale::pup(Board& board)
@@ -283,7 +278,7 @@ void WolfFemale::pup(Board& board)
 	if (mPupTourTimer == 0)
 	{
 		board.spawnWolf(mPos);
-		mPupTourTimer = pupTourTime;
+		mPupTourTimer = board.getParameters().pupTourTime;
 	}
 }
 
@@ -11,36 +11,35 @@ class WolfFemale : public GameObject
 {
 public:
 	WolfFemale();
-	WolfFemale(std::shared_ptr<class SpriteSheet> spriteSheet);
-	void create(std::shared_ptr<class SpriteSheet> spriteSheet);
+	WolfFemale(std::shared_ptr<class SpriteSheet> spriteSheet, class Board& board);
+	void create(std::shared_ptr<class SpriteSheet> spriteSheet, class Board& board);
 
 	~WolfFemale();
 	
-	const glm::vec2& getRealPos();
-
-	void draw(class Renderer& renderer) const override;
+	void draw(class AnimatedObjectLayer& layer) const override;
 
 	void updateMove(class Board& board) override;
 	void updateAction(class Board& board) override;
 	void update(float deltaTime) override;
 	void setPos(const glm::tvec2<std::int32_t>& pos);
+	void saveState(ObjectState& state) const override;
+	void loadState(const ObjectState& state) override;
 	void pup(class Board& board);
 	bool canPup();
 
 private:
-	glm::vec2 mRealPos;
 	glm::vec2 mRandomDisorder;
 
 	// Animations
 	std::array<FlipbookAnimation, 10> mAnimations;
 	std::uint32_t mCurrentAnimation;
 	std::uint32_t mCurrentIdle;
-	glm::vec2 mTransitionStartPos;
-	float mTransitionTimer;
+	float mTransitionTime;
 	float mCorpseTimer;
 
 	// Logic
 	bool mChaseHare;
+	EntityHandle mTargetHare;
 	float mFat;
 	std::uint32_t mPupTourTimer;
 };
@@ -3,35 +3,33 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/vec3.hpp>
 #include "Renderer.hpp"
+#include "AnimatedObjectLayer.hpp"
 #include "Application.hpp"
 #include "Board.hpp"
 #include "Hare.hpp"
 #include "WolfFemale.hpp"
 using namespace std;
 
-static const float transitionTime{ 1.0f };
 static const string objectType{ "wolf_male" };
-static const uint32_t mateTourTime{ 5 };
-static const float fatLoss{ 0.05f };
 static const float corpseTime{ 5.0f };
 
 
 WolfMale::WolfMale()
-	: GameObject{}, mTransitionTimer { 1.0f }, mChaseHare{ false }, mFat{ 1.0f }, 
-	mMateTourTimer{ mateTourTime }, mCorpseTimer{ corpseTime }
+	: GameObject{}, mTransitionTime{ 1.0f }, mChaseHare{ false }, mFat{ 1.0f }, 
+	mMateTourTimer{ 0 }, mCorpseTimer{ corpseTime }
 {
 	mType = objectType;
 }
 
-WolfMale::WolfMale(shared_ptr<SpriteSheet> spriteSheet)
-	: GameObject{}, mTransitionTimer { 1.0f }, mChaseHare{ false }, mFat{ 1.0f }, 
-	mMateTourTimer{ mateTourTime }, mCorpseTimer{ corpseTime }
+WolfMale::WolfMale(shared_ptr<SpriteSheet> spriteSheet, Board& board)
+	: GameObject{}, mTransitionTime{ 1.0f }, mChaseHare{ false }, mFat{ 1.0f }, 
+	mMateTourTimer{ 0 }, mCorpseTimer{ corpseTime }
 {
 	mType = objectType;
-	create(spriteSheet);
+	create(spriteSheet, board);
 }
 
-void WolfMale::create(shared_ptr<SpriteSheet> spriteSheet)
+void WolfMale::create(shared_ptr<SpriteSheet> spriteSheet, Board& board)
 {
 	// Move forward
 	mAnimations[0].create(spriteSheet, { 0, 1 }, 0.5);
@@ -66,7 +64,15 @@ void WolfMale::create(shared_ptr<SpriteSheet> spriteSheet)
 
 	mCurrentAnimation = 4;
 	mCurrentIdle = 4;
-	mAnimations[4].start();
+
+	auto& parameters = board.getParameters();
+	mTransitionTime = parameters.wolfTransitionTime;
+	mMateTourTimer = parameters.mateTourTime;
+
+	// Objects are created during turns, so draws come from the turn's stream
+	float disorder = Application::spriteSize / 4.0f;
+	mRandomDisorder = glm::vec2{ board.getRandom().nextReal() * disorder - disorder,
+		board.getRandom().nextReal() * disorder };
 
 	mActive = true;
 }
@@ -76,126 +82,102 @@ WolfMale::~WolfMale()
 }
 
 
-const glm::vec2& WolfMale::getRealPos()
+void WolfMale::draw(AnimatedObjectLayer& layer) const
 {
-	return mRealPos;
-}
+	// Objects move from positions saved at the start of the turn, corpses stay where they died
+	auto to = glm::vec2{ mPos } * Application::spriteSize + mRandomDisorder;
+	auto from = mActive ? glm::vec2{ mSavedPos } * Application::spriteSize + mRandomDisorder : to;
+	auto move = from != to ? mCurrentAnimation : mCurrentIdle;
 
-void WolfMale::draw(Renderer& renderer) const
-{
-	auto pos = mRealPos + mRandomDisorder;
-
-	renderer.prepareDrawSprite();
-	renderer.drawSprite(*(mAnimations[mCurrentAnimation].getCurrentSprite().lock()), 
-		glm::translate(glm::vec3{ pos.x, pos.y, 0.0f }));
+	layer.add(mAnimations[move], mAnimations[mCurrentIdle], from, to, mTransitionTime);
 }
 
 void WolfMale::updateMove(Board& board)
 {
-	glm::tvec2<int32_t> maxPos{ board.getWidth() - 1, board.getHeight() - 1 };
-	auto surrObjects{ board.getSurroundingObjects(mPos) };
-	vector<glm::tvec2<int32_t>> movePosVec;
-	int harePos = -1;
-	int wolfFemalePos = -1;
+	auto neighbourhood = board.getNeighbourhood(mPos);
+	auto blocked = neighbourhood.boulders | neighbourhood.bushes;
+	auto passable = neighbourhood.inside & ~blocked;
 
-	for (int i = -1; i <= 1; i++)
-	{
-		for (int j = -1; j <= 1; j++)
-		{
-			auto movePos{ mPos + glm::tvec2<int32_t>{i, j} };
-
-
-			if (movePos.x < 0 || movePos.y < 0 || movePos.x > maxPos.x || movePos.y > maxPos.y)
-				continue;
+	// Can't move.
+	if (passable == 0)
+		return;
 
-			bool canMove = true;
+	// Cells are scanned in order, a blocked cell makes the wolf forget what it saw before
+	auto seen = passable & Neighbourhood::GetCellsAfter(Neighbourhood::GetLast(blocked));
+	auto hareCell = Neighbourhood::GetLast(neighbourhood.hares & seen);
+	auto wolfFemaleCell = mMateTourTimer == 0 ?
+		Neighbourhood::GetLast(neighbourhood.females & seen) : -1;
+
+	// Hares out of sight are chased along the flow field, neighbours keep the rules above
+	auto pursuitRange = board.getParameters().pursuitRange;
+	auto hareDistance = pursuitRange > 0 && board.isHareFieldCurrent() ?
+		board.getHareField().getDistance(mPos) : FlowField::unreachable;
+	bool pursue = hareDistance > 1 && hareDistance <= pursuitRange;
+
+	// Hare which escaped the last chase is followed while it's in pursuit range
+	int32_t targetCell = -1;
+	auto target = board.getObject(mTargetHare);
+
+	if (!target || !target->isActive())
+		mTargetHare = EntityHandle{};
+	else if (pursuitRange > 0)
+	{
+		auto offset = target->getSavedPos() - mPos;
 
-			for (auto& obj : surrObjects)
-			{
-				if (obj->getSavedPos() == movePos)
-				{
-					if (obj->getObjectType() == "boulder" || obj->getObjectType() == "bush")
-					{
-						canMove = false;
-						harePos = -1;
-						wolfFemalePos = -1;
-						break;
-					}
-					else if (obj->getObjectType() == "hare")
-						harePos = movePosVec.size();
-					else if (mMateTourTimer == 0 && obj->getObjectType() == "wolf_female")
-					{
-						if (dynamic_pointer_cast<WolfFemale>(obj)->canPup())
-							wolfFemalePos = movePosVec.size();
-					}					
-				}
-			}
+		if (static_cast<uint32_t>(max(abs(offset.x), abs(offset.y))) <= pursuitRange)
+		{
+			auto cell = Neighbourhood::GetCell({ (offset.x > 0) - (offset.x < 0),
+				(offset.y > 0) - (offset.y < 0) });
 
-			if (canMove)
-				movePosVec.push_back(movePos);
+			if (passable & (1 << cell))
+				targetCell = cell;
 		}
 	}
 
-	// Can't move.
-	if (movePosVec.size() == 0)
-		return;
-
-	uniform_int_distribution<int32_t> dist{ 0, static_cast<int32_t>(movePosVec.size() - 1) };
-
-
-	mTransitionStartPos = glm::vec2{ mPos.x * Application::spriteSize, 
-		mPos.y * Application::spriteSize };
-	mTransitionTimer = 0.0f;
 
 	glm::tvec2<int32_t> newPos;
 
-	if (harePos != -1)
+	if (hareCell != -1)
 	{
-		newPos = movePosVec.at(harePos);
+		newPos = mPos + Neighbourhood::GetOffset(hareCell);
 		mChaseHare = true;
+		mTargetHare = neighbourhood.hareHandles[hareCell];
 	}
+	else if (wolfFemaleCell != -1)
+		newPos = mPos + Neighbourhood::GetOffset(wolfFemaleCell);
+	else if (targetCell != -1)
+		newPos = mPos + Neighbourhood::GetOffset(targetCell);
+	else if (pursue)
+		newPos = mPos + board.getHareField().getStep(mPos);
 	else
-		newPos = movePosVec.at(wolfFemalePos != -1 ? wolfFemalePos : dist(Application::randomDev));
+		newPos = mPos + Neighbourhood::GetOffset(Neighbourhood::Select(passable,
+			board.getRandom().next(Neighbourhood::GetCount(passable))));
 
 	// Avoid animation change
 	if (newPos == mPos)
 		return;
 
-	mPos = newPos;
-
 	// Animation controling
-	auto direction = glm::vec2{ mPos.x * Application::spriteSize, 
-		mPos.y * Application::spriteSize } - mTransitionStartPos;
+	auto direction = newPos - mPos;
+	mPos = newPos;
 	
-	if (direction.x < 0.0f)
+	if (direction.x < 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[2].reset();
-		mAnimations[2].start();
 		mCurrentAnimation = 2;
 		mCurrentIdle = 6;
 	}
-	else if (direction.x > 0.0f)
+	else if (direction.x > 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[3].reset();
-		mAnimations[3].start();
 		mCurrentAnimation = 3;
 		mCurrentIdle = 7;
 	}
-	else if (direction.y < 0.0f)
+	else if (direction.y < 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[0].reset();
-		mAnimations[0].start();
 		mCurrentAnimation = 0;
 		mCurrentIdle = 4;
 	}
-	else if (direction.y > 0.0f)
+	else if (direction.y > 0)
 	{
-		mAnimations[mCurrentAnimation].stop();
-		mAnimations[1].reset();
-		mAnimations[1].start();
 		mCurrentAnimation = 1;
 		mCurrentIdle = 5;
 	}
@@ -203,18 +185,22 @@ void WolfMale::updateMove(Board& board)
 
 void WolfMale::updateAction(Board& board)
 {
-	shared_ptr<Hare> hare;
-	shared_ptr<WolfFemale> wolfFemale;
+	Hare* hare = nullptr;
+	WolfFemale* wolfFemale = nullptr;
+	float fatLoss = board.getParameters().fatLoss;
 
-	for (auto& obj : board.getObjects(mPos))
+	for (auto handle : board.getObjects(mPos))
 	{
+		auto obj = board.getObject(handle);
+
 		if (obj->getObjectType() == "hare")
 		{
-			hare = dynamic_pointer_cast<Hare>(obj);
+			hare = dynamic_cast<Hare*>(obj);
 			if (!hare->isEaten())
 			{
 				hare->setEaten(true);
 				mChaseHare = false;
+				mTargetHare = EntityHandle{};
 				mFat = 1.0f;
 				mCurrentIdle = 8;
 			}
@@ -222,15 +208,25 @@ void WolfMale::updateAction(Board& board)
 		else if (mChaseHare)
 			mFat -= fatLoss;
 		else if (obj->getObjectType() == "wolf_female")
-			wolfFemale = dynamic_pointer_cast<WolfFemale>(obj);
+			wolfFemale = dynamic_cast<WolfFemale*>(obj);
+	}
+
+	bool countedHare = !hare && board.eatCountedHare(mPos);
+
+	if (countedHare)
+	{
+		mChaseHare = false;
+		mTargetHare = EntityHandle{};
+		mFat = 1.0f;
+		mCurrentIdle = 8;
 	}
 
 	mFat -= fatLoss;
 
-	if (!hare && wolfFemale)
+	if (!hare && !countedHare && wolfFemale)
 	{
 		wolfFemale->pup(board);
-		mMateTourTimer = mateTourTime;
+		mMateTourTimer = board.getParameters().mateTourTime;
 	}
 
 	if (mFat <= 0.0f)
@@ -248,49 +244,45 @@ void WolfMale::updateAction(Board& board)
 void WolfMale::update(float deltaTime)
 {
 	if (mActive)
-	{
-		if (mTransitionTimer < transitionTime)
-		{
-			glm::vec2 transitionEndPos{ mPos.x * Application::spriteSize,
-				mPos.y * Application::spriteSize };
-
-			mRealPos = glm::mix(mTransitionStartPos, transitionEndPos,
-				mTransitionTimer / transitionTime);
-
-			mTransitionTimer += deltaTime;
-
-			if (mTransitionTimer >= transitionTime)
-			{
-				mAnimations[mCurrentAnimation].stop();
-				mAnimations[mCurrentIdle].start();
-				mCurrentAnimation = mCurrentIdle;
-			}
-		}
-	}
-	else
-	{
-		if (mCurrentAnimation != mCurrentIdle)
-		{
-			mAnimations[mCurrentAnimation].stop();
-			mAnimations[mCurrentIdle].start();
-			mCurrentAnimation = mCurrentIdle;
-		}
-
-		if (mCorpseTimer <= 0.0f)
-			mReadyToDelete = true;
+		return;
 
-		mCorpseTimer -= deltaTime;
-	}
+	if (mCorpseTimer <= 0.0f)
+		mReadyToDelete = true;
 
-	mAnimations[mCurrentAnimation].update(deltaTime);
+	mCorpseTimer -= deltaTime;
 }
 
 void WolfMale::setPos(const glm::tvec2<std::int32_t>& pos)
 {
 	mPos = pos;
-	mRealPos = glm::vec2{ pos.x * Application::spriteSize, pos.y * Application::spriteSize };
 
-	uniform_real_distribution<float> dist{ 0.0f, Application::spriteSize / 4.0f };
-	mRandomDisorder = glm::vec2{ dist(Application::randomDev) - Application::spriteSize / 4.0f, 
-		dist(Application::randomDev) };
+	// Placed objects rest until their next move
+	mSavedPos = pos;
+}
+
+void WolfMale::saveState(ObjectState& state) const
+{
+	GameObject::saveState(state);
+	state.flags |= mChaseHare ? ObjectState::chaseHare : 0;
+	state.disorder = mRandomDisorder;
+	state.idle = mCurrentIdle;
+	state.tourTimer = mMateTourTimer;
+	state.fat = mFat;
+	state.corpseTimer = mCorpseTimer;
+	state.target = mTargetHare;
+}
+
+void WolfMale::loadState(const ObjectState& state)
+{
+	GameObject::loadState(state);
+	mChaseHare = (state.flags & ObjectState::chaseHare) != 0;
+	mRandomDisorder = state.disorder;
+	mMateTourTimer = state.tourTimer;
+	mFat = state.fat;
+	mCorpseTimer = state.corpseTimer;
+	mTargetHare = state.target;
+
+	// Last move isn't saved, a replayed move plays the idle clip
+	mCurrentIdle = min<uint32_t>(state.idle, mAnimations.size() - 1);
+	mCurrentAnimation = mCurrentIdle;
 }
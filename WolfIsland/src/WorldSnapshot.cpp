@@ -0,0 +1,360 @@
+#include "WorldSnapshot.hpp"
+#include "Board.hpp"
+using namespace std;
+
+// Object types in the order of object counters, records store the index + 1
+static const size_t objectTypesCount{ 5 };
+
+
+// Values of saved states, vectors and arrays are prefixed with their size
+template<typename T>
+static void WriteState(vector<uint8_t>& state, const T* values, size_t count)
+{
+	auto bytes = reinterpret_cast<const uint8_t*>(values);
+	state.insert(end(state), bytes, bytes + count * sizeof(T));
+}
+
+template<typename T>
+static void WriteState(vector<uint8_t>& state, const T& value)
+{
+	WriteState(state, &value, 1);
+}
+
+template<typename T>
+static void WriteState(vector<uint8_t>& state, const vector<T>& values)
+{
+	WriteState(state, static_cast<uint32_t>(values.size()));
+	WriteState(state, values.data(), values.size());
+}
+
+template<typename T>
+static void WriteState(vector<uint8_t>& state, const ChunkedArray<T>& values)
+{
+	WriteState(state, static_cast<uint32_t>(values.size()));
+
+	for (size_t i = 0; i < values.getChunksCount(); i++)
+		WriteState(state, values.getChunk(i).data(), values.getChunk(i).size());
+}
+
+// Reads values of a saved state in the order they were written
+class StateReader
+{
+public:
+	StateReader(const vector<uint8_t>& state)
+		: mState(state), mPos{ 0 }
+	{
+	}
+
+	template<typename T>
+	void read(T* values, size_t count)
+	{
+		if (count > (mState.size() - mPos) / sizeof(T))
+			throw BoardStateException();
+
+		copy_n(mState.data() + mPos, count * sizeof(T), reinterpret_cast<uint8_t*>(values));
+		mPos += count * sizeof(T);
+	}
+
+	template<typename T>
+	void read(T& value)
+	{
+		read(&value, 1);
+	}
+
+	template<typename T>
+	void read(vector<T>& values)
+	{
+		uint32_t size;
+		read(size);
+
+		if (size > (mState.size() - mPos) / sizeof(T))
+			throw BoardStateException();
+
+		values.resize(size);
+		read(values.data(), size);
+	}
+
+	template<typename T>
+	void read(ChunkedArray<T>& values)
+	{
+		vector<T> contiguous;
+		read(contiguous);
+		values = ChunkedArray<T>{ contiguous.data(), contiguous.size() };
+	}
+
+	bool isFinished() const
+	{
+		return mPos == mState.size();
+	}
+
+private:
+	const vector<uint8_t>& mState;
+	size_t mPos;
+};
+
+// Calls count(chunk, first, sign) with sign 1 for chunks of values which aren't shared with
+// the previous array, and with -1 for the chunks of the previous array they replaced
+template<typename T, typename Count>
+static void CountChunks(const ChunkedArray<T>& values, const ChunkedArray<T>& previous,
+	Count count)
+{
+	for (size_t i = 0; i < max(values.getChunksCount(), previous.getChunksCount()); i++)
+	{
+		if (values.isChunkShared(i, previous))
+			continue;
+
+		if (i < previous.getChunksCount())
+			count(previous.getChunk(i), i * ChunkedArray<T>::chunkSize, -1);
+
+		if (i < values.getChunksCount())
+			count(values.getChunk(i), i * ChunkedArray<T>::chunkSize, 1);
+	}
+}
+
+
+WorldSnapshot::WorldSnapshot()
+	: mWidth{ 0 }, mHeight{ 0 }, mTurn{ 0 }, mHareEngine{ HareEngine::AGENTS },
+	mMeanFieldEnabled{ false }, mRandomSeed{ 0 }, mRandomCounter{ 0 }, mObjectsAdded{ 0 },
+	mObjectCounters{ 0, 0, 0, 0, 0 }, mCountedHares{ 0 }
+{
+}
+
+WorldSnapshot::~WorldSnapshot()
+{
+}
+
+uint32_t WorldSnapshot::getWidth() const
+{
+	return mWidth;
+}
+
+uint32_t WorldSnapshot::getHeight() const
+{
+	return mHeight;
+}
+
+uint32_t WorldSnapshot::getTurn() const
+{
+	return mTurn;
+}
+
+HareEngine WorldSnapshot::getHareEngine() const
+{
+	return mHareEngine;
+}
+
+bool WorldSnapshot::isMeanFieldEnabled() const
+{
+	return mMeanFieldEnabled;
+}
+
+const ChunkedArray<ObjectState>& WorldSnapshot::getObjects() const
+{
+	return mObjects;
+}
+
+const array<int32_t, 5>& WorldSnapshot::getObjectCounters() const
+{
+	return mObjectCounters;
+}
+
+const ChunkedArray<float>& WorldSnapshot::getVegetation() const
+{
+	return mVegetation;
+}
+
+uint32_t WorldSnapshot::getHareCount(const glm::tvec2<int32_t>& pos) const
+{
+	if (pos.x < 0 || pos.y < 0 || pos.x >= static_cast<int32_t>(mWidth) ||
+		pos.y >= static_cast<int32_t>(mHeight))
+		return 0;
+
+	uint32_t count{ 0 };
+
+	if (mHareCounts.size() == static_cast<size_t>(mWidth) * mHeight)
+		count += mHareCounts[pos.y * mWidth + pos.x];
+
+	// Occupancy plane follows the random state
+	size_t rowWords = (mWidth + 63) / 64;
+
+	if (mAutomaton.size() > rowWords * mHeight)
+		count += (mAutomaton[1 + pos.y * rowWords + pos.x / 64] >> (pos.x % 64)) & 1;
+
+	return count;
+}
+
+uint64_t WorldSnapshot::getCountedHares() const
+{
+	return mCountedHares;
+}
+
+void WorldSnapshot::getHareCountChanges(const WorldSnapshot& previous,
+	vector<glm::tvec2<int32_t>>& cells) const
+{
+	auto chunkSize = ChunkedArray<uint32_t>::chunkSize;
+	bool sameCounts = mHareCounts.size() == previous.mHareCounts.size();
+
+	for (size_t i = 0; i < mHareCounts.getChunksCount(); i++)
+	{
+		if (mHareCounts.isChunkShared(i, previous.mHareCounts))
+			continue;
+
+		for (size_t c = i * chunkSize; c < min((i + 1) * chunkSize, mHareCounts.size()); c++)
+		{
+			if (!sameCounts || mHareCounts[c] != previous.mHareCounts[c])
+				cells.push_back({ c % mWidth, c / mWidth });
+		}
+	}
+
+	// Occupancy plane follows the random state, cells of differing bits are added
+	size_t rowWords = (mWidth + 63) / 64;
+	size_t occupiedLast = min(mAutomaton.size(), 1 + rowWords * mHeight);
+	bool sameAutomaton = mAutomaton.size() == previous.mAutomaton.size();
+	chunkSize = ChunkedArray<uint64_t>::chunkSize;
+
+	for (size_t i = 0; i < mAutomaton.getChunksCount(); i++)
+	{
+		if (mAutomaton.isChunkShared(i, previous.mAutomaton))
+			continue;
+
+		for (size_t w = max(i * chunkSize, size_t{ 1 }); w < min((i + 1) * chunkSize, occupiedLast);
+			w++)
+		{
+			auto changed = sameAutomaton ? mAutomaton[w] ^ previous.mAutomaton[w] : ~0ull;
+			auto y = static_cast<int32_t>((w - 1) / rowWords);
+			auto x = static_cast<int32_t>((w - 1) % rowWords * 64);
+
+			for (; changed != 0; changed &= changed - 1)
+			{
+				// Index of the lowest set bit
+				int32_t bit{ 0 };
+
+				while (((changed >> bit) & 1) == 0)
+					bit++;
+
+				if (x + bit < static_cast<int32_t>(mWidth))
+					cells.push_back({ x + bit, y });
+			}
+		}
+	}
+}
+
+void WorldSnapshot::saveState(vector<uint8_t>& state) const
+{
+	state.clear();
+
+	// Fields have fixed sizes, they keep their places from turn to turn
+	WriteState(state, mWidth);
+	WriteState(state, mHeight);
+	WriteState(state, mTurn);
+	WriteState(state, static_cast<uint32_t>(mHareEngine));
+	WriteState(state, static_cast<uint32_t>(mMeanFieldEnabled ? 1 : 0));
+	WriteState(state, mRandomSeed);
+	WriteState(state, mRandomCounter);
+	WriteState(state, mObjectsAdded);
+	WriteState(state, mVegetation);
+	WriteState(state, mHareCounts);
+	WriteState(state, mCountedRegions);
+	WriteState(state, mAutomaton);
+	WriteState(state, mObjects);
+
+	// Lists changing their length come last
+	WriteState(state, mFreeSlots);
+	WriteState(state, mWolfSpawns);
+	WriteState(state, mHareSpawns);
+}
+
+void WorldSnapshot::loadState(const vector<uint8_t>& state)
+{
+	StateReader reader{ state };
+	uint32_t hareEngine, meanField;
+
+	reader.read(mWidth);
+	reader.read(mHeight);
+	reader.read(mTurn);
+	reader.read(hareEngine);
+	reader.read(meanField);
+	reader.read(mRandomSeed);
+	reader.read(mRandomCounter);
+	reader.read(mObjectsAdded);
+	reader.read(mVegetation);
+	reader.read(mHareCounts);
+	reader.read(mCountedRegions);
+	reader.read(mAutomaton);
+	reader.read(mObjects);
+	reader.read(mFreeSlots);
+	reader.read(mWolfSpawns);
+	reader.read(mHareSpawns);
+
+	bool valid = reader.isFinished() && hareEngine <= static_cast<uint32_t>(HareEngine::AUTOMATON);
+
+	for (size_t slot = 0; slot < mObjects.size(); slot++)
+		valid = valid && mObjects[slot].type <= objectTypesCount;
+
+	for (auto slot : mFreeSlots)
+		valid = valid && slot < mObjects.size();
+
+	if (!valid)
+		throw BoardStateException();
+
+	mHareEngine = static_cast<HareEngine>(hareEngine);
+	mMeanFieldEnabled = meanField != 0;
+	count(WorldSnapshot{});
+}
+
+size_t WorldSnapshot::getChunksCount() const
+{
+	return mVegetation.getChunksCount() + mHareCounts.getChunksCount() +
+		mCountedRegions.getChunksCount() + mAutomaton.getChunksCount() +
+		mObjects.getChunksCount();
+}
+
+size_t WorldSnapshot::getSharedChunks(const WorldSnapshot& other) const
+{
+	return mVegetation.getSharedChunks(other.mVegetation) +
+		mHareCounts.getSharedChunks(other.mHareCounts) +
+		mCountedRegions.getSharedChunks(other.mCountedRegions) +
+		mAutomaton.getSharedChunks(other.mAutomaton) +
+		mObjects.getSharedChunks(other.mObjects);
+}
+
+void WorldSnapshot::count(const WorldSnapshot& previous)
+{
+	mObjectCounters = previous.mObjectCounters;
+	mCountedHares = previous.mCountedHares;
+
+	CountChunks(mObjects, previous.mObjects,
+		[this](const vector<ObjectState>& records, size_t, int32_t sign)
+		{
+			for (auto& record : records)
+			{
+				if (record.type != 0)
+					mObjectCounters[record.type - 1] += sign;
+			}
+		});
+
+	CountChunks(mHareCounts, previous.mHareCounts,
+		[this](const vector<uint32_t>& counts, size_t, int32_t sign)
+		{
+			auto total = accumulate(begin(counts), end(counts), uint64_t{ 0 });
+			mCountedHares = sign > 0 ? mCountedHares + total : mCountedHares - total;
+		});
+
+	// Occupancy plane follows the random state
+	size_t occupiedLast = 1 + (mWidth + 63) / 64 * mHeight;
+
+	CountChunks(mAutomaton, previous.mAutomaton,
+		[this, occupiedLast](const vector<uint64_t>& words, size_t first, int32_t sign)
+		{
+			uint64_t total{ 0 };
+
+			for (size_t i = max(first, size_t{ 1 }); i < min(first + words.size(), occupiedLast); i++)
+			{
+				for (auto word = words[i - first]; word != 0; word &= word - 1)
+					total++;
+			}
+
+			mCountedHares = sign > 0 ? mCountedHares + total : mCountedHares - total;
+		});
+}
+
@@ -0,0 +1,78 @@
+#pragma once
+#include "Prerequisites.hpp"
+#include "GameObject.hpp"
+#include "HareAutomaton.hpp"
+#include "ChunkedArray.hpp"
+#include <glm/vec2.hpp>
+
+
+// Immutable state of a board between turns, which other threads can read while the board
+// runs the next turn. Fields and objects are chunked arrays, so a snapshot takes memory
+// only for chunks written since the previous one. Snapshots are published by the board.
+class WorldSnapshot
+{
+public:
+	WorldSnapshot();
+	~WorldSnapshot();
+
+	std::uint32_t getWidth() const;
+	std::uint32_t getHeight() const;
+	std::uint32_t getTurn() const;
+	HareEngine getHareEngine() const;
+	bool isMeanFieldEnabled() const;
+
+	// Objects by entity slot, free slots have type 0
+	const ChunkedArray<ObjectState>& getObjects() const;
+	const std::array<std::int32_t, 5>& getObjectCounters() const;
+
+	// Row major food of cells
+	const ChunkedArray<float>& getVegetation() const;
+
+	// Hares without objects, from mean field counts or the automaton
+	std::uint32_t getHareCount(const glm::tvec2<std::int32_t>& pos) const;
+	std::uint64_t getCountedHares() const;
+
+	// Cells whose hares without objects differ from the previous snapshot of the board, only
+	// chunks which aren't shared are compared
+	void getHareCountChanges(const WorldSnapshot& previous,
+		std::vector<glm::tvec2<std::int32_t>>& cells) const;
+
+	// Bytes of everything later turns depend on. Fields and entity slots have fixed places,
+	// so states of consecutive turns differ in few bytes. Loading throws
+	// BoardStateException for malformed states.
+	void saveState(std::vector<std::uint8_t>& state) const;
+	void loadState(const std::vector<std::uint8_t>& state);
+
+	std::size_t getChunksCount() const;
+	std::size_t getSharedChunks(const WorldSnapshot& other) const;
+
+private:
+	friend class Board;
+
+	std::uint32_t mWidth;
+	std::uint32_t mHeight;
+	std::uint32_t mTurn;
+	HareEngine mHareEngine;
+	bool mMeanFieldEnabled;
+	std::uint32_t mRandomSeed;
+	std::uint64_t mRandomCounter;
+	std::uint32_t mObjectsAdded;
+	std::array<std::int32_t, 5> mObjectCounters;
+	std::uint64_t mCountedHares;
+
+	ChunkedArray<float> mVegetation;
+	ChunkedArray<std::uint32_t> mHareCounts;
+	ChunkedArray<std::uint8_t> mCountedRegions;
+
+	// Random state, occupancy and age planes of the automaton
+	ChunkedArray<std::uint64_t> mAutomaton;
+
+	ChunkedArray<ObjectState> mObjects;
+	std::vector<std::uint32_t> mFreeSlots;
+	std::vector<glm::tvec2<std::int32_t>> mWolfSpawns;
+	std::vector<glm::tvec2<std::int32_t>> mHareSpawns;
+
+	// Counters and counted hares from objects and fields. Only chunks which aren't shared
+	// with the previous snapshot of the board are counted.
+	void count(const WorldSnapshot& previous);
+};
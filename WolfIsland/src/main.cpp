@@ -1,15 +1,446 @@
 #include "Application.hpp"
+#include "EnsembleRunner.hpp"
+#include "ParameterSweep.hpp"
+#include "Board.hpp"
+#include "Timeline.hpp"
 #include <iostream>
 
-#ifdef _DEBUG
-int main(int argc, char** argv)
-#else
-#include <Windows.h>
-int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
-#endif
+// Parses "key=value" arguments
+static std::unordered_map<std::string, std::string> ParseOptions(int argc, char** argv, int first)
+{
+	std::unordered_map<std::string, std::string> options;
+
+	for (int i = first; i < argc; i++)
+	{
+		std::string arg{ argv[i] };
+		auto separator = arg.find('=');
+
+		if (separator != std::string::npos)
+			options[arg.substr(0, separator)] = arg.substr(separator + 1);
+	}
+
+	return options;
+}
+
+static std::uint32_t GetOption(const std::unordered_map<std::string, std::string>& options,
+	const std::string& name, std::uint32_t defaultValue)
+{
+	auto it = options.find(name);
+	return it == options.end() ? defaultValue : std::stoul(it->second);
+}
+
+static std::string GetOption(const std::unordered_map<std::string, std::string>& options,
+	const std::string& name, const std::string& defaultValue)
+{
+	auto it = options.find(name);
+	return it == options.end() ? defaultValue : it->second;
+}
+
+// Species parameters given by name, e.g. splitChance=15 fatLoss=0.04. Unnamed ones are the
+// defaults, which include food and pursuit, or the reference constants of earlier versions
+// with preset=reference.
+static SimulationParameters GetParameters(
+	const std::unordered_map<std::string, std::string>& options)
+{
+	auto parameters = GetOption(options, "preset", std::string{}) == "reference" ?
+		SimulationParameters::GetReference() : SimulationParameters{};
+
+	for (auto& name : SimulationParameters::GetNames())
+	{
+		auto it = options.find(name);
+
+		if (it != options.end())
+			parameters.set(name, std::stod(it->second));
+	}
+
+	return parameters;
+}
+
+static double GetRealOption(const std::unordered_map<std::string, std::string>& options,
+	const std::string& name, double defaultValue)
+{
+	auto it = options.find(name);
+	return it == options.end() ? defaultValue : std::stod(it->second);
+}
+
+// Early termination, e.g. stop=extinction,boom,steady,orbit boomCap=5000 window=50
+//     steadyTolerance=0.05 orbitTolerance=0.3
+static TerminationPolicy GetTermination(
+	const std::unordered_map<std::string, std::string>& options)
+{
+	TerminationPolicy policy;
+	std::istringstream detectors{ GetOption(options, "stop", std::string{}) };
+	std::string detector;
+
+	while (std::getline(detectors, detector, ','))
+	{
+		if (detector == "extinction" || detector == "wolf_extinction")
+			policy.wolfExtinction = true;
+
+		if (detector == "extinction" || detector == "hare_extinction")
+			policy.hareExtinction = true;
+
+		if (detector == "boom")
+			policy.boomCap = GetOption(options, "boomCap", 5000);
+
+		if (detector == "steady")
+			policy.steadyState = true;
+
+		if (detector == "orbit")
+			policy.periodicOrbit = true;
+	}
+
+	policy.window = GetOption(options, "window", policy.window);
+	policy.steadyTolerance = GetRealOption(options, "steadyTolerance", policy.steadyTolerance);
+	policy.orbitTolerance = GetRealOption(options, "orbitTolerance", policy.orbitTolerance);
+
+	return policy;
+}
+
+// Hybrid hares, e.g. hybrid=1 regionSize=8 countDensity=4 agentDensity=1
+static MeanFieldOptions GetMeanField(const std::unordered_map<std::string, std::string>& options)
+{
+	MeanFieldOptions meanField;
+	meanField.enabled = GetOption(options, "hybrid", 0) != 0;
+	meanField.regionSize = GetOption(options, "regionSize", meanField.regionSize);
+	meanField.countDensity = GetRealOption(options, "countDensity", meanField.countDensity);
+	meanField.agentDensity = GetRealOption(options, "agentDensity", meanField.agentDensity);
+
+	return meanField;
+}
+
+// Birth limits, e.g. maxEntities=100000 memoryBudget=512 regionCapacity=2
+static GovernorOptions GetGovernor(const std::unordered_map<std::string, std::string>& options)
+{
+	GovernorOptions governor;
+	governor.maxEntities = GetOption(options, "maxEntities", 0);
+	governor.memoryBudget = GetOption(options, "memoryBudget", 0);
+	governor.regionCapacity = GetRealOption(options, "regionCapacity", 0.0);
+
+	return governor;
+}
+
+// engine=agents|automaton
+static HareEngine GetHareEngine(const std::unordered_map<std::string, std::string>& options)
+{
+	return GetOption(options, "engine", std::string{ "agents" }) == "automaton" ?
+		HareEngine::AUTOMATON : HareEngine::AGENTS;
+}
+
+// Island setup shared by the headless modes
+static EnsembleRun GetRunSetup(const std::unordered_map<std::string, std::string>& options)
+{
+	EnsembleRun run;
+	run.width = GetOption(options, "width", 30);
+	run.height = GetOption(options, "height", 30);
+	run.wolves = GetOption(options, "wolves", 10);
+	run.hares = GetOption(options, "hares", 40);
+	run.turns = GetOption(options, "turns", 200);
+	run.seed = GetOption(options, "seed", 1);
+	run.parameters = GetParameters(options);
+	run.termination = GetTermination(options);
+	run.meanField = GetMeanField(options);
+	run.hareEngine = GetHareEngine(options);
+	run.governor = GetGovernor(options);
+
+	return run;
+}
+
+// Headless Monte Carlo mode:
+// --ensemble runs=1000 width=30 height=30 wolves=10 hares=40 turns=200 seed=1 threads=0
+//     out=ensemble.csv journal=ensemble.journal [jobs=file] [parameter=value...] [stop=...]
+//     [preset=reference] [hybrid=1...] [engine=automaton] [maxEntities=N memoryBudget=MB regionCapacity=N]
+// Every line of the jobs file is "width height wolves hares turns seed" and overrides
+// the generated runs.
+static void RunEnsemble(const std::unordered_map<std::string, std::string>& options)
+{
+	std::vector<EnsembleRun> runs;
+	auto jobsPath = GetOption(options, "jobs", std::string{});
+
+	if (!jobsPath.empty())
+	{
+		std::ifstream jobs{ jobsPath };
+		EnsembleRun run;
+		run.parameters = GetParameters(options);
+		run.termination = GetTermination(options);
+		run.meanField = GetMeanField(options);
+		run.hareEngine = GetHareEngine(options);
+		run.governor = GetGovernor(options);
+
+		while (jobs >> run.width >> run.height >> run.wolves >> run.hares >> run.turns >> run.seed)
+			runs.push_back(run);
+	}
+	else
+	{
+		auto run = GetRunSetup(options);
+		auto seed = run.seed;
+		auto count = GetOption(options, "runs", 100);
+
+		for (std::uint32_t i = 0; i < count; i++)
+		{
+			run.seed = seed + i;
+			runs.push_back(run);
+		}
+	}
+
+	EnsembleRunner runner{ runs, GetOption(options, "threads", 0),
+		GetOption(options, "journal", std::string{ "ensemble.journal" }) };
+	runner.run(std::cout);
+
+	std::ofstream output{ GetOption(options, "out", std::string{ "ensemble.csv" }) };
+	runner.writeStatistics(output);
+}
+
+// Parameter sweep mode:
+// --sweep params=splitChance:5:20:4,fatLoss:0.02:0.1:5 sampling=grid replicates=10
+//     width=30 height=30 wolves=10 hares=40 turns=200 seed=1 threads=0 out=sweep.csv [stop=...]
+//     [preset=reference]
+// Every swept parameter is "name:min:max:steps". Latin hypercube sampling (sampling=lhs)
+// ignores steps and takes samples=N points instead.
+static void RunSweep(const std::unordered_map<std::string, std::string>& options)
+{
+	std::vector<SweepDimension> dimensions;
+	std::istringstream params{ GetOption(options, "params", std::string{}) };
+	std::string param;
+
+	while (std::getline(params, param, ','))
+	{
+		std::istringstream fields{ param };
+		SweepDimension dimension;
+		std::string min, max, steps{ "1" };
+
+		std::getline(fields, dimension.name, ':');
+		std::getline(fields, min, ':');
+		std::getline(fields, max, ':');
+		std::getline(fields, steps, ':');
+
+		dimension.min = std::stod(min);
+		dimension.max = max.empty() ? dimension.min : std::stod(max);
+		dimension.steps = std::stoul(steps);
+		dimensions.push_back(dimension);
+	}
+
+	auto sampling = GetOption(options, "sampling", std::string{ "grid" }) == "lhs" ?
+		SweepSampling::LATIN_HYPERCUBE : SweepSampling::GRID;
+
+	ParameterSweep sweep{ GetRunSetup(options), dimensions, sampling,
+		GetOption(options, "samples", 16), GetOption(options, "replicates", 10),
+		GetOption(options, "threads", 0) };
+	sweep.run(std::cout);
+
+	std::ofstream output{ GetOption(options, "out", std::string{ "sweep.csv" }) };
+	sweep.writeResults(output);
+}
+
+// Compares hare engines on a board with hares only and finds the density at which the
+// automaton gets faster than agents:
+// --hare-benchmark width=4096 height=4096 hares=20000 turns=5 seed=1 [parameter=value...]
+static void RunHareBenchmark(const std::unordered_map<std::string, std::string>& options)
+{
+	auto width = GetOption(options, "width", 4096);
+	auto height = GetOption(options, "height", 4096);
+	auto hares = GetOption(options, "hares", 20000);
+	auto turns = GetOption(options, "turns", 5);
+	auto seed = GetOption(options, "seed", 1);
+	auto cells = width * height;
+
+	// The automaton has no food and flow field, so engines are compared with the reference
+	// constants unless another preset or parameters are given
+	auto benchmarkOptions = options;
+	benchmarkOptions.emplace("preset", "reference");
+	auto parameters = GetParameters(benchmarkOptions);
+
+	// Milliseconds per turn of the engine starting with the hares
+	auto measure = [&](HareEngine engine, std::uint32_t count)
+	{
+		Board board{ width, height, seed };
+		board.setParameters(parameters);
+		board.setHareEngine(engine);
+
+		std::uniform_int_distribution<std::int32_t> distWidth{ 0,
+			static_cast<std::int32_t>(width) - 1 };
+		std::uniform_int_distribution<std::int32_t> distHeight{ 0,
+			static_cast<std::int32_t>(height) - 1 };
+
+		for (std::uint32_t i = 0; i < count; i++)
+			board.addHare({ distWidth(board.getRandomEngine()), distHeight(board.getRandomEngine()) });
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (std::uint32_t turn = 0; turn < turns; turn++)
+			board.updateTurn();
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		double turnMs = elapsed.count() / std::max(turns, 1u);
+
+		std::cout << (engine == HareEngine::AGENTS ? "agents" : "automaton") << " "
+			<< width << "x" << height << " with " << count << " hares: " << turnMs
+			<< " ms/turn, hares " << board.getObjectCounters()[2] + board.getCountedHares()
+			<< std::endl;
+
+		return turnMs;
+	};
+
+	// Agents cost grows with hares while the automaton cost depends mostly on the board, so
+	// hares are doubled or halved until the faster engine changes
+	auto count = std::min(hares, cells);
+	double lead = measure(HareEngine::AGENTS, count) - measure(HareEngine::AUTOMATON, count);
+	bool agentsFaster = lead < 0.0;
+
+	while (true)
+	{
+		auto next = agentsFaster ? std::min(count * 2, cells) : count / 2;
+
+		if (next == count || next == 0)
+		{
+			std::cout << "automaton is " << (agentsFaster ? "slower" : "faster")
+				<< " at every density up to " << static_cast<double>(count) / cells
+				<< " hares per cell" << std::endl;
+			break;
+		}
+
+		double nextLead = measure(HareEngine::AGENTS, next) - measure(HareEngine::AUTOMATON, next);
+
+		if ((nextLead < 0.0) != agentsFaster)
+		{
+			// Costs are taken as linear in hares between the two counts
+			double crossing = count + (static_cast<double>(next) - count) * lead / (lead - nextLead);
+
+			std::cout << "automaton overtakes agents at " << crossing / cells
+				<< " hares per cell, " << static_cast<std::uint64_t>(crossing) << " hares"
+				<< std::endl;
+			break;
+		}
+
+		count = next;
+		lead = nextLead;
+	}
+}
+
+// Runs a headless island keeping its recent turns and reads commands from the input:
+// --timeline width=30 height=30 wolves=10 hares=40 turns=200 seed=1 keyframes=16
+//     timelineBudget=256 [parameter=value...] [hybrid=1...] [engine=automaton]
+// "back N" and "forward N" step through kept turns, "turn N" shows one, "run N" continues
+// from the shown turn and replaces the kept turns after it, "quit" ends.
+static void RunTimeline(const std::unordered_map<std::string, std::string>& options)
+{
+	auto setup = GetRunSetup(options);
+	TimelineOptions timelineOptions;
+	timelineOptions.keyframeInterval = GetOption(options, "keyframes",
+		timelineOptions.keyframeInterval);
+	timelineOptions.memoryBudget = GetOption(options, "timelineBudget",
+		timelineOptions.memoryBudget);
+
+	JobSystem jobs{ JobSystem::GetDefaultWorkers() };
+	Timeline timeline{ timelineOptions, &jobs };
+	Board board{ setup.width, setup.height, setup.seed };
+	board.setParameters(setup.parameters);
+	board.setMeanField(setup.meanField);
+	board.setHareEngine(setup.hareEngine);
+	board.setGovernor(setup.governor);
+
+	std::uniform_int_distribution<std::int32_t> distWidth{ 0,
+		static_cast<std::int32_t>(setup.width) - 1 };
+	std::uniform_int_distribution<std::int32_t> distHeight{ 0,
+		static_cast<std::int32_t>(setup.height) - 1 };
+
+	for (std::uint32_t i = 0; i < setup.wolves; i++)
+		board.addWolf({ distWidth(board.getRandomEngine()), distHeight(board.getRandomEngine()) });
+
+	for (std::uint32_t i = 0; i < setup.hares; i++)
+		board.addHare({ distWidth(board.getRandomEngine()), distHeight(board.getRandomEngine()) });
+
+	auto runTurns = [&board, &timeline](std::int64_t turns)
+	{
+		for (std::int64_t turn = 0; turn < turns; turn++)
+		{
+			board.updateTurn();
+			timeline.capture(board.publishSnapshot());
+		}
+	};
+
+	auto print = [&board, &timeline]()
+	{
+		auto& counters = board.getObjectCounters();
+
+		std::cout << "turn " << board.getTurn() << ": wolves " << counters[0] + counters[1]
+			<< ", hares " << counters[2] + board.getCountedHares() << ", kept turns "
+			<< timeline.getFirstTurn() << "-" << timeline.getLastTurn() << " in "
+			<< timeline.getMemoryUsage() / 1024 << " KiB" << std::endl;
+	};
+
+	timeline.capture(board.publishSnapshot());
+	runTurns(setup.turns);
+	print();
+
+	std::string line;
+
+	while (std::getline(std::cin, line))
+	{
+		std::istringstream fields{ line };
+		std::string command;
+		std::int64_t count;
+		fields >> command;
+
+		if (!(fields >> count))
+			count = 1;
+
+		std::int64_t turn = board.getTurn();
+
+		if (command == "quit")
+			break;
+		else if (command == "back")
+			turn -= count;
+		else if (command == "forward")
+			turn += count;
+		else if (command == "turn")
+			turn = count;
+		else if (command == "run")
+			runTurns(count);
+		else
+		{
+			std::cout << "Commands: back N, forward N, turn N, run N, quit" << std::endl;
+			continue;
+		}
+
+		turn = std::min(std::max(turn, static_cast<std::int64_t>(timeline.getFirstTurn())),
+			static_cast<std::int64_t>(timeline.getLastTurn()));
+
+		if (command != "run" && turn != board.getTurn())
+			timeline.restore(static_cast<std::uint32_t>(turn), board);
+
+		print();
+	}
+}
+
+static int Run(int argc, char** argv)
 {
 	try
 	{
+		if (argc > 1 && std::string{ argv[1] } == "--ensemble")
+		{
+			RunEnsemble(ParseOptions(argc, argv, 2));
+			return 0;
+		}
+
+		if (argc > 1 && std::string{ argv[1] } == "--hare-benchmark")
+		{
+			RunHareBenchmark(ParseOptions(argc, argv, 2));
+			return 0;
+		}
+
+		if (argc > 1 && std::string{ argv[1] } == "--sweep")
+		{
+			RunSweep(ParseOptions(argc, argv, 2));
+			return 0;
+		}
+
+		if (argc > 1 && std::string{ argv[1] } == "--timeline")
+		{
+			RunTimeline(ParseOptions(argc, argv, 2));
+			return 0;
+		}
+
 		Application app{ "Wyspa wilków", { 1024, 768 } };
 		app.run();
 	}
@@ -21,3 +452,16 @@ int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLi
 	return 0;
 }
 
+#ifdef _DEBUG
+int main(int argc, char** argv)
+{
+	return Run(argc, argv);
+}
+#else
+#include <Windows.h>
+int CALLBACK WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow)
+{
+	return Run(__argc, __argv);
+}
+#endif
+